@@ -0,0 +1,547 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: adaptivemap.h
+// DATE: Spring 2022
+// DESC: Size-adaptive implementation of the Map interface. Small maps
+//       are stored in an ArrayMap backed by SmallSeqs, so up to 16
+//       pairs live inside the object, and as the map grows past
+//       the configured thresholds it migrates to a BinSearchMap and
+//       then to an AVLMap. Shrinking migrates back down, but only
+//       once the size falls below half of the threshold so a map
+//       near a boundary does not keep switching.
+//---------------------------------------------------------------------------
+
+#ifndef ADAPTIVEMAP_H
+#define ADAPTIVEMAP_H
+
+#include "map.h"
+#include "arrayseq.h"
+#include "smallseq.h"
+#include "arraymap.h"
+#include "binsearchmap.h"
+#include "avlmap.h"
+
+
+template<typename K, typename V>
+class AdaptiveMap final : public Map<K,V>
+{
+public:
+
+  // the underlying representations, from smallest to largest
+  enum Representation { ARRAY, BINSEARCH, TREE };
+
+  // Creates an empty map that uses an ArrayMap for up to array_limit
+  // pairs, a BinSearchMap for up to binsearch_limit pairs, and an
+  // AVLMap for anything larger
+  AdaptiveMap(int array_limit = 16, int binsearch_limit = 4096);
+
+  // copy constructor
+  AdaptiveMap(const AdaptiveMap& rhs);
+
+  // move constructor
+  AdaptiveMap(AdaptiveMap&& rhs);
+
+  // copy assignment
+  AdaptiveMap& operator=(const AdaptiveMap& rhs);
+
+  // move assignment
+  AdaptiveMap& operator=(AdaptiveMap&& rhs);
+
+  // destructor
+  ~AdaptiveMap();
+
+  // Returns the number of key-value pairs in the map
+  int size() const;
+
+  // Tests if the map is empty
+  bool empty() const;
+
+  // Allows values associated with a key to be updated. Throws
+  // out_of_range if the given key is not in the collection.
+  V& operator[](const K& key);
+
+  // Returns the value for a given key. Throws out_of_range if the
+  // given key is not in the collection.
+  const V& operator[](const K& key) const;
+
+  // Extends the collection by adding the given key-value pair.
+  // Expects key to not exist in map prior to insertion.
+  void insert(const K& key, const V& value);
+
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
+  // Shrinks the collection by removing the key-value pair with the
+  // given key. Does not modify the collection if the collection does
+  // not contain the key. Throws out_of_range if the given key is not
+  // in the collection.
+  void erase(const K& key);
+
+  // Returns true if the key is in the collection, and false otherwise.
+  bool contains(const K& key) const;
+
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
+  // Returns the keys k in the collection such that k1 <= k <= k2
+  ArraySeq<K> find_keys(const K& k1, const K& k2) const;
+
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
+  // Returns the keys in the collection in ascending sorted order
+  ArraySeq<K> sorted_keys() const;
+
+  // Gives the key (as an ouptput parameter) immediately after the
+  // given key according to ascending sort order. Returns true if a
+  // successor key exists, and false otherwise.
+  bool next_key(const K& key, K& next_key) const;
+
+  // Gives the key (as an ouptput parameter) immediately before the
+  // given key according to ascending sort order. Returns true if a
+  // predecessor key exists, and false otherwise.
+  bool prev_key(const K& key, K& prev_key) const;
+
+  // Removes all key-value pairs from the map and goes back to the
+  // inline ArrayMap.
+  void clear();
+
+  // Returns the representation currently in use
+  Representation representation() const;
+
+private:
+
+  // size thresholds for leaving the array and binsearch maps
+  int array_limit;
+  int binsearch_limit;
+
+  // the representation in use
+  Representation rep = ARRAY;
+
+  // number of pairs the small map holds inline before its arrays
+  // move to the heap
+  static const int inline_pairs = 16;
+
+  // the inline arrays the small map is backed by
+  template<typename T>
+  using InlineSeq = SmallSeq<T, inline_pairs>;
+
+  // inline storage for small maps
+  ArrayMap<K,V,InlineSeq> small;
+
+  // heap allocated BinSearchMap or AVLMap once the map has grown
+  Map<K,V>* grown = nullptr;
+
+  // returns the map for the current representation
+  Map<K,V>& active();
+  const Map<K,V>& active() const;
+
+  // creates an empty map of the given (non-array) representation
+  Map<K,V>* make_map(Representation new_rep) const;
+
+  // moves every pair from src into dst in one for_each pass
+  template<typename Src>
+  static void transfer(const Src& src, Map<K,V>& dst);
+
+  // moves every pair of the current representation into dst and
+  // clears it
+  void transfer_to(Map<K,V>& dst);
+
+  // switches to the given representation, moving the pairs over
+  void migrate(Representation new_rep);
+
+  // representation for the current size, given the hysteresis
+  Representation choose() const;
+
+  // migrates if the size has crossed a threshold
+  void adapt();
+
+};
+
+
+template<typename K, typename V>
+AdaptiveMap<K,V>::AdaptiveMap(int array_limit, int binsearch_limit)
+  : array_limit(array_limit), binsearch_limit(binsearch_limit)
+{
+}
+
+//initalizes the copy constructor
+template<typename K, typename V>
+AdaptiveMap<K,V>::AdaptiveMap(const AdaptiveMap& rhs)
+{
+  *this = rhs;
+}
+
+//initalizes the move constructor
+template<typename K, typename V>
+AdaptiveMap<K,V>::AdaptiveMap(AdaptiveMap&& rhs)
+{
+  *this = std::move(rhs);
+}
+
+//initalizes the copy assignment by copying the concrete map in use
+template<typename K, typename V>
+AdaptiveMap<K,V>& AdaptiveMap<K,V>::operator=(const AdaptiveMap& rhs)
+{
+  if(this != &rhs){
+    clear();
+    array_limit = rhs.array_limit;
+    binsearch_limit = rhs.binsearch_limit;
+    rep = rhs.rep;
+    if(rep == ARRAY){
+      small = rhs.small;
+    } else if(rep == BINSEARCH){
+      grown = new BinSearchMap<K,V>(*static_cast<BinSearchMap<K,V>*>(rhs.grown));
+    } else {
+      grown = new AVLMap<K,V>(*static_cast<AVLMap<K,V>*>(rhs.grown));
+    }
+  }
+  return *this;
+}
+
+//initalizes the move assignment
+template<typename K, typename V>
+AdaptiveMap<K,V>& AdaptiveMap<K,V>::operator=(AdaptiveMap&& rhs)
+{
+  if(this != &rhs){
+    clear();
+    array_limit = rhs.array_limit;
+    binsearch_limit = rhs.binsearch_limit;
+    rep = rhs.rep;
+    small = std::move(rhs.small);
+    grown = rhs.grown;
+    rhs.rep = ARRAY;
+    rhs.grown = nullptr;
+  }
+  return *this;
+}
+
+//initalizes the destructor
+template<typename K, typename V>
+AdaptiveMap<K,V>::~AdaptiveMap()
+{
+  clear();
+}
+
+//returns the number of pairs in the map
+template<typename K, typename V>
+int AdaptiveMap<K,V>::size() const
+{
+  return active().size();
+}
+
+//returns true if the map is empty, false if not
+template<typename K, typename V>
+bool AdaptiveMap<K,V>::empty() const
+{
+  return active().empty();
+}
+
+//given a valid key, returns the corrisponding key value
+//throws an out_of_range exception if key is invalid
+template<typename K, typename V>
+V& AdaptiveMap<K,V>::operator[](const K& key)
+{
+  return active()[key];
+}
+
+//given a valid key, returns the corrisponding key value as a constant
+//throws an out_of_range exception if key is invalid
+template<typename K, typename V>
+const V& AdaptiveMap<K,V>::operator[](const K& key) const
+{
+  return active()[key];
+}
+
+//inserts the pair and migrates up if the map outgrew its representation
+template<typename K, typename V>
+void AdaptiveMap<K,V>::insert(const K& key, const V& value)
+{
+  active().insert(key, value);
+  adapt();
+}
+
+//moves the pair in and migrates up if the map outgrew its
+//representation
+template<typename K, typename V>
+void AdaptiveMap<K,V>::insert(K&& key, V&& value)
+{
+  active().insert(std::move(key), std::move(value));
+  adapt();
+}
+
+//constructs the pair in place in the concrete map for the current
+//representation, then migrates up if needed
+template<typename K, typename V>
+template<typename KeyArg, typename... Args>
+void AdaptiveMap<K,V>::emplace(KeyArg&& key, Args&&... args)
+{
+  if(rep == ARRAY){
+    small.emplace(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+  } else if(rep == BINSEARCH){
+    static_cast<BinSearchMap<K,V>*>(grown) -> emplace(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+  } else {
+    static_cast<AVLMap<K,V>*>(grown) -> emplace(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+  }
+  adapt();
+}
+
+//erases the pair and migrates down if the map shrank well below its
+//representation's threshold
+template<typename K, typename V>
+void AdaptiveMap<K,V>::erase(const K& key)
+{
+  active().erase(key);
+  adapt();
+}
+
+//returns true if given key is in the map, false if not
+template<typename K, typename V>
+bool AdaptiveMap<K,V>::contains(const K& key) const
+{
+  return active().contains(key);
+}
+
+//returns a pointer to the value of the key, or nullptr if not in the
+//map
+template<typename K, typename V>
+V* AdaptiveMap<K,V>::find(const K& key)
+{
+  return active().find(key);
+}
+
+//returns a constant pointer to the value of the key, or nullptr if not
+//in the map
+template<typename K, typename V>
+const V* AdaptiveMap<K,V>::find(const K& key) const
+{
+  return active().find(key);
+}
+
+//sets or adds the pair and migrates up if a pair was added
+template<typename K, typename V>
+bool AdaptiveMap<K,V>::insert_or_assign(const K& key, const V& value)
+{
+  if(!active().insert_or_assign(key, value)){
+    return false;
+  }
+  adapt();
+  return true;
+}
+
+//adds the pair if the key is new and migrates up if it was added
+template<typename K, typename V>
+bool AdaptiveMap<K,V>::try_emplace(const K& key, const V& value)
+{
+  if(!active().try_emplace(key, value)){
+    return false;
+  }
+  adapt();
+  return true;
+}
+
+//erases the pair if there is one and migrates down if it was removed
+template<typename K, typename V>
+bool AdaptiveMap<K,V>::try_erase(const K& key)
+{
+  if(!active().try_erase(key)){
+    return false;
+  }
+  adapt();
+  return true;
+}
+
+//returns an ArraySeq of key values that are between k1 and k2
+template<typename K, typename V>
+ArraySeq<K> AdaptiveMap<K,V>::find_keys(const K& k1, const K& k2) const
+{
+  return active().find_keys(k1, k2);
+}
+
+//adds the key values that are between k1 and k2 to the given sequence
+template<typename K, typename V>
+void AdaptiveMap<K,V>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
+  active().find_keys(k1, k2, keys);
+}
+
+//returns an array seq of all of the keys in sorted order
+template<typename K, typename V>
+ArraySeq<K> AdaptiveMap<K,V>::sorted_keys() const
+{
+  return active().sorted_keys();
+}
+
+//returns the next key value in the map
+template<typename K, typename V>
+bool AdaptiveMap<K,V>::next_key(const K& key, K& next_key) const
+{
+  return active().next_key(key, next_key);
+}
+
+//returns the previous key value in the map
+template<typename K, typename V>
+bool AdaptiveMap<K,V>::prev_key(const K& key, K& prev_key) const
+{
+  return active().prev_key(key, prev_key);
+}
+
+//deletes all of the pairs and frees the grown map
+template<typename K, typename V>
+void AdaptiveMap<K,V>::clear()
+{
+  small.clear();
+  delete grown;
+  grown = nullptr;
+  rep = ARRAY;
+}
+
+//returns the representation currently in use
+template<typename K, typename V>
+typename AdaptiveMap<K,V>::Representation AdaptiveMap<K,V>::representation() const
+{
+  return rep;
+}
+
+//returns the map currently holding the pairs
+template<typename K, typename V>
+Map<K,V>& AdaptiveMap<K,V>::active()
+{
+  if(grown){
+    return *grown;
+  }
+  return small;
+}
+
+//returns the map currently holding the pairs as a constant
+template<typename K, typename V>
+const Map<K,V>& AdaptiveMap<K,V>::active() const
+{
+  if(grown){
+    return *grown;
+  }
+  return small;
+}
+
+//returns a new empty BinSearchMap or AVLMap
+template<typename K, typename V>
+Map<K,V>* AdaptiveMap<K,V>::make_map(Representation new_rep) const
+{
+  if(new_rep == BINSEARCH){
+    return new BinSearchMap<K,V>;
+  }
+  return new AVLMap<K,V>;
+}
+
+//moves the pairs over as for_each visits them. The source is about to
+//be cleared and for_each never looks at a pair again once it has been
+//handed to f, so the pairs can be moved out from under it. The grown
+//maps visit in key order, so a BinSearchMap destination only appends.
+template<typename K, typename V>
+template<typename Src>
+void AdaptiveMap<K,V>::transfer(const Src& src, Map<K,V>& dst)
+{
+  src.for_each([&dst](const K& key, const V& value){
+    dst.insert(std::move(const_cast<K&>(key)), std::move(const_cast<V&>(value)));
+  });
+}
+
+//moves the pairs out of the concrete map in use, then clears it
+template<typename K, typename V>
+void AdaptiveMap<K,V>::transfer_to(Map<K,V>& dst)
+{
+  if(rep == ARRAY){
+    transfer(small, dst);
+  } else if(rep == BINSEARCH){
+    transfer(*static_cast<BinSearchMap<K,V>*>(grown), dst);
+  } else {
+    transfer(*static_cast<AVLMap<K,V>*>(grown), dst);
+  }
+  active().clear();
+}
+
+//switches to the new representation
+template<typename K, typename V>
+void AdaptiveMap<K,V>::migrate(Representation new_rep)
+{
+  if(new_rep == ARRAY){
+    transfer_to(small);
+    delete grown;
+    grown = nullptr;
+  } else {
+    Map<K,V>* next = make_map(new_rep);
+    transfer_to(*next);
+    delete grown;
+    grown = next;
+  }
+  rep = new_rep;
+}
+
+//grows as soon as a limit is passed, but only shrinks once the size
+//is below half of the smaller representation's limit
+template<typename K, typename V>
+typename AdaptiveMap<K,V>::Representation AdaptiveMap<K,V>::choose() const
+{
+  int n = size();
+  if(rep == ARRAY){
+    if(n > binsearch_limit){
+      return TREE;
+    }
+    if(n > array_limit){
+      return BINSEARCH;
+    }
+  } else if(rep == BINSEARCH){
+    if(n > binsearch_limit){
+      return TREE;
+    }
+    if(n < array_limit / 2){
+      return ARRAY;
+    }
+  } else {
+    if(n < array_limit / 2){
+      return ARRAY;
+    }
+    if(n < binsearch_limit / 2){
+      return BINSEARCH;
+    }
+  }
+  return rep;
+}
+
+//migrates to the representation chosen for the current size
+template<typename K, typename V>
+void AdaptiveMap<K,V>::adapt()
+{
+  Representation new_rep = choose();
+  if(new_rep != rep){
+    migrate(new_rep);
+  }
+}
+
+#endif
@@ -2,6 +2,9 @@
 // NAME: Connor Goldschmidt
 // DATE: Spring 2022
 // DESC: Implements the ArrayMap implementation of the Map interface.
+//       The keys and values are held in ArraySeqs by default; Seq can
+//       be any sequence that also has emplace_back and data, such as
+//       a SmallSeq, to keep a small map inside the object.
 //---------------------------------------------------------------------------
 
 #ifndef ARRAYMAP_H
@@ -9,10 +12,11 @@
 
 #include "map.h"
 #include "arrayseq.h"
+#include "simdsearch.h"
 
 
-template<typename K, typename V>
-class ArrayMap : public Map<K,V>
+template<typename K, typename V, template<typename> class Seq = ArraySeq>
+class ArrayMap final : public Map<K,V>
 {
 public:
 
@@ -34,6 +38,16 @@ public:
   // Expects key to not exist in map prior to insertion.
   void insert(const K& key, const V& value);
 
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
   // Shrinks the collection by removing the key-value pair with the
   // given key. Does not modify the collection if the collection does
   // not contain the key. Throws out_of_range if the given key is not
@@ -44,9 +58,34 @@ public:
   // otherwise.
   bool contains(const K& key) const;
 
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
   // Returns the keys k in the collection such that k1 <= k <= k2
   ArraySeq<K> find_keys(const K& k1, const K& k2) const;
 
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
   // Returns the keys in the collection in ascending sorted order.
   ArraySeq<K> sorted_keys() const;  
 
@@ -60,157 +99,260 @@ public:
   // predecessor key exists, and false otherwise.
   bool prev_key(const K& key, K& next_key) const;
 
+  // Calls f(key, value) on each key-value pair, in insertion order
+  template<typename F>
+  void for_each(F f) const;
+
   // Removes all key-value pairs from the map.
   void clear();
 
 private:
 
-  // implemented as a resizable array of (key-value) pairs
-  ArraySeq<std::pair<K,V>> seq;
+  // implemented as parallel resizable arrays of keys and values, so
+  // key scans do not pull values into the cache
+  Seq<K> key_seq;
+  Seq<V> val_seq;
+
+  // returns the index of the key, or -1 if not in the map
+  int find_index(const K& key) const;
 
 };
 
 
+//Returns the index of the key by scanning only the key array (with
+//vectorized compares for integral keys), returns -1 if the key is
+//not in the ArrayMap
+template<typename K, typename V, template<typename> class Seq>
+int ArrayMap<K, V, Seq>::find_index(const K& key) const
+{
+  return linear_search(key_seq.data(), key_seq.size(), key);
+}
+
 //Returns the size of the current ArrayMap
-template<typename K, typename V>
-int ArrayMap<K, V>::size() const
+template<typename K, typename V, template<typename> class Seq>
+int ArrayMap<K, V, Seq>::size() const
 {
-  return seq.size();
+  return key_seq.size();
 }
 
 //Returns true if the current ArrayMap is empty, false if not
-template<typename K, typename V>
-bool ArrayMap<K, V>::empty() const
+template<typename K, typename V, template<typename> class Seq>
+bool ArrayMap<K, V, Seq>::empty() const
 {
-  return seq.empty();
+  return key_seq.empty();
 }
 
 //Returns the assocated value pair of the input key, 
 //throws an out_of_range exception if key is not contained 
 //in the ArrayMap 
-template<typename K, typename V>
-V& ArrayMap<K, V>::operator[](const K& key)
+template<typename K, typename V, template<typename> class Seq>
+V& ArrayMap<K, V, Seq>::operator[](const K& key)
 {
-  for(int i = 0; i < seq.size(); i++){
-    if(seq[i].first == key){
-      return seq[i].second;
-    }
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator ArrayMap"); 
   }
-  throw std::out_of_range("Out of Range in Operator ArrayMap"); 
+  return *value;
 }
 
 //Returns the assocated value pair of the input key, 
 //throws an out_of_range exception if key is not contained 
 //in the ArrayMap 
-template<typename K, typename V>
-const V& ArrayMap<K, V>::operator[](const K& key) const
+template<typename K, typename V, template<typename> class Seq>
+const V& ArrayMap<K, V, Seq>::operator[](const K& key) const
 {
-  for(int i = 0; i < seq.size(); i++){
-    if(seq[i].first == key){
-      return seq[i].second;
-    }
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator ArrayMap"); 
   }
-  throw std::out_of_range("Out of Range in Operator ArrayMap"); 
+  return *value;
 }
 
 //Inserts the given key value pair in the ArrayMap
-template<typename K, typename V>
-void ArrayMap<K, V>::insert(const K& key, const V& value)
+template<typename K, typename V, template<typename> class Seq>
+void ArrayMap<K, V, Seq>::insert(const K& key, const V& value)
 {
-  seq.insert(std::make_pair(key, value), seq.size());
+  emplace(key, value);
+}
+
+//Moves the given key value pair into the ArrayMap
+template<typename K, typename V, template<typename> class Seq>
+void ArrayMap<K, V, Seq>::insert(K&& key, V&& value)
+{
+  emplace(std::move(key), std::move(value));
+}
+
+//Constructs the key and value at the ends of their arrays
+template<typename K, typename V, template<typename> class Seq>
+template<typename KeyArg, typename... Args>
+void ArrayMap<K, V, Seq>::emplace(KeyArg&& key, Args&&... args)
+{
+  key_seq.emplace_back(std::forward<KeyArg>(key));
+  val_seq.emplace_back(std::forward<Args>(args)...);
 }
 
 //Removes the key value pair of the given key in the ArrayMap,
 //throws an out_of_range exception if key is not in the list
-template<typename K, typename V>
-void ArrayMap<K, V>::erase(const K& key)
+template<typename K, typename V, template<typename> class Seq>
+void ArrayMap<K, V, Seq>::erase(const K& key)
 {
-  for(int i = 0; i < seq.size(); i++){
-    if(seq[i].first == key){
-      seq.erase(i);
-      return;
-    }
+  if(!try_erase(key)){
+    throw std::out_of_range("Out of Range in Erase"); 
   }
-  throw std::out_of_range("Out of Range in Erase"); 
 }
 
 //Returns true if the given key is found in the ArrayMap, false if not
-template<typename K, typename V>
-bool ArrayMap<K, V>::contains(const K& key) const
+template<typename K, typename V, template<typename> class Seq>
+bool ArrayMap<K, V, Seq>::contains(const K& key) const
 {
-  for(int i = 0; i < seq.size(); i++){
-    if(seq[i].first == key){
-      return true;
-    }
+  return find_index(key) != -1;
+}
+
+//Returns a pointer to the value of the given key, or nullptr if the
+//key is not in the ArrayMap
+template<typename K, typename V, template<typename> class Seq>
+V* ArrayMap<K, V, Seq>::find(const K& key)
+{
+  int index = find_index(key);
+  if(index == -1){
+    return nullptr;
+  }
+  return &val_seq[index];
+}
+
+//Returns a constant pointer to the value of the given key, or nullptr
+//if the key is not in the ArrayMap
+template<typename K, typename V, template<typename> class Seq>
+const V* ArrayMap<K, V, Seq>::find(const K& key) const
+{
+  int index = find_index(key);
+  if(index == -1){
+    return nullptr;
   }
-  return false;
+  return &val_seq[index];
+}
+
+//Replaces the value of the given key if it is in the ArrayMap,
+//otherwise appends the pair. Returns true if the pair was appended.
+template<typename K, typename V, template<typename> class Seq>
+bool ArrayMap<K, V, Seq>::insert_or_assign(const K& key, const V& value)
+{
+  int index = find_index(key);
+  if(index != -1){
+    val_seq[index] = value;
+    return false;
+  }
+  insert(key, value);
+  return true;
+}
+
+//Appends the pair if the key is not in the ArrayMap. Returns true if
+//the pair was appended.
+template<typename K, typename V, template<typename> class Seq>
+bool ArrayMap<K, V, Seq>::try_emplace(const K& key, const V& value)
+{
+  if(find_index(key) != -1){
+    return false;
+  }
+  insert(key, value);
+  return true;
+}
+
+//Removes the key value pair of the given key if it is in the
+//ArrayMap. Returns true if a pair was removed.
+template<typename K, typename V, template<typename> class Seq>
+bool ArrayMap<K, V, Seq>::try_erase(const K& key)
+{
+  int index = find_index(key);
+  if(index == -1){
+    return false;
+  }
+  key_seq.erase(index);
+  val_seq.erase(index);
+  return true;
 }
 
 //Returns all of the keys between or equal to the values of k1 and k2
-template<typename K, typename V>
-ArraySeq<K> ArrayMap<K, V>::find_keys(const K& k1, const K& k2) const
+template<typename K, typename V, template<typename> class Seq>
+ArraySeq<K> ArrayMap<K, V, Seq>::find_keys(const K& k1, const K& k2) const
 {
   ArraySeq<K> keys;
-  for(int i = 0; i < size(); i++){
-    if(seq[i].first >= k1 && seq[i].first <= k2){
-      keys.insert(seq[i].first, keys.size());
+  find_keys(k1, k2, keys);
+  return keys;
+}
+
+//Adds all of the keys between or equal to the values of k1 and k2 to
+//the given sequence
+template<typename K, typename V, template<typename> class Seq>
+void ArrayMap<K, V, Seq>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
+  for(int i = 0; i < key_seq.size(); i++){
+    if(key_seq[i] >= k1 && key_seq[i] <= k2){
+      keys.insert(key_seq[i], keys.size());
     }
   }
-  return keys;
 }
 
-//Returns a sorted ArraySeq of all of the keys
-template<typename K, typename V>
-ArraySeq<K> ArrayMap<K, V>::sorted_keys() const
+//Returns a sorted ArraySeq of all of the keys. The keys are in
+//insertion order, which is often already close to sorted, so the
+//natural merge sort can use the existing runs.
+template<typename K, typename V, template<typename> class Seq>
+ArraySeq<K> ArrayMap<K, V, Seq>::sorted_keys() const
 {
   ArraySeq<K> keys;
-  if(empty()){
-    return keys;
-  }
-  for(int i = 0; i < size(); i++){
-    keys.insert(seq[i].first, keys.size());
-  }
-  keys.sort();
+  keys.insert_range(0, key_seq.data(), key_seq.data() + key_seq.size());
+  keys.merge_sort();
   return keys;
 }
 
 //Returns true if there is a key larger than the input key and
-//updates the next_key parameter. Returns false if not
-template<typename K, typename V>
-bool ArrayMap<K, V>::next_key(const K& key, K& next_key) const
+//updates the next_key parameter. Returns false if not. The keys are
+//not kept in order, so every key is checked.
+template<typename K, typename V, template<typename> class Seq>
+bool ArrayMap<K, V, Seq>::next_key(const K& key, K& next_key) const
 {
-  if(empty() || seq[size() - 1].first <= key){
-    return false;
-  }
-  for(int i = 1; i <= size() - 1; i++){
-    if(seq[i - 1].first <= key && key < seq[i].first){
-      next_key = seq[i].first;
-      return true;
+  bool found = false;
+  for(int i = 0; i < key_seq.size(); i++){
+    if(key < key_seq[i] && (!found || key_seq[i] < next_key)){
+      next_key = key_seq[i];
+      found = true;
     }
   }
+  return found;
 }
 
 //Returns true if there is a key smaller than the input key and
-//updates the next_key parameter. Returns false if not
-template<typename K, typename V>
-bool ArrayMap<K, V>::prev_key(const K& key, K& prev_key) const
+//updates the next_key parameter. Returns false if not. The keys are
+//not kept in order, so every key is checked.
+template<typename K, typename V, template<typename> class Seq>
+bool ArrayMap<K, V, Seq>::prev_key(const K& key, K& prev_key) const
 {
-  if(empty() || seq[0].first >= key){
-    return false;
-  }
-  for(int i = 0; i < size() - 1; i++){
-    if(seq[i].first < key && key <= seq[i + 1].first){
-      prev_key = seq[i].first;
-      return true;
+  bool found = false;
+  for(int i = 0; i < key_seq.size(); i++){
+    if(key_seq[i] < key && (!found || prev_key < key_seq[i])){
+      prev_key = key_seq[i];
+      found = true;
     }
   }
+  return found;
+}
+
+//Calls f on each pair in the order they were added
+template<typename K, typename V, template<typename> class Seq>
+template<typename F>
+void ArrayMap<K, V, Seq>::for_each(F f) const
+{
+  for(int i = 0; i < key_seq.size(); i++){
+    f(key_seq[i], val_seq[i]);
+  }
 }
 
 //Clears the current ArrayMap
-template<typename K, typename V>
-void ArrayMap<K, V>::clear()
+template<typename K, typename V, template<typename> class Seq>
+void ArrayMap<K, V, Seq>::clear()
 {
-  seq.clear();
+  key_seq.clear();
+  val_seq.clear();
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -3,6 +3,12 @@
 // FILE: arrayseq.h
 // DATE: Spring 2022
 // DESC: Resizeable-array implementation of the sequence interface.
+//       The array is raw storage: only the first size() slots hold
+//       constructed elements. Growing moves the elements into the new
+//       array (a single memcpy for trivially copyable types). On
+//       Linux, large arrays of trivially copyable types are instead
+//       backed by an anonymous mapping that grows in place with
+//       mremap and asks for transparent huge pages.
 //----------------------------------------------------------------------
 
 
@@ -11,7 +17,45 @@
 
 #include <stdexcept>
 #include <ostream>
+#include <new>
+#include <cstring>
+#include <cstdlib>
+#include <utility>
+#include <type_traits>
+#include <iterator>
+#include <cstdint>
+#include <climits>
+#include <thread>
+#include <vector>
 #include "sequence.h"
+#include "sortnet.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+//----------------------------------------------------------------------
+// Says whether ArraySeq can radix sort elements of type T: integral
+// types (other than bool), and pairs whose first member is integral.
+// key() gives the integral sort key of an element.
+//----------------------------------------------------------------------
+template<typename T>
+struct RadixKey
+{
+  static const bool value = std::is_integral<T>::value && !std::is_same<T,bool>::value;
+  typedef T type;
+  static const T& key(const T& elem) { return elem; }
+};
+
+template<typename A, typename B>
+struct RadixKey<std::pair<A,B>>
+{
+  static const bool value = std::is_integral<A>::value && !std::is_same<A,bool>::value;
+  typedef A type;
+  static const A& key(const std::pair<A,B>& elem) { return elem.first; }
+};
 
 
 template<typename T>
@@ -56,27 +100,109 @@ public:
   // greater than or equal to size()).
   const T& operator[](int index) const;
 
+  // Returns a pointer to the first element of the underlying array
+  // (nullptr if nothing has been allocated). Valid until the sequence
+  // is next resized or cleared.
+  T* data();
+  const T* data() const;
+
   // Extends the sequence by inserting the element at the given index.
   // Throws out_of_range if the index is invalid (less than 0 or
   // greater than size()).
   void insert(const T& elem, int index);
 
+  // Same as above, but moves the element into the sequence.
+  void insert(T&& elem, int index);
+
+  // Extends the sequence by constructing an element from the given
+  // arguments directly in the array at the given index. Throws
+  // out_of_range if the index is invalid.
+  template<typename... Args>
+  void emplace(int index, Args&&... args);
+
+  // Adds the element to the end of the sequence
+  void push_back(const T& elem);
+  void push_back(T&& elem);
+
+  // Constructs an element at the end of the sequence
+  template<typename... Args>
+  void emplace_back(Args&&... args);
+
+  // Makes sure the sequence can hold at least n elements without
+  // growing again.
+  void reserve(int n);
+
+  // Returns the number of elements the array can hold before growing
+  int capacity() const;
+
   // Shrinks the sequence by removing the element at the index in the
   // sequence. Throws out_of_range if index is invalid.
   void erase(int index);
 
+  // Inserts copies of the elements in [first, last) starting at the
+  // given index, shifting the rest of the sequence once. The range
+  // must not come from this sequence. Throws out_of_range if the
+  // index is invalid.
+  template<typename Iter>
+  void insert_range(int index, Iter first, Iter last);
+
+  // Removes the elements at indexes [start, end), shifting the rest of
+  // the sequence once. Throws out_of_range if the range is invalid.
+  void erase_range(int start, int end);
+
+  // Adds copies of all of the elements of rhs to the end of the
+  // sequence
+  void append(const ArraySeq& rhs);
+
   // Returns true if the element is in the sequence, and false
   // otherwise.
   bool contains(const T& elem) const;
 
   // Sorts the elements in the sequence in place using less than equal
-  // (<=) operator. Uses quick sort with a randomly selected pivot
-  // index.
+  // (<=) operator. Uses the radix sort below when RadixKey<T> allows
+  // it, and the intro sort otherwise. Always sorts on the calling
+  // thread.
   void sort(); 
 
-  // Sorts the sequence in place using the merge sort algorithm.
+  // Sorts the sequence using the given number of threads (0 for one
+  // per hardware thread). Each thread sorts a chunk the same way
+  // sort() would, and the chunks are then merged in parallel. Not
+  // stable. Never called by sort(), so threads are only started by
+  // callers that ask for them.
+  void parallel_sort(int threads);
+
+  // Sorts the sequence using an LSD radix sort on the RadixKey of each
+  // element, 8 bits per pass. Passes where every key has the same
+  // digit are skipped. Pairs with equal keys are then put in order by
+  // the rest of the pair. Only for types where RadixKey<T>::value is
+  // true.
+  void radix_sort();
+
+  // Sorts the sequence in place using pattern-defeating quick sort:
+  // median of 3 (or ninther) pivots, insertion sort (or a sorting
+  // network for int keys, see sortnet.h) for small ranges, block
+  // partitioning for arithmetic types, and a heap sort fallback
+  // once too many partitions are unbalanced, so it is O(n log n) on
+  // any input and O(n) on sorted or reversed input.
+  void intro_sort();
+
+  // Sorts the sequence in place using a stable natural merge sort.
+  // Existing ascending and descending runs are kept, short runs are
+  // extended with insertion sort, and runs are merged with galloping
+  // through one scratch buffer, so sorted input takes O(n) time.
   void merge_sort();
 
+  // Rearranges the sequence so the element at the index is the one
+  // that would be there after sort(), with no larger elements before it
+  // and no smaller ones after it. Expected O(n) (introselect). Throws
+  // out_of_range if the index is invalid.
+  void nth_element(int index);
+
+  // Sorts only the k smallest elements into the first k positions,
+  // leaving the rest in an unspecified order. O(n + k log k). Throws
+  // out_of_range if k is less than 0 or greater than size().
+  void partial_sort(int k);
+
   // Sorts the sequence in place using the quick sort algorithm. Uses
   // first element for pivot values.
   void quick_sort();
@@ -88,25 +214,128 @@ public:
   
 private:
 
-  // resizable array
+  // true if elements can be moved around with memcpy/memmove
+  static const bool trivial = std::is_trivially_copyable<T>::value;
+
+  // resizable array, only the first count slots are constructed
   T* array = nullptr;
 
   // size of list
   int count = 0;
 
   // max capacity of the array
-  int capacity = 0;
+  int max_count = 0;
 
   // helper to double the capacity of the array
   void resize();
 
+  // largest capacity whose element count fits in an int and whose
+  // byte size fits in a size_t
+  static const int max_capacity =
+    (size_t) INT_MAX < SIZE_MAX / sizeof(T) ? INT_MAX : (int) (SIZE_MAX / sizeof(T));
+
+  // returns the capacity to grow to for at least needed elements,
+  // twice the current capacity or needed if that is more (worked out
+  // in size_t so neither can overflow). Throws length_error if needed
+  // is over max_capacity.
+  int grown_capacity(size_t needed) const;
+
+  // moves the elements into a new array with the given capacity
+  void reallocate(int new_capacity);
+
+  // arrays of at least this many bytes are mapped rather than heap
+  // allocated (trivially copyable types on Linux only)
+  static const long map_threshold = 4L << 20;
+
+  // true if the array is an anonymous mapping rather than a heap block
+  bool mapped = false;
+
+  // mapped growth, returns false if the array should stay on the heap
+  bool remap(int new_capacity);
+
+  // returns the array storage to the heap or the kernel
+  void release();
+
+  // moves n elements from src to the uninitialized dst and destroys
+  // the originals
+  static void relocate(T* dst, T* src, int n);
+
+  // destroys the elements in [first, first + n)
+  static void destroy(T* first, int n);
+
   // sort function helpers
-  void merge_sort(int start, int end);
   void quick_sort(int start, int end);
   void quick_sort_random(int start, int end);
 
   // random seed for quick sort
   int seed = 22;
+
+  // intro sort tuning: ranges below insertion_size are insertion
+  // sorted, ranges above ninther_size use the ninther pivot, and the
+  // block partition works on block_size elements at a time
+  static const int insertion_size = 24;
+  static const int ninther_size = 128;
+  static const int block_size = 64;
+
+  // intro sort helpers, each works on the range [begin, end)
+  static void intro_sort(T* begin, T* end, int bad_allowed, bool leftmost);
+  static void intro_select(T* begin, T* end, T* nth, int bad_allowed, bool leftmost);
+  static void insertion_sort(T* begin, T* end);
+  static void unguarded_insertion_sort(T* begin, T* end);
+  static bool partial_insertion_sort(T* begin, T* end);
+  static void sort3(T* a, T* b, T* c);
+  static T* partition_right(T* begin, T* end, bool& already_partitioned);
+  static T* partition_right_block(T* begin, T* end, bool& already_partitioned);
+  static T* partition_left(T* begin, T* end);
+  static void heap_sort(T* begin, T* end);
+  static void sift_down(T* begin, int index, int n);
+
+  // merge sort tuning: galloping starts once one side wins this many
+  // times in a row (adjusted as the sort goes), and the run stack is
+  // deep enough for any int size given the run length invariants
+  static const int min_gallop_start = 7;
+  static const int max_runs = 64;
+
+  // radix sort tuning: smaller sequences use the intro sort instead
+  static const int radix_min = 256;
+
+  // returns the radix key of the element as an unsigned value that
+  // sorts the same way (the sign bit is flipped for signed keys)
+  static uint64_t radix_bits(const T& elem);
+
+  // radix sorts the range [begin, begin + n)
+  static void radix_sort(T* begin, int n);
+
+  // returns floor(log2 n), the intro sort's bad partition allowance
+  static int depth_limit(int n);
+
+  // sorts [begin, end) on the calling thread, with the radix sort if
+  // RadixKey<T> allows it and the intro sort otherwise
+  static void sort_range(T* begin, T* end);
+
+  // returns the number of hardware threads (at least 1)
+  static int default_sort_threads();
+
+  // parallel sort helpers. Each round merges neighbouring pairs of the
+  // sorted runs of src (given by bounds) into dst. merge_split returns
+  // how many of the first k elements of the pair holding output k
+  // come from its first run. merge_slice writes the outputs
+  // [out_start, out_end), given the splits at both ends, constructing
+  // them if construct is true. co_rank returns how many of the first k
+  // merged elements come from a.
+  static int merge_split(const T* src, const std::vector<int>& bounds, int k);
+  static void merge_slice(T* src, T* dst, const std::vector<int>& bounds,
+                          int out_start, int out_end, int start_split,
+                          int end_split, bool construct);
+  static int co_rank(int k, const T* a, int a_n, const T* b, int b_n);
+
+  // merge sort helpers
+  static int min_run_length(int n);
+  int next_run(int start, int min_run);
+  void merge_runs(int base1, int len1, int base2, int len2, T* scratch, int& min_gallop);
+  void merge_low(int base1, int len1, int base2, int len2, T* scratch, int& min_gallop);
+  void merge_high(int base1, int len1, int base2, int len2, T* scratch, int& min_gallop);
+  static int gallop(const T& key, const T* run, int n, bool upper, bool from_end);
   
 };
 
@@ -142,17 +371,24 @@ ArraySeq<T>::ArraySeq(ArraySeq&& rhs)
   *this = std::move(rhs);
 }
 
-//Post: Initializes the copy assignment. 
+//Post: Initializes the copy assignment. Only the elements are copied,
+//the new array is sized to fit them.
 template<typename T>
 ArraySeq<T>& ArraySeq<T>::operator=(const ArraySeq<T>& rhs)
 {
   if(this != &rhs){
     clear();
-    array = new T[rhs.capacity];
-    for(int i = 0; i < rhs.count; i++){
-      array[i] = rhs.array[i];
+    if(rhs.count == 0){
+      return *this;
+    }
+    reallocate(rhs.count);
+    if(trivial){
+      std::memcpy((void*) array, (const void*) rhs.array, sizeof(T) * rhs.count);
+    } else {
+      for(int i = 0; i < rhs.count; i++){
+        new (array + i) T(rhs.array[i]);
+      }
     }
-    capacity = rhs.capacity;
     count = rhs.count;
   }
   return *this;
@@ -165,12 +401,15 @@ ArraySeq<T>& ArraySeq<T>::operator=(ArraySeq<T>&& rhs)
   if(this != &rhs){
     clear();
     array = rhs.array;
-    capacity = rhs.capacity;
+    max_count = rhs.max_count;
+    mapped = rhs.mapped;
     count = rhs.count;
-    rhs.capacity = 0;
+    rhs.max_count = 0;
+    rhs.mapped = false;
     rhs.count = 0;
     rhs.array = nullptr;
   }
+  return *this;
 }
 
 //Post: Initalizes the deconstructor.
@@ -184,9 +423,10 @@ ArraySeq<T>::~ArraySeq<T>()
 template<typename T>
 void ArraySeq<T>::clear()
 {
-  delete [] array;
+  destroy(array, count);
+  release();
   array = nullptr;
-  capacity = 0;
+  max_count = 0;
   count = 0;
 }
 
@@ -227,23 +467,111 @@ const T& ArraySeq<T>::operator[](int index) const
     return array[index];
 }
 
+//Post: Returns the underlying array.
+template<typename T>
+T* ArraySeq<T>::data()
+{
+  return array;
+}
+
+//Post: Returns the underlying array as a constant.
+template<typename T>
+const T* ArraySeq<T>::data() const
+{
+  return array;
+}
+
 //Pre: Index must be in range. Must be greater or equal to 
 //0 and less than or equal to count.
-//Post: Inserts the given value and the given index.
+//Post: Inserts a copy of the given value at the given index.
 template<typename T>
 void ArraySeq<T>::insert(const T& elem, int index)
+{
+  emplace(index, elem);
+}
+
+//Pre: Index must be in range. Must be greater or equal to 
+//0 and less than or equal to count.
+//Post: Moves the given value into the given index.
+template<typename T>
+void ArraySeq<T>::insert(T&& elem, int index)
+{
+  emplace(index, std::move(elem));
+}
+
+//Pre: Index must be in range. Must be greater or equal to 
+//0 and less than or equal to count.
+//Post: Constructs a new element at the given index. The element is
+//built before anything is shifted, since the arguments may refer to
+//an element of this sequence.
+template<typename T>
+template<typename... Args>
+void ArraySeq<T>::emplace(int index, Args&&... args)
 {
   if(index < 0 || index > count){
     throw std::out_of_range("Out of Range in Insert"); 
   } 
-  if(count >= capacity ){
-      resize();
+  if(index == count && count < max_count){
+    new (array + count) T(std::forward<Args>(args)...);
+    count++;
+    return;
+  }
+  T elem(std::forward<Args>(args)...);
+  if(count >= max_count){
+    resize();
   }
-  for(int i = count - 1; i >= index; i--){
-    array[i + 1] = array[i];
+  if(index == count){
+    new (array + count) T(std::move(elem));
+  } else if(trivial){
+    std::memmove((void*) (array + index + 1), (const void*) (array + index),
+                 sizeof(T) * (count - index));
+    new (array + index) T(std::move(elem));
+  } else {
+    new (array + count) T(std::move(array[count - 1]));
+    for(int i = count - 1; i > index; i--){
+      array[i] = std::move(array[i - 1]);
+    }
+    array[index] = std::move(elem);
   }
   count++;
-  array[index] = elem;
+}
+
+//Post: Adds a copy of the given value to the end of the sequence.
+template<typename T>
+void ArraySeq<T>::push_back(const T& elem)
+{
+  emplace(count, elem);
+}
+
+//Post: Moves the given value to the end of the sequence.
+template<typename T>
+void ArraySeq<T>::push_back(T&& elem)
+{
+  emplace(count, std::move(elem));
+}
+
+//Post: Constructs a new element at the end of the sequence.
+template<typename T>
+template<typename... Args>
+void ArraySeq<T>::emplace_back(Args&&... args)
+{
+  emplace(count, std::forward<Args>(args)...);
+}
+
+//Post: Grows the array to hold at least n elements.
+template<typename T>
+void ArraySeq<T>::reserve(int n)
+{
+  if(n > max_count){
+    reallocate(n);
+  }
+}
+
+//Post: Returns the current capacity.
+template<typename T>
+int ArraySeq<T>::capacity() const
+{
+  return max_count;
 }
 
 //Pre: Index must be in range. Must be greater or equal to 
@@ -255,12 +583,100 @@ void ArraySeq<T>::erase(int index)
   if(index < 0 || index >= count){
     throw std::out_of_range("Out of Range in Erase"); 
   } 
-  for(int i = index; i < count - 1; i++){
-    array[i] = array[i + 1];
+  if(trivial){
+    std::memmove((void*) (array + index), (const void*) (array + index + 1),
+                 sizeof(T) * (count - index - 1));
+  } else {
+    for(int i = index; i < count - 1; i++){
+      array[i] = std::move(array[i + 1]);
+    }
+    array[count - 1].~T();
   }
   count--;
 }
 
+//Pre: Index must be in range. Must be greater or equal to 
+//0 and less than or equal to count.
+//Post: Opens a gap for the new elements with one shift of the tail
+//(a memmove for trivially copyable types) and copies them in.
+template<typename T>
+template<typename Iter>
+void ArraySeq<T>::insert_range(int index, Iter first, Iter last)
+{
+  if(index < 0 || index > count){
+    throw std::out_of_range("Out of Range in Insert Range"); 
+  }
+  int n = std::distance(first, last);
+  if(n == 0){
+    return;
+  }
+  if((size_t) count + n > (size_t) max_count){
+    reallocate(grown_capacity((size_t) count + n));
+  }
+  T* gap = array + index;
+  int tail = count - index;
+  if(trivial){
+    std::memmove((void*) (gap + n), (const void*) gap, sizeof(T) * tail);
+    for(int i = 0; i < n; i++, ++first){
+      new (gap + i) T(*first);
+    }
+  } else {
+    for(int i = tail - 1; i >= 0; i--){
+      if(index + i + n >= count){
+        new (gap + i + n) T(std::move(gap[i]));
+      } else {
+        gap[i + n] = std::move(gap[i]);
+      }
+    }
+    for(int i = 0; i < n; i++, ++first){
+      if(index + i < count){
+        gap[i] = *first;
+      } else {
+        new (gap + i) T(*first);
+      }
+    }
+  }
+  count += n;
+}
+
+//Pre: 0 <= start <= end <= count.
+//Post: Closes the gap left by the removed elements with one shift of
+//the tail.
+template<typename T>
+void ArraySeq<T>::erase_range(int start, int end)
+{
+  if(start < 0 || start > end || end > count){
+    throw std::out_of_range("Out of Range in Erase Range"); 
+  }
+  int n = end - start;
+  if(n == 0){
+    return;
+  }
+  if(trivial){
+    std::memmove((void*) (array + start), (const void*) (array + end),
+                 sizeof(T) * (count - end));
+  } else {
+    for(int i = end; i < count; i++){
+      array[i - n] = std::move(array[i]);
+    }
+    destroy(array + count - n, n);
+  }
+  count -= n;
+}
+
+//Post: Adds the elements of rhs to the end of the sequence. Appending
+//a sequence to itself goes through a copy.
+template<typename T>
+void ArraySeq<T>::append(const ArraySeq& rhs)
+{
+  if(this == &rhs){
+    ArraySeq<T> copy(rhs);
+    insert_range(count, copy.array, copy.array + copy.count);
+  } else {
+    insert_range(count, rhs.array, rhs.array + rhs.count);
+  }
+}
+
 //Post: Returns true if the given element is contained in the list,
 //false if not.
 template<typename T>
@@ -279,35 +695,401 @@ bool ArraySeq<T>::contains(const T& elem) const
 template<typename T>
 void ArraySeq<T>::resize()
 {
-  if(capacity == 0){
-    capacity = 1;
+  reallocate(grown_capacity((size_t) max_count + 1));
+}
+
+//Post: Returns the doubled capacity, capped at max_capacity, or needed
+//if that is more. Throws length_error if needed is over max_capacity.
+template<typename T>
+int ArraySeq<T>::grown_capacity(size_t needed) const
+{
+  if(needed > (size_t) max_capacity){
+    throw std::length_error("Capacity Overflow in ArraySeq");
+  }
+  size_t doubled = max_count == 0 ? 1 : (size_t) max_count * 2;
+  if(doubled > (size_t) max_capacity){
+    doubled = max_capacity;
+  }
+  return (int) (doubled > needed ? doubled : needed);
+}
+
+//Post: Moves the elements into a new array of the given capacity.
+//Throws length_error if it is negative or over max_capacity.
+template<typename T>
+void ArraySeq<T>::reallocate(int new_capacity)
+{
+  if(new_capacity < 0 || new_capacity > max_capacity){
+    throw std::length_error("Capacity Overflow in ArraySeq");
+  }
+  if(remap(new_capacity)){
+    return;
+  }
+  T* new_array = static_cast<T*>(::operator new(sizeof(T) * (size_t) new_capacity));
+  relocate(new_array, array, count);
+  release();
+  array = new_array;
+  max_count = new_capacity;
+}
+
+//Post: Grows a large trivially copyable array in a mapping. A heap
+//array is copied into a new mapping once, after that mremap grows it
+//without copying (the kernel moves the pages if it cannot extend the
+//mapping in place). The capacity is rounded up to whole pages.
+template<typename T>
+bool ArraySeq<T>::remap(int new_capacity)
+{
+#ifdef __linux__
+  size_t bytes = sizeof(T) * (size_t) new_capacity;
+  if(!trivial || bytes < (size_t) map_threshold){
+    return false;
+  }
+  size_t page = sysconf(_SC_PAGESIZE);
+  bytes = (bytes + page - 1) / page * page;
+  void* ptr;
+  if(mapped){
+    size_t old_bytes = (sizeof(T) * (size_t) max_count + page - 1) / page * page;
+    ptr = mremap(array, old_bytes, bytes, MREMAP_MAYMOVE);
   } else {
-    capacity *= 2;
+    ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if(ptr == MAP_FAILED){
+    throw std::bad_alloc();
+  }
+  madvise(ptr, bytes, MADV_HUGEPAGE);
+  if(!mapped){
+    relocate(static_cast<T*>(ptr), array, count);
+    ::operator delete(array);
   }
-    T* new_array = new T[capacity];
-    for(int i = 0; i < count; i++){
-      new_array[i] = array[i];
+  array = static_cast<T*>(ptr);
+  // page rounding can add up to a page of elements, which must not
+  // take the capacity past max_capacity
+  size_t fits = bytes / sizeof(T);
+  max_count = fits > (size_t) max_capacity ? max_capacity : (int) fits;
+  mapped = true;
+  return true;
+#else
+  return false;
+#endif
+}
+
+//Post: Frees the array storage (does not destroy the elements).
+template<typename T>
+void ArraySeq<T>::release()
+{
+#ifdef __linux__
+  if(mapped){
+    munmap(array, sizeof(T) * (size_t) max_count);
+    mapped = false;
+    return;
+  }
+#endif
+  ::operator delete(array);
+}
+
+//Post: Moves n elements from src into the uninitialized dst, as a
+//single memcpy for trivially copyable types.
+template<typename T>
+void ArraySeq<T>::relocate(T* dst, T* src, int n)
+{
+  if(n == 0){
+    return;
+  }
+  if(trivial){
+    std::memcpy((void*) dst, (const void*) src, sizeof(T) * n);
+  } else {
+    for(int i = 0; i < n; i++){
+      new (dst + i) T(std::move_if_noexcept(src[i]));
+      src[i].~T();
     }
-    delete [] array;
-    array = new_array;
-  
+  }
 }
 
-//Post: Sorts the current arrayseq.
+//Post: Runs the destructor of each of the n elements.
+template<typename T>
+void ArraySeq<T>::destroy(T* first, int n)
+{
+  if(!std::is_trivially_destructible<T>::value){
+    for(int i = 0; i < n; i++){
+      first[i].~T();
+    }
+  }
+}
+
+//Post: Sorts the current arrayseq on the calling thread.
 template<typename T>
 void ArraySeq<T>::sort()
 {
-  merge_sort();
+  sort_range(array, array + count);
+}
+
+//Post: Sorts the current arrayseq with an LSD radix sort.
+template<typename T>
+void ArraySeq<T>::radix_sort()
+{
+  radix_sort(array, count);
+}
+
+//Post: Radix sorts the n elements starting at begin. All of the digit
+//counts are taken in one pass up front, then each pass that is not
+//skipped scatters the elements between the range and one scratch
+//buffer.
+template<typename T>
+void ArraySeq<T>::radix_sort(T* begin, int n)
+{
+  if(n < radix_min){
+    intro_sort(begin, begin + n, depth_limit(n), true);
+    return;
+  }
+  const int digits = sizeof(typename RadixKey<T>::type);
+  int counts[digits][256] = {};
+  for(int i = 0; i < n; i++){
+    uint64_t bits = radix_bits(begin[i]);
+    for(int d = 0; d < digits; d++){
+      counts[d][(bits >> (8 * d)) & 0xff]++;
+    }
+  }
+
+  T* src = begin;
+  T* dst = static_cast<T*>(::operator new(sizeof(T) * n));
+  T* scratch = dst;
+  bool constructed = false;
+  uint64_t first_bits = radix_bits(begin[0]);
+  for(int d = 0; d < digits; d++){
+    if(counts[d][(first_bits >> (8 * d)) & 0xff] == n){
+      continue;
+    }
+    int offsets[256];
+    int total = 0;
+    for(int b = 0; b < 256; b++){
+      offsets[b] = total;
+      total += counts[d][b];
+    }
+    int shift = 8 * d;
+    if(dst == scratch && !constructed){
+      for(int i = 0; i < n; i++){
+        new (dst + offsets[(radix_bits(src[i]) >> shift) & 0xff]++) T(std::move(src[i]));
+      }
+      constructed = true;
+    } else {
+      for(int i = 0; i < n; i++){
+        dst[offsets[(radix_bits(src[i]) >> shift) & 0xff]++] = std::move(src[i]);
+      }
+    }
+    std::swap(src, dst);
+  }
+  if(src == scratch){
+    for(int i = 0; i < n; i++){
+      begin[i] = std::move(scratch[i]);
+    }
+  }
+  if(constructed){
+    destroy(scratch, n);
+  }
+  ::operator delete(scratch);
+
+  // pairs with the same key still need ordering by the rest of the pair
+  if constexpr (!std::is_integral<T>::value){
+    int start = 0;
+    for(int i = 1; i <= n; i++){
+      if(i == n || RadixKey<T>::key(begin[i]) != RadixKey<T>::key(begin[start])){
+        if(i - start > 1){
+          intro_sort(begin + start, begin + i, depth_limit(i - start), true);
+        }
+        start = i;
+      }
+    }
+  }
+}
+
+//Post: Sorts the current arrayseq using pattern-defeating quick sort.
+//The number of badly unbalanced partitions allowed before switching
+//to heap sort is log2 of the size.
+template<typename T>
+void ArraySeq<T>::intro_sort()
+{
+  if(count <= 1){
+    return;
+  }
+  intro_sort(array, array + count, depth_limit(count), true);
 }
 
-//Post: Sorts the current arrayseq using the merge sort technique.
+//Post: Sorts the current arrayseq on the given number of threads.
+//Each thread first sorts its own chunk with the sequential sort. Then
+//pairs of sorted chunks are merged round by round, ping-ponging
+//between the array and one scratch buffer. Every round splits its
+//output evenly over all of the threads (each finds where its slice
+//starts in both inputs by binary search), so the last merges are not
+//left to a single thread.
+template<typename T>
+void ArraySeq<T>::parallel_sort(int threads)
+{
+  if(threads <= 0){
+    threads = default_sort_threads();
+  }
+  if(threads > count / insertion_size){
+    threads = count / insertion_size;
+  }
+  if(threads <= 1){
+    sort_range(array, array + count);
+    return;
+  }
+
+  // run boundaries, run i is [bounds[i], bounds[i + 1])
+  std::vector<int> bounds(threads + 1);
+  for(int i = 0; i <= threads; i++){
+    bounds[i] = (int) ((long) count * i / threads);
+  }
+  std::vector<std::thread> workers;
+  for(int i = 0; i < threads; i++){
+    T* first = array + bounds[i];
+    T* last = array + bounds[i + 1];
+    workers.emplace_back([first, last]{ sort_range(first, last); });
+  }
+  for(std::thread& worker : workers){
+    worker.join();
+  }
+
+  T* src = array;
+  T* scratch = static_cast<T*>(::operator new(sizeof(T) * count));
+  T* dst = scratch;
+  bool constructed = false;
+  while(bounds.size() > 2){
+    std::vector<int> merged;
+    for(int i = 0; i + 1 < (int) bounds.size(); i += 2){
+      merged.push_back(bounds[i]);
+    }
+    merged.push_back(count);
+    bool construct = dst == scratch && !constructed;
+    // the splits are all found before any thread starts moving
+    // elements out of src
+    std::vector<int> splits(threads + 1);
+    for(int t = 0; t < threads; t++){
+      splits[t] = merge_split(src, bounds, (int) ((long) count * t / threads));
+    }
+    workers.clear();
+    for(int t = 0; t < threads; t++){
+      int out_start = (int) ((long) count * t / threads);
+      int out_end = (int) ((long) count * (t + 1) / threads);
+      int start_split = splits[t];
+      int end_split = splits[t + 1];
+      workers.emplace_back([&, out_start, out_end, start_split, end_split]{
+        merge_slice(src, dst, bounds, out_start, out_end, start_split,
+                    end_split, construct);
+      });
+    }
+    for(std::thread& worker : workers){
+      worker.join();
+    }
+    constructed = constructed || construct;
+    bounds = merged;
+    std::swap(src, dst);
+  }
+
+  if(src == scratch){
+    workers.clear();
+    for(int t = 0; t < threads; t++){
+      int start = (int) ((long) count * t / threads);
+      int end = (int) ((long) count * (t + 1) / threads);
+      workers.emplace_back([this, scratch, start, end]{
+        for(int i = start; i < end; i++){
+          array[i] = std::move(scratch[i]);
+        }
+      });
+    }
+    for(std::thread& worker : workers){
+      worker.join();
+    }
+  }
+  if(constructed){
+    destroy(scratch, count);
+  }
+  ::operator delete(scratch);
+}
+
+//Pre: Index must be in range. Must be greater or equal to
+//0 and less than count.
+//Post: Puts the element that belongs at the index there, with the
+//smaller elements before it and the larger ones after it.
+template<typename T>
+void ArraySeq<T>::nth_element(int index)
+{
+  if(index < 0 || index >= count){
+    throw std::out_of_range("Out of Range in Nth Element");
+  }
+  intro_select(array, array + count, array + index, depth_limit(count), true);
+}
+
+//Pre: 0 <= k <= count.
+//Post: Selects the k-th smallest element, then sorts the elements in
+//front of it (or sorts everything if k is the size).
+template<typename T>
+void ArraySeq<T>::partial_sort(int k)
+{
+  if(k < 0 || k > count){
+    throw std::out_of_range("Out of Range in Partial Sort");
+  }
+  if(k == count){
+    sort_range(array, array + count);
+  } else if(k > 0){
+    intro_select(array, array + count, array + (k - 1), depth_limit(count), true);
+    sort_range(array, array + (k - 1));
+  }
+}
+
+//Post: Sorts the current arrayseq using the natural merge sort. Runs
+//are pushed on a stack and merged whenever the top lengths stop
+//shrinking like the Fibonacci numbers, which keeps merges balanced.
 template<typename T>
 void ArraySeq<T>::merge_sort()
 {
   if(count <= 1){
     return;
   }
-  merge_sort(0, count - 1);
+  int min_run = min_run_length(count);
+  int min_gallop = min_gallop_start;
+  T* scratch = static_cast<T*>(::operator new(sizeof(T) * (count / 2 + 1)));
+  int run_base[max_runs];
+  int run_len[max_runs];
+  int runs = 0;
+  int start = 0;
+  while(start < count){
+    run_base[runs] = start;
+    run_len[runs] = next_run(start, min_run);
+    start += run_len[runs];
+    runs++;
+    while(runs > 1){
+      int i = runs - 2;
+      if((i > 0 && run_len[i - 1] <= run_len[i] + run_len[i + 1]) ||
+         (i > 1 && run_len[i - 2] <= run_len[i - 1] + run_len[i])){
+        if(run_len[i - 1] < run_len[i + 1]){
+          i--;
+        }
+      } else if(run_len[i] > run_len[i + 1]){
+        break;
+      }
+      merge_runs(run_base[i], run_len[i], run_base[i + 1], run_len[i + 1], scratch, min_gallop);
+      run_len[i] += run_len[i + 1];
+      if(i == runs - 3){
+        run_base[i + 1] = run_base[i + 2];
+        run_len[i + 1] = run_len[i + 2];
+      }
+      runs--;
+    }
+  }
+  while(runs > 1){
+    int i = runs - 2;
+    if(i > 0 && run_len[i - 1] < run_len[i + 1]){
+      i--;
+    }
+    merge_runs(run_base[i], run_len[i], run_base[i + 1], run_len[i + 1], scratch, min_gallop);
+    run_len[i] += run_len[i + 1];
+    if(i == runs - 3){
+      run_base[i + 1] = run_base[i + 2];
+      run_len[i + 1] = run_len[i + 2];
+    }
+    runs--;
+  }
+  ::operator delete(scratch);
 }
   
 //Post: Sorts the current arrayseq using the quick sort technique. The pivot value is set to the
@@ -333,38 +1115,6 @@ void ArraySeq<T>::quick_sort_random()
     quick_sort_random(0, count - 1);    
 }
 
-//Pre: Start and end are assumed to not be less than 0.
-//Post: Impliments the private helper method for the merge sort.
-template<typename T>
-void ArraySeq<T>::merge_sort(int start, int end)
-{
-  if(start < end){
-    int mid = (start + end) / 2;
-    merge_sort(start, mid);
-    merge_sort(mid + 1, end);
-    T temp[(end - start) + 1];
-    int first = start;
-    int second = mid + 1;
-    int list_index = 0;
-    while(first <= mid && second <= end){
-      if(array[first] < array[second]){
-        temp[list_index++] = array[first++];
-      } else {
-        temp[list_index++] = array[second++];
-      }
-    }
-    while(first <= mid){
-      temp[list_index++] = array[first++];
-    }
-    while(second <= end){ 
-      temp[list_index++] = array[second++];
-    }
-    for(int i = 0; i <= (end - start); i++){
-      array[start + i] = temp[i];
-    }
-  }
-}
-
 //Pre: Start and end are assumed to not be less than 0.
 //Post: implements the private helper method for the quick sort.
 template<typename T>
@@ -395,10 +1145,10 @@ template<typename T>
 void ArraySeq<T>::quick_sort_random(int start, int end)
 {
   if(start < end){
-    int pivot_index = (std::rand() % (end - start));
+    int pivot_index = start + std::rand() % (end - start + 1);
     T pivot_val = array[pivot_index];
-    T move_front = array[0];
-    array[0] = pivot_val;
+    T move_front = array[start];
+    array[start] = pivot_val;
     array[pivot_index] = move_front;
     int end_p1 = start;
     for(int i = start + 1; i <= end; i++){
@@ -412,9 +1162,797 @@ void ArraySeq<T>::quick_sort_random(int start, int end)
     T temp = array[start];
     array[start] = array[end_p1];
     array[end_p1] = temp;
-    quick_sort(start, end_p1 - 1);
-    quick_sort(end_p1 + 1, end);
+    quick_sort_random(start, end_p1 - 1);
+    quick_sort_random(end_p1 + 1, end);
+  }
+}
+
+//Post: Sorts [begin, end). Partitions around a median of 3 (ninther
+//for large ranges) pivot and loops on the right side. Unbalanced
+//partitions shuffle a few elements to break up patterns, and after
+//bad_allowed of them the range is heap sorted. A partition that
+//needed no swaps is probably already sorted, so both sides get a
+//partial insertion sort that gives up after a few moves. leftmost is
+//false when the element before begin is known to be no larger than
+//every element in the range.
+template<typename T>
+void ArraySeq<T>::intro_sort(T* begin, T* end, int bad_allowed, bool leftmost)
+{
+  while(true){
+    int size = end - begin;
+    if constexpr (SortNetwork<T>::value){
+      if(size <= network_leaf){
+        network_sort(begin, size);
+        return;
+      }
+    }
+    if(size < insertion_size){
+      if(leftmost){
+        insertion_sort(begin, end);
+      } else {
+        unguarded_insertion_sort(begin, end);
+      }
+      return;
+    }
+
+    int half = size / 2;
+    if(size > ninther_size){
+      sort3(begin, begin + half, end - 1);
+      sort3(begin + 1, begin + (half - 1), end - 2);
+      sort3(begin + 2, begin + (half + 1), end - 3);
+      sort3(begin + (half - 1), begin + half, begin + (half + 1));
+      std::swap(*begin, *(begin + half));
+    } else {
+      sort3(begin + half, begin, end - 1);
+    }
+
+    // equal to the element before the range, so everything equal to
+    // the pivot goes left and is never looked at again
+    if(!leftmost && !(*(begin - 1) < *begin)){
+      begin = partition_left(begin, end) + 1;
+      continue;
+    }
+
+    bool already_partitioned;
+    T* pivot;
+    if(std::is_arithmetic<T>::value){
+      pivot = partition_right_block(begin, end, already_partitioned);
+    } else {
+      pivot = partition_right(begin, end, already_partitioned);
+    }
+
+    int left_size = pivot - begin;
+    int right_size = end - (pivot + 1);
+    if(left_size < size / 8 || right_size < size / 8){
+      bad_allowed--;
+      if(bad_allowed == 0){
+        heap_sort(begin, end);
+        return;
+      }
+      if(left_size >= insertion_size){
+        std::swap(begin[0], begin[left_size / 4]);
+        std::swap(pivot[-1], pivot[-left_size / 4]);
+        if(left_size > ninther_size){
+          std::swap(begin[1], begin[left_size / 4 + 1]);
+          std::swap(begin[2], begin[left_size / 4 + 2]);
+          std::swap(pivot[-2], pivot[-(left_size / 4 + 1)]);
+          std::swap(pivot[-3], pivot[-(left_size / 4 + 2)]);
+        }
+      }
+      if(right_size >= insertion_size){
+        std::swap(pivot[1], pivot[1 + right_size / 4]);
+        std::swap(end[-1], end[-right_size / 4]);
+        if(right_size > ninther_size){
+          std::swap(pivot[2], pivot[2 + right_size / 4]);
+          std::swap(pivot[3], pivot[3 + right_size / 4]);
+          std::swap(end[-2], end[-(1 + right_size / 4)]);
+          std::swap(end[-3], end[-(2 + right_size / 4)]);
+        }
+      }
+    } else if(already_partitioned && partial_insertion_sort(begin, pivot) &&
+              partial_insertion_sort(pivot + 1, end)){
+      return;
+    }
+
+    intro_sort(begin, pivot, bad_allowed, leftmost);
+    begin = pivot + 1;
+    leftmost = false;
+  }
+}
+
+//Post: Puts the element that belongs at nth in sorted order there,
+//partitioning [begin, end) around it. Uses the same pivots and
+//partitions as intro_sort, but only keeps going on the side holding
+//nth. After bad_allowed badly unbalanced partitions the rest of the
+//range is heap sorted, which bounds it at O(n log n). leftmost is as
+//in intro_sort.
+template<typename T>
+void ArraySeq<T>::intro_select(T* begin, T* end, T* nth, int bad_allowed, bool leftmost)
+{
+  while(end - begin >= insertion_size){
+    int size = end - begin;
+    int half = size / 2;
+    if(size > ninther_size){
+      sort3(begin, begin + half, end - 1);
+      sort3(begin + 1, begin + (half - 1), end - 2);
+      sort3(begin + 2, begin + (half + 1), end - 3);
+      sort3(begin + (half - 1), begin + half, begin + (half + 1));
+      std::swap(*begin, *(begin + half));
+    } else {
+      sort3(begin + half, begin, end - 1);
+    }
+
+    // everything equal to the pivot goes left, and all of it is already
+    // in its sorted position
+    if(!leftmost && !(*(begin - 1) < *begin)){
+      T* last_equal = partition_left(begin, end);
+      if(nth <= last_equal){
+        return;
+      }
+      begin = last_equal + 1;
+      continue;
+    }
+
+    bool already_partitioned;
+    T* pivot;
+    if(std::is_arithmetic<T>::value){
+      pivot = partition_right_block(begin, end, already_partitioned);
+    } else {
+      pivot = partition_right(begin, end, already_partitioned);
+    }
+    if(pivot - begin < size / 8 || end - (pivot + 1) < size / 8){
+      bad_allowed--;
+      if(bad_allowed == 0){
+        heap_sort(begin, end);
+        return;
+      }
+    }
+    if(nth == pivot){
+      return;
+    } else if(nth < pivot){
+      end = pivot;
+    } else {
+      begin = pivot + 1;
+      leftmost = false;
+    }
+  }
+  intro_sort(begin, end, bad_allowed, leftmost);
+}
+
+//Post: Sorts [begin, end) using insertion sort.
+template<typename T>
+void ArraySeq<T>::insertion_sort(T* begin, T* end)
+{
+  if(begin == end){
+    return;
+  }
+  for(T* cur = begin + 1; cur != end; cur++){
+    if(*cur < *(cur - 1)){
+      T temp = std::move(*cur);
+      T* sift = cur;
+      do {
+        *sift = std::move(*(sift - 1));
+        sift--;
+      } while(sift != begin && temp < *(sift - 1));
+      *sift = std::move(temp);
+    }
+  }
+}
+
+//Pre: The element before begin is no larger than any in the range.
+//Post: Sorts [begin, end) using insertion sort without checking for
+//the start of the range.
+template<typename T>
+void ArraySeq<T>::unguarded_insertion_sort(T* begin, T* end)
+{
+  if(begin == end){
+    return;
+  }
+  for(T* cur = begin + 1; cur != end; cur++){
+    if(*cur < *(cur - 1)){
+      T temp = std::move(*cur);
+      T* sift = cur;
+      do {
+        *sift = std::move(*(sift - 1));
+        sift--;
+      } while(temp < *(sift - 1));
+      *sift = std::move(temp);
+    }
+  }
+}
+
+//Post: Insertion sorts [begin, end) but gives up once more than 8
+//elements have been moved. Returns true if the range got sorted.
+template<typename T>
+bool ArraySeq<T>::partial_insertion_sort(T* begin, T* end)
+{
+  if(begin == end){
+    return true;
+  }
+  int moved = 0;
+  for(T* cur = begin + 1; cur != end; cur++){
+    if(*cur < *(cur - 1)){
+      T temp = std::move(*cur);
+      T* sift = cur;
+      do {
+        *sift = std::move(*(sift - 1));
+        sift--;
+      } while(sift != begin && temp < *(sift - 1));
+      *sift = std::move(temp);
+      moved += cur - sift;
+    }
+    if(moved > 8){
+      return false;
+    }
+  }
+  return true;
+}
+
+//Post: Puts the three elements in sorted order.
+template<typename T>
+void ArraySeq<T>::sort3(T* a, T* b, T* c)
+{
+  if(*b < *a){
+    std::swap(*a, *b);
+  }
+  if(*c < *b){
+    std::swap(*b, *c);
+  }
+  if(*b < *a){
+    std::swap(*a, *b);
+  }
+}
+
+//Pre: The pivot is at begin and the median of 3 put an element no
+//smaller than it somewhere after it.
+//Post: Partitions [begin, end) into elements less than the pivot and
+//elements no less than it, returning the pivot's final position.
+//already_partitioned is set if no elements had to be swapped.
+template<typename T>
+T* ArraySeq<T>::partition_right(T* begin, T* end, bool& already_partitioned)
+{
+  T pivot = std::move(*begin);
+  T* first = begin;
+  T* last = end;
+  while(*++first < pivot);
+  if(first - 1 == begin){
+    while(first < last && !(*--last < pivot));
+  } else {
+    while(!(*--last < pivot));
+  }
+  already_partitioned = first >= last;
+  while(first < last){
+    std::swap(*first, *last);
+    while(*++first < pivot);
+    while(!(*--last < pivot));
+  }
+  T* pivot_pos = first - 1;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return pivot_pos;
+}
+
+//Post: Same as partition_right, but compares a block of elements from
+//each end at a time and records the offsets of the ones on the wrong
+//side, so the compares do not branch. The misplaced elements are then
+//swapped in a cyclic chain.
+template<typename T>
+T* ArraySeq<T>::partition_right_block(T* begin, T* end, bool& already_partitioned)
+{
+  T pivot = std::move(*begin);
+  T* first = begin;
+  T* last = end;
+  while(*++first < pivot);
+  if(first - 1 == begin){
+    while(first < last && !(*--last < pivot));
+  } else {
+    while(!(*--last < pivot));
+  }
+  already_partitioned = first >= last;
+  if(!already_partitioned){
+    std::swap(*first, *last);
+    first++;
+
+    unsigned char offsets_l[block_size];
+    unsigned char offsets_r[block_size];
+    T* base_l = first;
+    T* base_r = last;
+    int num_l = 0;
+    int num_r = 0;
+    int start_l = 0;
+    int start_r = 0;
+    while(first < last){
+      int unknown = last - first;
+      int left_split = num_l == 0 ? (num_r == 0 ? unknown / 2 : unknown) : 0;
+      int right_split = num_r == 0 ? unknown - left_split : 0;
+      if(left_split > block_size){
+        left_split = block_size;
+      }
+      if(right_split > block_size){
+        right_split = block_size;
+      }
+      for(int i = 0; i < left_split; i++){
+        offsets_l[num_l] = i;
+        num_l += !(*first < pivot);
+        first++;
+      }
+      for(int i = 0; i < right_split; ){
+        offsets_r[num_r] = ++i;
+        num_r += *--last < pivot;
+      }
+
+      // swap pairs of misplaced elements, rotating them through a
+      // temporary unless both blocks match up exactly (which happens
+      // with descending input, where swaps keep the sort linear)
+      int num = num_l < num_r ? num_l : num_r;
+      if(num_l == num_r){
+        for(int i = 0; i < num; i++){
+          std::swap(base_l[offsets_l[start_l + i]], base_r[-offsets_r[start_r + i]]);
+        }
+      } else if(num > 0){
+        T* l = base_l + offsets_l[start_l];
+        T* r = base_r - offsets_r[start_r];
+        T temp = std::move(*l);
+        *l = std::move(*r);
+        for(int i = 1; i < num; i++){
+          l = base_l + offsets_l[start_l + i];
+          *r = std::move(*l);
+          r = base_r - offsets_r[start_r + i];
+          *l = std::move(*r);
+        }
+        *r = std::move(temp);
+      }
+      num_l -= num;
+      num_r -= num;
+      start_l += num;
+      start_r += num;
+      if(num_l == 0){
+        start_l = 0;
+        base_l = first;
+      }
+      if(num_r == 0){
+        start_r = 0;
+        base_r = last;
+      }
+    }
+
+    // whatever is left over in one block goes to the boundary
+    if(num_l > 0){
+      while(num_l > 0){
+        num_l--;
+        std::swap(base_l[offsets_l[start_l + num_l]], *--last);
+      }
+      first = last;
+    }
+    if(num_r > 0){
+      while(num_r > 0){
+        num_r--;
+        std::swap(base_r[-offsets_r[start_r + num_r]], *first);
+        first++;
+      }
+      last = first;
+    }
+  }
+  T* pivot_pos = first - 1;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return pivot_pos;
+}
+
+//Pre: The pivot is at begin.
+//Post: Partitions [begin, end) into elements no greater than the
+//pivot and elements greater than it, returning the pivot's final
+//position. Used when the pivot equals the element before the range.
+template<typename T>
+T* ArraySeq<T>::partition_left(T* begin, T* end)
+{
+  T pivot = std::move(*begin);
+  T* first = begin;
+  T* last = end;
+  while(pivot < *--last);
+  if(last + 1 == end){
+    while(first < last && !(pivot < *++first));
+  } else {
+    while(!(pivot < *++first));
+  }
+  while(first < last){
+    std::swap(*first, *last);
+    while(pivot < *--last);
+    while(!(pivot < *++first));
+  }
+  T* pivot_pos = last;
+  *begin = std::move(*pivot_pos);
+  *pivot_pos = std::move(pivot);
+  return pivot_pos;
+}
+
+//Post: Sorts [begin, end) using heap sort.
+template<typename T>
+void ArraySeq<T>::heap_sort(T* begin, T* end)
+{
+  int n = end - begin;
+  for(int i = n / 2 - 1; i >= 0; i--){
+    sift_down(begin, i, n);
+  }
+  for(int i = n - 1; i > 0; i--){
+    std::swap(begin[0], begin[i]);
+    sift_down(begin, 0, i);
+  }
+}
+
+//Post: Moves the element at index down the max heap of the first n
+//elements until it is no smaller than its children.
+template<typename T>
+void ArraySeq<T>::sift_down(T* begin, int index, int n)
+{
+  while(2 * index + 1 < n){
+    int child = 2 * index + 1;
+    if(child + 1 < n && begin[child] < begin[child + 1]){
+      child++;
+    }
+    if(!(begin[index] < begin[child])){
+      return;
+    }
+    std::swap(begin[index], begin[child]);
+    index = child;
+  }
+}
+
+
+//Post: Returns the shortest run to build with insertion sort, between
+//32 and 64 and chosen so n / min_run is close to a power of 2.
+template<typename T>
+int ArraySeq<T>::min_run_length(int n)
+{
+  int extra = 0;
+  while(n >= 64){
+    extra |= n & 1;
+    n >>= 1;
+  }
+  return n + extra;
+}
+
+//Post: Finds the run starting at start, reversing it if it is strictly
+//descending (strictly, so equal elements keep their order), and
+//extends it to min_run elements with binary insertion sort, or with
+//the sorting network when the keys allow it. Returns the run's length.
+template<typename T>
+int ArraySeq<T>::next_run(int start, int min_run)
+{
+  int end = start + 1;
+  if(end < count){
+    if(array[end] < array[start]){
+      while(end + 1 < count && array[end + 1] < array[end]){
+        end++;
+      }
+      for(int lo = start, hi = end; lo < hi; lo++, hi--){
+        std::swap(array[lo], array[hi]);
+      }
+    } else {
+      while(end + 1 < count && !(array[end + 1] < array[end])){
+        end++;
+      }
+    }
+    end++;
+  }
+  int limit = start + min_run < count ? start + min_run : count;
+  if constexpr (SortNetwork<T>::value){
+    // equal ints cannot be told apart, so the unstable network is fine
+    if(end < limit && limit - start <= network_leaf){
+      network_sort(array + start, limit - start);
+      return limit - start;
+    }
+  }
+  for(; end < limit; end++){
+    int pos = start + gallop(array[end], array + start, end - start, true, true);
+    if(pos < end){
+      T temp = std::move(array[end]);
+      for(int i = end; i > pos; i--){
+        array[i] = std::move(array[i - 1]);
+      }
+      array[pos] = std::move(temp);
+    }
+  }
+  return end - start;
+}
+
+//Pre: The two runs are next to each other and each is sorted.
+//Post: Merges the runs. Elements of the first run that are already
+//in place and elements of the second that are already in place are
+//skipped, then the shorter of what is left goes to the scratch buffer.
+template<typename T>
+void ArraySeq<T>::merge_runs(int base1, int len1, int base2, int len2, T* scratch, int& min_gallop)
+{
+  int skip = gallop(array[base2], array + base1, len1, true, false);
+  base1 += skip;
+  len1 -= skip;
+  if(len1 == 0){
+    return;
+  }
+  len2 = gallop(array[base1 + len1 - 1], array + base2, len2, false, true);
+  if(len2 == 0){
+    return;
+  }
+  if(len1 <= len2){
+    merge_low(base1, len1, base2, len2, scratch, min_gallop);
+  } else {
+    merge_high(base1, len1, base2, len2, scratch, min_gallop);
+  }
+}
+
+//Post: Merges front to back with the first run in the scratch buffer.
+//After min_gallop wins in a row by one side, switches to copying whole
+//blocks found by galloping until the blocks get short again.
+template<typename T>
+void ArraySeq<T>::merge_low(int base1, int len1, int base2, int len2, T* scratch, int& min_gallop)
+{
+  for(int i = 0; i < len1; i++){
+    new (scratch + i) T(std::move(array[base1 + i]));
+  }
+  int first = 0;
+  int second = base2;
+  int end2 = base2 + len2;
+  int dest = base1;
+  while(first < len1 && second < end2){
+    int wins1 = 0;
+    int wins2 = 0;
+    while(first < len1 && second < end2 && wins1 < min_gallop && wins2 < min_gallop){
+      if(array[second] < scratch[first]){
+        array[dest++] = std::move(array[second++]);
+        wins2++;
+        wins1 = 0;
+      } else {
+        array[dest++] = std::move(scratch[first++]);
+        wins1++;
+        wins2 = 0;
+      }
+    }
+    while(first < len1 && second < end2){
+      int block1 = gallop(array[second], scratch + first, len1 - first, true, false);
+      for(int i = 0; i < block1; i++){
+        array[dest++] = std::move(scratch[first++]);
+      }
+      if(first == len1){
+        break;
+      }
+      int block2 = gallop(scratch[first], array + second, end2 - second, false, false);
+      for(int i = 0; i < block2; i++){
+        array[dest++] = std::move(array[second++]);
+      }
+      if(block1 < min_gallop_start && block2 < min_gallop_start){
+        min_gallop += 2;
+        break;
+      }
+      if(min_gallop > 1){
+        min_gallop--;
+      }
+    }
+  }
+  while(first < len1){
+    array[dest++] = std::move(scratch[first++]);
+  }
+  destroy(scratch, len1);
+}
+
+//Post: Merges back to front with the second run in the scratch buffer,
+//galloping the same way as merge_low.
+template<typename T>
+void ArraySeq<T>::merge_high(int base1, int len1, int base2, int len2, T* scratch, int& min_gallop)
+{
+  for(int i = 0; i < len2; i++){
+    new (scratch + i) T(std::move(array[base2 + i]));
+  }
+  int first = base1 + len1;
+  int second = len2;
+  int dest = base2 + len2;
+  while(first > base1 && second > 0){
+    int wins1 = 0;
+    int wins2 = 0;
+    while(first > base1 && second > 0 && wins1 < min_gallop && wins2 < min_gallop){
+      if(scratch[second - 1] < array[first - 1]){
+        array[--dest] = std::move(array[--first]);
+        wins1++;
+        wins2 = 0;
+      } else {
+        array[--dest] = std::move(scratch[--second]);
+        wins2++;
+        wins1 = 0;
+      }
+    }
+    while(first > base1 && second > 0){
+      int block1 = (first - base1) -
+        gallop(scratch[second - 1], array + base1, first - base1, true, true);
+      for(int i = 0; i < block1; i++){
+        array[--dest] = std::move(array[--first]);
+      }
+      if(first == base1){
+        break;
+      }
+      int block2 = second - gallop(array[first - 1], scratch, second, false, true);
+      for(int i = 0; i < block2; i++){
+        array[--dest] = std::move(scratch[--second]);
+      }
+      if(block1 < min_gallop_start && block2 < min_gallop_start){
+        min_gallop += 2;
+        break;
+      }
+      if(min_gallop > 1){
+        min_gallop--;
+      }
+    }
+  }
+  while(second > 0){
+    array[--dest] = std::move(scratch[--second]);
+  }
+  destroy(scratch, len2);
+}
+
+//Pre: run[0, n) is sorted.
+//Post: Returns the number of elements of the run less than key (or no
+//greater than key if upper is true). Probes 1, 2, 4, ... elements in
+//from the start (or the end) before a binary search, so it is fast
+//when the answer is near that side.
+template<typename T>
+int ArraySeq<T>::gallop(const T& key, const T* run, int n, bool upper, bool from_end)
+{
+  int lo = 0;
+  int hi = n;
+  int step = 1;
+  if(!from_end){
+    int probe = 0;
+    while(probe < n && (upper ? !(key < run[probe]) : run[probe] < key)){
+      lo = probe + 1;
+      probe += step;
+      step *= 2;
+    }
+    if(probe < n){
+      hi = probe;
+    }
+  } else {
+    int probe = n - 1;
+    while(probe >= 0 && (upper ? key < run[probe] : !(run[probe] < key))){
+      hi = probe;
+      probe -= step;
+      step *= 2;
+    }
+    if(probe >= 0){
+      lo = probe + 1;
+    }
+  }
+  while(lo < hi){
+    int mid = (lo + hi) / 2;
+    if(upper ? !(key < run[mid]) : run[mid] < key){
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+
+//Post: Returns the key as an unsigned 64 bit value, with the sign bit
+//flipped for signed keys so negative keys come first.
+template<typename T>
+uint64_t ArraySeq<T>::radix_bits(const T& elem)
+{
+  typedef typename RadixKey<T>::type K;
+  typedef typename std::make_unsigned<K>::type U;
+  U bits = (U) RadixKey<T>::key(elem);
+  if(std::is_signed<K>::value){
+    bits ^= (U) 1 << (sizeof(K) * 8 - 1);
+  }
+  return bits;
+}
+
+//Post: Returns floor(log2 n), or 0 if n < 2.
+template<typename T>
+int ArraySeq<T>::depth_limit(int n)
+{
+  int depth = 0;
+  for(; n > 1; n /= 2){
+    depth++;
+  }
+  return depth;
+}
+
+//Post: Sorts the range with the radix sort or the intro sort.
+template<typename T>
+void ArraySeq<T>::sort_range(T* begin, T* end)
+{
+  if constexpr (RadixKey<T>::value){
+    radix_sort(begin, end - begin);
+  } else {
+    intro_sort(begin, end, depth_limit(end - begin), true);
+  }
+}
+
+//Post: Returns the number of hardware threads, or 1 if it is unknown.
+template<typename T>
+int ArraySeq<T>::default_sort_threads()
+{
+  int threads = std::thread::hardware_concurrency();
+  return threads > 0 ? threads : 1;
+}
+
+//Post: Finds the pair of runs holding output k (the last pair if k is
+//the end) and returns how many of its first k - start outputs come
+//from the pair's first run.
+template<typename T>
+int ArraySeq<T>::merge_split(const T* src, const std::vector<int>& bounds, int k)
+{
+  int runs = bounds.size() - 1;
+  for(int r = 0; r < runs; r += 2){
+    int a_start = bounds[r];
+    int b_start = bounds[r + 1];
+    int b_end = r + 2 <= runs ? bounds[r + 2] : b_start;
+    if(k < b_end){
+      return co_rank(k - a_start, src + a_start, b_start - a_start,
+                     src + b_start, b_end - b_start);
+    }
+  }
+  return 0;
+}
+
+//Post: Merges each pair of runs bounds[i], bounds[i + 1] (i even) of
+//src into the same positions of dst, but only writes the outputs that
+//fall in [out_start, out_end). A run without a partner is moved over
+//as is. Only the elements this slice outputs are read, since other
+//threads are moving the rest.
+template<typename T>
+void ArraySeq<T>::merge_slice(T* src, T* dst, const std::vector<int>& bounds,
+                              int out_start, int out_end, int start_split,
+                              int end_split, bool construct)
+{
+  int runs = bounds.size() - 1;
+  for(int r = 0; r < runs; r += 2){
+    int a_start = bounds[r];
+    int b_start = bounds[r + 1];
+    int b_end = r + 2 <= runs ? bounds[r + 2] : b_start;
+    int lo = a_start > out_start ? a_start : out_start;
+    int hi = b_end < out_end ? b_end : out_end;
+    if(lo >= hi){
+      continue;
+    }
+    T* a = src + a_start;
+    T* b = src + b_start;
+    int i = lo == a_start ? 0 : start_split;
+    int j = lo - a_start - i;
+    int i_end = hi == b_end ? b_start - a_start : end_split;
+    int j_end = hi - a_start - i_end;
+    for(int k = lo; k < hi; k++){
+      T* next;
+      if(j == j_end || (i < i_end && !(b[j] < a[i]))){
+        next = a + i++;
+      } else {
+        next = b + j++;
+      }
+      if(construct){
+        new (dst + k) T(std::move(*next));
+      } else {
+        dst[k] = std::move(*next);
+      }
+    }
+  }
+}
+
+//Post: Binary searches for the number of elements of a among the
+//first k outputs of merging a and b (taking from a on ties).
+template<typename T>
+int ArraySeq<T>::co_rank(int k, const T* a, int a_n, const T* b, int b_n)
+{
+  int lo = k - b_n > 0 ? k - b_n : 0;
+  int hi = k < a_n ? k : a_n;
+  while(lo < hi){
+    int i = lo + (hi - lo) / 2;
+    int j = k - i;
+    if(j > 0 && i < a_n && !(b[j - 1] < a[i])){
+      lo = i + 1;
+    } else {
+      hi = i;
+    }
   }
+  return lo;
 }
 
 
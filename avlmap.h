@@ -2,7 +2,9 @@
 // NAME: Connor Goldschmidt
 // FILE: avlmap.h
 // DATE: Spring 2022
-// DESC: Impliments the AVLMap for the Map interface.
+// DESC: Impliments the AVLMap for the Map interface. Keys are ordered
+//       by a three-way Compare (see compare.h), so each level of a
+//       search makes one comparison.
 //---------------------------------------------------------------------------
 
 #ifndef AVLMAP_H
@@ -10,10 +12,14 @@
 
 #include "map.h"
 #include "arrayseq.h"
+#include "poolalloc.h"
+#include "compare.h"
+#include <type_traits>
 
 
-template<typename K, typename V>
-class AVLMap : public Map<K,V>
+template<typename K, typename V, template<typename> class Alloc = HeapAlloc,
+         typename Compare = ThreeWayCompare>
+class AVLMap final : public Map<K,V>
 {
 public:
 
@@ -53,6 +59,16 @@ public:
   // Expects key to not exist in map prior to insertion.
   void insert(const K& key, const V& value);
 
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
   // Shrinks the collection by removing the key-value pair with the
   // given key. Does not modify the collection if the collection does
   // not contain the key. Throws out_of_range if the given key is not
@@ -62,12 +78,57 @@ public:
   // Returns true if the key is in the collection, and false otherwise.
   bool contains(const K& key) const;
 
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Transparent lookups. When Compare has an is_transparent member
+  // (ThreeWayCompare does) these take any key it can order against a
+  // K, such as a std::string_view or const char* for a std::string
+  // key, without building a temporary K. See transparent_lookup_t in
+  // compare.h.
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  V& operator[](const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  const V& operator[](const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  bool contains(const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  V* find(const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  const V* find(const KeyLike& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
   // Returns the keys k in the collection such that k1 <= k <= k2
   ArraySeq<K> find_keys(const K& k1, const K& k2) const;
 
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
   // Returns the keys in the collection in ascending sorted order
   ArraySeq<K> sorted_keys() const;  
 
+  // Calls f(key, value) on each key-value pair in ascending key order
+  template<typename F>
+  void for_each(F f) const;
+
   // Gives the key (as an ouptput parameter) immediately after the
   // given key according to ascending sort order. Returns true if a
   // successor key exists, and false otherwise.
@@ -91,11 +152,15 @@ private:
 
   // node for linked-list separate chaining
   struct Node {
+    // builds a leaf with the key made from key and the value from args
+    template<typename KeyArg, typename... Args>
+    Node(KeyArg&& key, Args&&... args)
+      : key(std::forward<KeyArg>(key)), value(std::forward<Args>(args)...) {}
     K key;
     V value;
-    int height;
-    Node* left;
-    Node* right;
+    int height = 1;
+    Node* left = nullptr;
+    Node* right = nullptr;
   };
 
   // number of key-value pairs in map
@@ -104,25 +169,59 @@ private:
   // array of linked lists
   Node* root = nullptr;
 
+  // allocator for the nodes
+  Alloc<Node> nodes;
+
+  // three-way key comparator
+  Compare compare;
+
   // clean up the tree and reset count to zero given subtree root
   void clear(Node* st_root);
 
   // copy assignment helper
-  Node* copy(const Node* rhs_st_root) const;
+  Node* copy(const Node* rhs_st_root);
 
-  // insert helper
-  Node* insert(const K& key, const V& value, Node* st_root);
-  
-  // erase helper
-  Node* erase(const K& key, Node* st_root);
+  // deepest possible search path. An AVL tree of 2^31 nodes is at
+  // most 45 levels.
+  static const int max_depth = 64;
+
+  // walks back up a search path from path[depth - 1] to the root,
+  // updating heights and rebalancing, until a subtree's height is
+  // unchanged
+  void retrace(Node** path, int depth);
+
+  // returns the node with the key, or nullptr. The key can be any
+  // type Compare orders against K.
+  template<typename KeyLike>
+  Node* find_node(const KeyLike& key) const;
+
+  // descends to the key, recording the nodes passed in path. Returns
+  // the link to the key's node, or the null link where it would go.
+  Node** find_path(const K& key, Node** path, int& depth);
+
+  // hangs a new leaf off the given null link at the end of the path
+  void add_leaf(Node** link, Node* new_node, Node** path, int depth);
+
+  // removes the node the link points to, at the end of the path
+  void unlink(Node** link, Node** path, int depth);
 
   // find_keys helper
   void find_keys(const K& k1, const K& k2, const Node* st_root,
-                 ArraySeq<K>& keys) const;
+                 Sequence<K>& keys) const;
 
   // sorted_keys helper
   void sorted_keys(const Node* st_root, ArraySeq<K>& keys) const;
 
+  // for_each helper
+  template<typename F>
+  static void for_each(const Node* st_root, F& f);
+
+  // height of a subtree, 0 if empty
+  static int height(const Node* st_root);
+
+  // recomputes a node's height from its children
+  static void update_height(Node* st_root);
+
   // rotations
   Node* rotate_right(Node* k2);
   Node* rotate_left(Node* k2);
@@ -135,15 +234,15 @@ private:
 };
 
 
-template<typename K, typename V>
-void AVLMap<K,V>::print() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::print() const
 {
   print(std::string(""), root);
 }
 
 
-template<typename K, typename V>
-void AVLMap<K,V>::print(std::string indent, const Node* st_root) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::print(std::string indent, const Node* st_root) const
 {
   if (!st_root)
     return;
@@ -158,28 +257,28 @@ void AVLMap<K,V>::print(std::string indent, const Node* st_root) const
   }
 }
 
-template<typename K, typename V>
-AVLMap<K,V>::AVLMap()
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+AVLMap<K, V, Alloc, Compare>::AVLMap()
 {
 }
 
 //initalizes the copy constructor
-template<typename K, typename V>
-AVLMap<K,V>::AVLMap(const AVLMap& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+AVLMap<K, V, Alloc, Compare>::AVLMap(const AVLMap& rhs)
 {
   *this = rhs;
 }
 
 //initalizes the move constructor
-template<typename K, typename V>
-AVLMap<K,V>::AVLMap(AVLMap&& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+AVLMap<K, V, Alloc, Compare>::AVLMap(AVLMap&& rhs)
 {
   *this = std::move(rhs);
 }
 
 //initalizes the copy assignment
-template<typename K, typename V>
-AVLMap<K, V>& AVLMap<K, V>::operator=(const AVLMap& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+AVLMap<K, V, Alloc, Compare>& AVLMap<K, V, Alloc, Compare>::operator=(const AVLMap& rhs)
 {
   if(this != &rhs){
     clear();
@@ -190,13 +289,14 @@ AVLMap<K, V>& AVLMap<K, V>::operator=(const AVLMap& rhs)
 }
 
 //initalizes the move assignment
-template<typename K, typename V>
-AVLMap<K, V>& AVLMap<K, V>::operator=(AVLMap&& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+AVLMap<K, V, Alloc, Compare>& AVLMap<K, V, Alloc, Compare>::operator=(AVLMap&& rhs)
 {
   if(this != &rhs){
     clear();
     root = rhs.root;
     count = rhs.count;
+    nodes = std::move(rhs.nodes);
     rhs.count = 0;
     rhs.root = nullptr;
   }
@@ -204,22 +304,22 @@ AVLMap<K, V>& AVLMap<K, V>::operator=(AVLMap&& rhs)
 }
 
 //initalizes the destructor
-template<typename K, typename V>
-AVLMap<K, V>::~AVLMap()
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+AVLMap<K, V, Alloc, Compare>::~AVLMap()
 {
   clear();
 }
 
 //returns the number of nodes stored in the tree
-template<typename K, typename V>
-int AVLMap<K, V>::size() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+int AVLMap<K, V, Alloc, Compare>::size() const
 {
   return count; 
 }
 
 //returns true if the tree is empty, false if not
-template<typename K, typename V>
-bool AVLMap<K, V>::empty() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool AVLMap<K, V, Alloc, Compare>::empty() const
 {
   if(count == 0){
     return true;
@@ -229,157 +329,295 @@ bool AVLMap<K, V>::empty() const
 
 //given a valid key, returns the corrisponding key value
 //throws an out_of_range exception if key is invalid
-template<typename K, typename V>
-V& AVLMap<K, V>::operator[](const K& key)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+V& AVLMap<K, V, Alloc, Compare>::operator[](const K& key)
 {
-  Node* temp = root;
-  while(temp){
-    if(temp -> key == key){
-      return temp -> value;
-    }
-    if(key < temp -> key){
-      temp = temp -> left;
-    } else {
-      temp = temp -> right;
-    }
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator");
   }
-  throw std::out_of_range("Out of Range in Operator");
+  return *value;
 }
 
 //given a valid key, returns the corrisponding key value as a constant
 //throws an out_of_range exception if key is invalid
-template<typename K, typename V>
-const V& AVLMap<K, V>::operator[](const K& key) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+const V& AVLMap<K, V, Alloc, Compare>::operator[](const K& key) const
 {
-  Node* temp = root;
-  while(temp){
-    if(temp -> key == key){
-      return temp -> value;
-    }
-    if(key < temp -> key){
-      temp = temp -> left;
-    } else {
-      temp = temp -> right;
-    }
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator");
   }
-  throw std::out_of_range("Out of Range in Operator");
+  return *value;
 }
 
 //inserts the given key, value pair into a leaf node in the tree
-template<typename K, typename V>
-void AVLMap<K, V>::insert(const K& key, const V& value)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::insert(const K& key, const V& value)
 {
-  root = insert(key, value, root);
-  count++;
+  emplace(key, value);
+}
+
+//moves the given key, value pair into a leaf node in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::insert(K&& key, V&& value)
+{
+  emplace(std::move(key), std::move(value));
+}
+
+//constructs the pair in a new node, then descends to its leaf
+//position recording the nodes passed on the way down so the heights
+//can be fixed on the way back up
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyArg, typename... Args>
+void AVLMap<K, V, Alloc, Compare>::emplace(KeyArg&& key, Args&&... args)
+{
+  Node* new_node = nodes.create(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+  Node* path[max_depth];
+  int depth = 0;
+  Node** link = &root;
+  while(*link){
+    path[depth++] = *link;
+    if(compare(new_node -> key, (*link) -> key) < 0){
+      link = &(*link) -> left;
+    } else {
+      link = &(*link) -> right;
+    }
+  }
+  add_leaf(link, new_node, path, depth);
 }
 
 //removes the given key and corrisponding value pair from the tree
-template<typename K, typename V>
-void AVLMap<K, V>::erase(const K& key)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::erase(const K& key)
 {
-  if(empty() || !contains(key)){
+  if(!try_erase(key)){
     throw std::out_of_range("Out of Range in Erase");
   }
-  root = erase(key, root);
-  count--;
 }
 
 //returns true if given key is in the tree, false if not
-template<typename K, typename V>
-bool AVLMap<K, V>::contains(const K& key) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool AVLMap<K, V, Alloc, Compare>::contains(const K& key) const
 {
-  Node* temp = root;
-  while(temp){
-    if(temp -> key == key){
-      return true;
-    }
-    if(key < temp -> key){
-      temp = temp -> left;
-    } else {
-      temp = temp -> right;
-    }
+  return find_node(key) != nullptr;
+}
+
+//returns a pointer to the value of the given key, or nullptr if it is
+//not in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+V* AVLMap<K, V, Alloc, Compare>::find(const K& key)
+{
+  Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+//returns a constant pointer to the value of the given key, or nullptr
+//if it is not in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+const V* AVLMap<K, V, Alloc, Compare>::find(const K& key) const
+{
+  const Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+//transparent lookup, given a valid key-like value returns the
+//corrisponding key value. throws an out_of_range exception if it is
+//not a key in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+V& AVLMap<K, V, Alloc, Compare>::operator[](const KeyLike& key)
+{
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator");
   }
-  return false;
+  return *value;
+}
+
+//transparent lookup, given a valid key-like value returns the
+//corrisponding key value as a constant
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+const V& AVLMap<K, V, Alloc, Compare>::operator[](const KeyLike& key) const
+{
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator");
+  }
+  return *value;
+}
+
+//transparent lookup, returns true if a key equal to the given value
+//is in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+bool AVLMap<K, V, Alloc, Compare>::contains(const KeyLike& key) const
+{
+  return find_node(key) != nullptr;
+}
+
+//transparent lookup, returns a pointer to the value of the matching
+//key, or nullptr
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+V* AVLMap<K, V, Alloc, Compare>::find(const KeyLike& key)
+{
+  Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+//transparent lookup, returns a constant pointer to the value of the
+//matching key, or nullptr
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+const V* AVLMap<K, V, Alloc, Compare>::find(const KeyLike& key) const
+{
+  const Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+//replaces the value of the given key, or adds the pair as a new leaf
+//where the search for it ended. Returns true if the pair was added.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool AVLMap<K, V, Alloc, Compare>::insert_or_assign(const K& key, const V& value)
+{
+  Node* path[max_depth];
+  int depth = 0;
+  Node** link = find_path(key, path, depth);
+  if(*link){
+    (*link) -> value = value;
+    return false;
+  }
+  add_leaf(link, nodes.create(key, value), path, depth);
+  return true;
+}
+
+//adds the pair as a new leaf where the search for the key ended, if
+//the key was not found. Returns true if the pair was added.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool AVLMap<K, V, Alloc, Compare>::try_emplace(const K& key, const V& value)
+{
+  Node* path[max_depth];
+  int depth = 0;
+  Node** link = find_path(key, path, depth);
+  if(*link){
+    return false;
+  }
+  add_leaf(link, nodes.create(key, value), path, depth);
+  return true;
+}
+
+//removes the given key and corrisponding value pair if it is in the
+//tree. Returns true if a pair was removed.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool AVLMap<K, V, Alloc, Compare>::try_erase(const K& key)
+{
+  Node* path[max_depth];
+  int depth = 0;
+  Node** link = find_path(key, path, depth);
+  if(!*link){
+    return false;
+  }
+  unlink(link, path, depth);
+  return true;
 }
 
 //returns an ArraySeq of key values that are between k1 and k2
-template<typename K, typename V>
-ArraySeq<K> AVLMap<K, V>::find_keys(const K& k1, const K& k2) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+ArraySeq<K> AVLMap<K, V, Alloc, Compare>::find_keys(const K& k1, const K& k2) const
 {
   ArraySeq<K> keys;
   find_keys(k1, k2, root, keys);
   return keys;
 }
 
+//adds the key values that are between k1 and k2 to the given sequence
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
+  find_keys(k1, k2, root, keys);
+}
+
 //returns an array seq of all of the keys in sorted order
-template<typename K, typename V>
-ArraySeq<K> AVLMap<K, V>::sorted_keys() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+ArraySeq<K> AVLMap<K, V, Alloc, Compare>::sorted_keys() const
 {
   ArraySeq<K> keys;
+  keys.reserve(count);
   sorted_keys(root, keys);
   return keys;
 }
 
-//returns the next key value in the tree
-template<typename K, typename V>
-bool AVLMap<K, V>::next_key(const K& key, K& next_key) const
+//calls f on each key-value pair in ascending key order
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename F>
+void AVLMap<K, V, Alloc, Compare>::for_each(F f) const
 {
-  Node* temp = root;
-  K temp_next_key = key;
+  for_each(root, f);
+}
+
+//returns the next key value in the tree. The last node where the
+//search turned left is the smallest key larger than the given key.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool AVLMap<K, V, Alloc, Compare>::next_key(const K& key, K& next_key) const
+{
+  const Node* temp = root;
+  const Node* next = nullptr;
   while(temp){
-    if(temp -> key > key && (temp -> key < temp_next_key || temp_next_key == key)){
-      temp_next_key = temp -> key;
-    }
-    if(key < temp -> key){
+    if(compare(key, temp -> key) < 0){
+      next = temp;
       temp = temp -> left;
     } else {
       temp = temp -> right;
     }
   }
-  if(temp_next_key == key){
+  if(!next){
     return false;
-  } else {
-    next_key = temp_next_key;
-    return true;
   }
+  next_key = next -> key;
+  return true;
 }
 
-//returns the previous key value in the tree
-template<typename K, typename V>
-bool AVLMap<K, V>::prev_key(const K& key, K& prev_key) const
+//returns the previous key value in the tree. The last node where the
+//search turned right is the largest key smaller than the given key.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool AVLMap<K, V, Alloc, Compare>::prev_key(const K& key, K& prev_key) const
 {
-  Node* temp = root;
-  K temp_prev_key = key;
+  const Node* temp = root;
+  const Node* prev = nullptr;
   while(temp){
-    if(temp -> key < key && (temp -> key > temp_prev_key || temp_prev_key == key)){
-      temp_prev_key = temp -> key;
-    }
-    if(key <= temp -> key){
-      temp = temp -> left;
-    } else {
+    if(compare(temp -> key, key) < 0){
+      prev = temp;
       temp = temp -> right;
-    } 
+    } else {
+      temp = temp -> left;
+    }
   }
-  if(temp_prev_key == key){
+  if(!prev){
     return false;
-  } else {
-    prev_key = temp_prev_key;
-    return true;
   }
+  prev_key = prev -> key;
+  return true;
 }
 
-//deletes all of the values in the tree
-template<typename K, typename V>
-void AVLMap<K, V>::clear()
+//deletes all of the values in the tree. Pool allocated nodes that
+//need no destructor are dropped with their slabs instead of one at a
+//time.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::clear()
 {
-  clear(root);
+  if(!Alloc<Node>::bulk || !std::is_trivially_destructible<Node>::value){
+    clear(root);
+  }
+  nodes.release();
   count = 0;
   root = nullptr;
 }
 
 //returns the largest root to leaf path in the tree
-template<typename K, typename V>
-int AVLMap<K, V>::height() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+int AVLMap<K, V, Alloc, Compare>::height() const
 {
   if(!root){
     return 0;
@@ -388,188 +626,180 @@ int AVLMap<K, V>::height() const
 }
 
 //helper function for the clear method
-template<typename K, typename V>
-void AVLMap<K, V>::clear(Node* st_root)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::clear(Node* st_root)
 {
   if(!st_root){
     return;
   }
   clear(st_root -> left);
   clear(st_root -> right);
-  delete st_root;
-}
-
-//Helper function for the insert method
-template<typename K, typename V>
-typename AVLMap<K,V>::Node* AVLMap<K,V>::insert(const K& key, const V& value, Node* st_root)
-{
-  if(st_root == nullptr){
-    Node* new_node = new Node;
-    new_node -> key = key;
-    new_node -> value = value;
-    new_node -> height = 1;
-    new_node -> left = nullptr;
-    new_node -> right = nullptr;
-    st_root = new_node;
-  } else { 
-    if(key < st_root -> key){
-      st_root -> left = insert(key, value, st_root -> left);
-    } else {
-      st_root -> right = insert(key, value, st_root -> right);
+  nodes.destroy(st_root);
+}
+
+//Updates the heights along the path from the bottom up, rotating
+//where a node is out of balance. Once a node's height comes out the
+//same as before, none of its ancestors can change, so it stops there.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::retrace(Node** path, int depth)
+{
+  for(int i = depth - 1; i >= 0; i--){
+    Node* st_root = path[i];
+    int old_height = st_root -> height;
+    update_height(st_root);
+    Node* new_root = rebalance(st_root);
+    if(new_root != st_root){
+      if(i == 0){
+        root = new_root;
+      } else if(path[i - 1] -> left == st_root){
+        path[i - 1] -> left = new_root;
+      } else {
+        path[i - 1] -> right = new_root;
+      }
+    }
+    if(new_root -> height == old_height){
+      return;
     }
-    if(st_root -> left && st_root -> right){
-      st_root -> height = std::max(st_root -> left -> height, st_root -> right -> height) + 1;
-    } else if(st_root -> left){
-      st_root -> height = st_root -> left -> height + 1;
-    } else {
-      st_root -> height = st_root -> right -> height + 1;
-    } 
-    st_root = rebalance(st_root);
   }
-  return st_root;
+}
+
+//Walks down from the root with one three-way comparison per level
+//and returns the key's node, or nullptr if it is not in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike>
+typename AVLMap<K, V, Alloc, Compare>::Node* AVLMap<K, V, Alloc, Compare>::find_node(const KeyLike& key) const
+{
+  Node* temp = root;
+  while(temp){
+    int order = compare(key, temp -> key);
+    if(order == 0){
+      return temp;
+    }
+    temp = order < 0 ? temp -> left : temp -> right;
+  }
+  return nullptr;
+}
+
+//Walks down from the root towards the key and stops at its node or at
+//the empty link where it would be added
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+typename AVLMap<K, V, Alloc, Compare>::Node** AVLMap<K, V, Alloc, Compare>::find_path(const K& key, Node** path, int& depth)
+{
+  Node** link = &root;
+  while(*link){
+    int order = compare(key, (*link) -> key);
+    if(order == 0){
+      break;
+    }
+    path[depth++] = *link;
+    link = order < 0 ? &(*link) -> left : &(*link) -> right;
+  }
+  return link;
+}
+
+//Links a new node into the empty link and rebalances up the path
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::add_leaf(Node** link, Node* new_node, Node** path, int depth)
+{
+  *link = new_node;
+  count++;
+  retrace(path, depth);
+}
+
+//Removes the node from the tree. A node with two children takes its
+//in-order successor's pair and the successor is unlinked instead,
+//extending the path down to it.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::unlink(Node** link, Node** path, int depth)
+{
+  Node* temp = *link;
+  if(temp -> left && temp -> right){
+    path[depth++] = temp;
+    link = &temp -> right;
+    while((*link) -> left){
+      path[depth++] = *link;
+      link = &(*link) -> left;
+    }
+    Node* successor = *link;
+    temp -> key = std::move(successor -> key);
+    temp -> value = std::move(successor -> value);
+    temp = successor;
+  }
+  *link = temp -> left ? temp -> left : temp -> right;
+  nodes.destroy(temp);
+  count--;
+  retrace(path, depth);
+}
+
+//returns the height of the subtree, 0 for an empty one
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+int AVLMap<K, V, Alloc, Compare>::height(const Node* st_root)
+{
+  return st_root ? st_root -> height : 0;
+}
+
+//sets the node's height to one more than its taller child
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::update_height(Node* st_root)
+{
+  st_root -> height = std::max(height(st_root -> left), height(st_root -> right)) + 1;
 }
 
 //Rotates the given node to the right
-template<typename K, typename V>
-typename AVLMap<K,V>::Node* AVLMap<K,V>::rotate_right(Node* k2)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+typename AVLMap<K, V, Alloc, Compare>::Node* AVLMap<K, V, Alloc, Compare>::rotate_right(Node* k2)
 {
   Node* k1 = k2 -> left;
-	k2 -> left = k1 -> right;
-	k1 -> right = k2;
-	return k1;
+  k2 -> left = k1 -> right;
+  k1 -> right = k2;
+  update_height(k2);
+  update_height(k1);
+  return k1;
 }
 
 //Rotates the given node to the left
-template<typename K, typename V>
-typename AVLMap<K,V>::Node* AVLMap<K,V>::rotate_left(Node* k2)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+typename AVLMap<K, V, Alloc, Compare>::Node* AVLMap<K, V, Alloc, Compare>::rotate_left(Node* k2)
 {
   Node* k1 = k2 -> right;
-	k2 -> right = k1 -> left;
-	k1 -> left = k2;
-	return k1;
+  k2 -> right = k1 -> left;
+  k1 -> left = k2;
+  update_height(k2);
+  update_height(k1);
+  return k1;
 }
 
-//Balances the given node to a balance factor that is greater than -1 and less than 1
-//then updates the height of the nodes
-template<typename K, typename V>
-typename AVLMap<K,V>::Node* AVLMap<K,V>::rebalance(Node* st_root)
+//Balances the given node to a balance factor that is greater than -1 and less than 1,
+//with a double rotation when the taller child leans the other way
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+typename AVLMap<K, V, Alloc, Compare>::Node* AVLMap<K, V, Alloc, Compare>::rebalance(Node* st_root)
 {
-  Node* left_child = st_root -> left;
-  Node* right_child = st_root -> right;
-  if(left_child && !right_child && left_child -> height > 1){
-    if(left_child -> right){
+  int balance_factor = height(st_root -> left) - height(st_root -> right);
+  if(balance_factor > 1){
+    Node* left_child = st_root -> left;
+    if(height(left_child -> left) < height(left_child -> right)){
       st_root -> left = rotate_left(left_child);
     }
     st_root = rotate_right(st_root);
-  } else if(!left_child && right_child && right_child -> height > 1){
-    if(right_child -> left){
-        st_root -> right = rotate_right(right_child);
-      }
-    st_root = rotate_left(st_root);
-  } else if(left_child && right_child){
-    int balance_factor = left_child -> height - right_child -> height;
-    if(balance_factor > 1){
-      if(left_child -> right && (!left_child -> left || left_child -> left -> height < left_child -> right -> height)){
-        st_root -> left = rotate_left(left_child);
-      } 
-      st_root = rotate_right(st_root);
-    } else if(balance_factor < -1){
-      if(right_child -> left && (!right_child -> right || right_child -> left -> height > right_child -> right -> height)){
-        st_root -> right = rotate_right(right_child);
-      }
-      st_root = rotate_left(st_root);
-    }
-  }
-  if(st_root -> left){
-    if(st_root -> left -> right && st_root -> left -> left){
-      st_root -> left -> height = std::max(st_root -> left -> left -> height, st_root -> left -> right -> height) + 1;
-    } else if(st_root -> left -> right){
-      st_root -> left -> height = st_root -> left -> right -> height + 1;
-    } else if(st_root -> left -> left){
-      st_root -> left -> height = st_root -> left -> left -> height + 1;
-    } else {
-      st_root -> left -> height = 1;
-    }
-  }
-  if(st_root -> right){
-    if(st_root -> right -> right && st_root -> right -> left){
-      st_root -> right -> height = std::max(st_root -> right -> left -> height, st_root -> right -> right -> height) + 1;
-    } else if(st_root -> right -> right){
-      st_root -> right -> height = st_root -> right -> right -> height + 1;
-    } else if(st_root -> right -> left){
-      st_root -> right -> height = st_root -> right -> left -> height + 1;
-    } else {
-      st_root -> right -> height = 1;
-    }
-  }
-  if(st_root -> left && st_root -> right){
-    st_root -> height = std::max(st_root -> left -> height, st_root -> right -> height) + 1;
-  }else if(st_root -> left){
-    st_root -> height = st_root -> left -> height + 1;
-  } else if(st_root -> right){
-    st_root -> height = st_root -> right -> height + 1;
-  } 
-  return st_root;
-}
-
-//Helper function for the erase method
-template<typename K, typename V>
-typename AVLMap<K,V>::Node* AVLMap<K,V>::erase(const K& key, Node* st_root)
-{
-  if(!st_root){
-    return nullptr;
-  }
-  if(key < st_root -> key ){
-    st_root -> left = erase(key, st_root -> left);
-  } else if(key > st_root -> key){
-    st_root -> right = erase(key, st_root -> right);
-  } else {
-    if(st_root -> left == nullptr && st_root -> right == nullptr){
-      delete st_root;
-      st_root = nullptr;
-    } else if(st_root -> left == nullptr){
-      Node* temp = st_root;
-      st_root = st_root -> right;
-      delete temp;
-    } else if(st_root -> right == nullptr){
-      Node* temp = st_root;
-      st_root = st_root -> left;
-      delete temp;
-    } else {
-      Node* temp = st_root -> right;
-      while(temp -> left){
-        temp = temp -> left;
-      }
-      st_root -> key = temp -> key;
-      st_root -> value = temp -> value;
-      st_root -> right = erase(temp -> key, st_root -> right);
+  } else if(balance_factor < -1){
+    Node* right_child = st_root -> right;
+    if(height(right_child -> right) < height(right_child -> left)){
+      st_root -> right = rotate_right(right_child);
     }
+    st_root = rotate_left(st_root);
   }
-  if(st_root){
-    if(st_root -> left && st_root -> right){
-      st_root -> height = std::max(st_root -> left -> height, st_root -> right -> height) + 1;
-    } else if(st_root -> left){
-      st_root -> height = st_root -> left -> height + 1;
-    } else if(st_root -> right){
-      st_root -> height = st_root -> right -> height + 1;
-    } else {
-      st_root -> height = 1;
-    }
-    st_root = rebalance(st_root);
-  } 
   return st_root;
 }
 
 //returns the root of the copied tree
-template<typename K, typename V>
-typename AVLMap<K,V>::Node* AVLMap<K, V>::copy(const Node* rhs_st_root) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+typename AVLMap<K, V, Alloc, Compare>::Node* AVLMap<K, V, Alloc, Compare>::copy(const Node* rhs_st_root)
 {
   if(!rhs_st_root){
     return nullptr;
   } else {
-    Node* new_node = new Node;
-    new_node -> key = rhs_st_root -> key;
-    new_node -> value = rhs_st_root -> value;
+    Node* new_node = nodes.create(rhs_st_root -> key, rhs_st_root -> value);
+    new_node -> height = rhs_st_root -> height;
     new_node -> left = copy(rhs_st_root -> left);
     new_node -> right = copy(rhs_st_root -> right);
     return new_node;
@@ -577,31 +807,45 @@ typename AVLMap<K,V>::Node* AVLMap<K, V>::copy(const Node* rhs_st_root) const
 }
 
 //helper function for the find_keys method
-template<typename K, typename V>
-void AVLMap<K, V>::find_keys(const K& k1, const K& k2, const Node* st_root, ArraySeq<K>& keys) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::find_keys(const K& k1, const K& k2, const Node* st_root, Sequence<K>& keys) const
 {
   if(st_root){
-    if(k1 <= st_root -> key){
+    int low = compare(k1, st_root -> key);
+    int high = compare(k2, st_root -> key);
+    if(low <= 0){
       find_keys(k1, k2, st_root -> left, keys);
     }
-    if(k2 >= st_root -> key && k1 <= st_root -> key){
+    if(high >= 0 && low <= 0){
       keys.insert(st_root -> key, keys.size());
     }
-    if(k2 >= st_root -> key){
+    if(high >= 0){
       find_keys(k1, k2, st_root -> right, keys);
     }
   }
 }
 
 //helper function for the sorted_keys method
-template<typename K, typename V>
-void AVLMap<K, V>::sorted_keys(const Node* st_root, ArraySeq<K>& keys) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void AVLMap<K, V, Alloc, Compare>::sorted_keys(const Node* st_root, ArraySeq<K>& keys) const
 {
   if(st_root){
     sorted_keys(st_root -> left, keys);
-    keys.insert(st_root -> key, keys.size());
+    keys.push_back(st_root -> key);
     sorted_keys(st_root -> right, keys);
   }
 }
 
+//calls f on each pair of the subtree with an in-order walk
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename F>
+void AVLMap<K, V, Alloc, Compare>::for_each(const Node* st_root, F& f)
+{
+  if(st_root){
+    for_each(st_root -> left, f);
+    f(st_root -> key, st_root -> value);
+    for_each(st_root -> right, f);
+  }
+}
+
 #endif
\ No newline at end of file
@@ -3,6 +3,19 @@
 // FILE: binsearchmap.h
 // DATE: 3/21/22
 // DESC: Impliments the Map interface and utilizes the binary search algorithm.
+//       Keys and values are kept in separate arrays so searches only
+//       touch keys. The pairs are held in sorted runs: the main run,
+//       a small sorted write buffer that new pairs go into, and the
+//       runs the full write buffer has been flushed into. A run is
+//       merged with the one before it, in one linear pass, once it
+//       is at least half that run's size, so run sizes fall off
+//       geometrically, there are O(log n) of them, and n inserts move
+//       each pair O(log n) times. Erased pairs are marked with
+//       tombstones and dropped by the merges. Lookups binary search
+//       each run. The arrays are ArraySeqs by default; Seq can be any
+//       sequence that also has push_back, reserve, insert_range and
+//       data, such as a GapSeq. Keys are ordered by a three-way
+//       Compare (see compare.h).
 //---------------------------------------------------------------------------
 
 #ifndef BINSEARCHMAP_H
@@ -10,10 +23,25 @@
 
 #include "map.h"
 #include "arrayseq.h"
+#include "compare.h"
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 
-template<typename K, typename V>
-class BinSearchMap : public Map<K,V>
+// true if a const S has data(), as ArraySeq does and GapSeq does not
+template<typename S, typename = void>
+struct has_const_data : std::false_type {};
+
+template<typename S>
+struct has_const_data<S, std::void_t<decltype(std::declval<const S&>().data())>>
+  : std::true_type {};
+
+
+template<typename K, typename V, template<typename> class Seq = ArraySeq,
+         typename Compare = ThreeWayCompare>
+class BinSearchMap final : public Map<K,V>
 {
 public:
 
@@ -36,6 +64,16 @@ public:
   // collection. Insert does not check if the key is present.
   void insert(const K& key, const V& value);
 
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
   // Shrinks the collection by removing the key-value pair with the
   // given key. Does not modify the collection if the collection does
   // not contain the key. Throws out_of_range if the given key is not
@@ -46,12 +84,57 @@ public:
   // otherwise.
   bool contains(const K& key) const;
 
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Transparent lookups. When Compare has an is_transparent member
+  // (ThreeWayCompare does) these take any key it can order against a
+  // K, such as a std::string_view or const char* for a std::string
+  // key, without building a temporary K. See transparent_lookup_t in
+  // compare.h.
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  V& operator[](const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  const V& operator[](const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  bool contains(const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  V* find(const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  const V* find(const KeyLike& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
   // Returns the keys k in the collection such that k1 <= k <= k2
   ArraySeq<K> find_keys(const K& k1, const K& k2) const;
 
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
   // Returns the keys in the collection in ascending sorted order.
   ArraySeq<K> sorted_keys() const;
 
+  // Calls f(key, value) on each key-value pair in ascending key order
+  template<typename F>
+  void for_each(F f) const;
+
   // Gives the key (as an ouptput parameter) immediately after the
   // given key according to ascending sort order. Returns true if a
   // successor key exists, and false otherwise.
@@ -64,201 +147,793 @@ public:
 
   // Removes all key-value pairs from the map.
   void clear();
+
+  // Merges the write buffer and every run into the main run and
+  // removes the pairs marked as erased. Called automatically once the
+  // runs are half the size of the main run, or half of the stored
+  // pairs are erased.
+  void merge();
   
 
 private:
 
-  // If the key is in the collection, bin_search returns true and
-  // provides the key's index within the array sequence (via the index
-  // output parameter). If the key is not in the collection,
-  // bin_search returns false and provides the last index checked by
-  // the binary search algorithm. 
-  bool bin_search(const K& key, int& index) const;
-  
-  // implemented as a resizable array of (key-value) pairs
-  ArraySeq<std::pair<K,V>> seq;
+  // number of pairs the write buffer holds before it is flushed into
+  // a run
+  static const int buffer_size = 64;
+
+  // a sorted run of pairs. erased holds the run's tombstones and is
+  // left empty until a pair of the run is first erased. The move
+  // constructor is noexcept so the run list moves runs, rather than
+  // copying them, when it grows.
+  struct Run
+  {
+    Run() = default;
+    Run(const Run&) = default;
+    Run(Run&& rhs) noexcept
+      : keys(std::move(rhs.keys)), vals(std::move(rhs.vals)),
+        erased(std::move(rhs.erased)), tombstones(rhs.tombstones) {}
+    Run& operator=(const Run&) = default;
+    Run& operator=(Run&&) = default;
+    Seq<K> keys;
+    Seq<V> vals;
+    Seq<bool> erased;
+    int tombstones = 0;
+  };
+
+  // position in one run while walking the runs in key order, over the
+  // indexes [index, end)
+  struct Cursor
+  {
+    const Run* run;
+    int index;
+    int end;
+  };
+
+  // If the key is in the given sorted key sequence, bin_search returns
+  // true and provides the key's index within the sequence (via the
+  // index output parameter). If the key is not in the sequence,
+  // bin_search returns false and provides the index where the key
+  // would be inserted. The key can be any type Compare orders
+  // against K.
+  template<typename KeyLike>
+  bool bin_search(const Seq<K>& keys, const KeyLike& key, int& index) const;
+
+  // The runs are numbered 0 for the write buffer, 1 for the main run,
+  // and from 2 on for the flushed runs, oldest first. part returns
+  // the run with the given number, and parts how many there are.
+  int parts() const;
+  Run& part(int number);
+  const Run& part(int number) const;
+
+  // returns the number of unerased pairs in a run
+  static int live(const Run& run);
+
+  // returns true if the pair at index in the run has been erased
+  static bool is_erased(const Run& run, int index);
+
+  // Finds the key, preferring an unerased copy to an erased one (a
+  // key can be erased in one run and added again to a later one).
+  // Returns true and gives the run number and index if there is a
+  // copy of the key, false otherwise.
+  template<typename KeyLike>
+  bool locate(const KeyLike& key, int& number, int& index) const;
+
+  // returns the value of the key's unerased pair, or nullptr
+  template<typename KeyLike>
+  V* find_value(const KeyLike& key);
+  template<typename KeyLike>
+  const V* find_value(const KeyLike& key) const;
+
+  // adds a pair whose key is not in the map, appending it to the main
+  // run when possible and otherwise inserting it into the write
+  // buffer. The value is constructed from args.
+  template<typename... Args>
+  void add(K&& key, Args&&... args);
+
+  // marks the pair at index in the run erased, merging once half of
+  // the stored pairs are erased
+  void mark_erased(Run& run, int index);
+
+  // brings back the erased pair at index in the run
+  void revive(Run& run, int index);
+
+  // moves the write buffer into a new run, then merges the newest
+  // runs while a run is at least half the size of the one before it
+  void flush();
+
+  // returns a run of the unerased pairs of a and b, moved out of them
+  Run merge_runs(Run& a, Run& b);
+
+  // opens a cursor on each run over the keys k such that
+  // k1 <= k <= k2, or over every key if k1 and k2 are null
+  void open_cursors(std::vector<Cursor>& cursors, const K* k1, const K* k2) const;
+
+  // skips erased pairs and returns the cursor on the smallest key, or
+  // -1 once every cursor is at its end
+  int next_cursor(std::vector<Cursor>& cursors) const;
+
+  // appends main.keys[start, end) to keys, in one block copy when a
+  // const Seq has data() and one key at a time otherwise (a GapSeq
+  // cannot move its gap from a const member)
+  void append_keys(ArraySeq<K>& keys, int start, int end) const;
+
+  // true if every pair is in the main run and none are erased, when
+  // the key range functions can copy keys straight from it
+  bool only_main() const;
+
+  // the write buffer (always free of tombstones) and the main run
+  Run buffer;
+  Run main;
+
+  // flushed write buffers, oldest first, each less than half the size
+  // of the one before it
+  std::vector<Run> runs;
+
+  // number of unerased pairs
+  int count = 0;
+
+  // number of erased pairs still in the runs
+  int tombstones = 0;
+
+  // three-way key comparator
+  Compare compare;
 
 };
 
-//Returns true if the given key is contained in the list. 
-//Updates the index parameter with the idex of the given key.
-//Returns false if the key is not contained in the Map.
-template<typename K, typename V>
-bool BinSearchMap<K, V>::bin_search(const K& key, int& index) const
+//Returns true if the given key is contained in the sequence.
+//Updates the index parameter with the index of the given key, or
+//with the index it would be inserted at if not in the sequence.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike>
+bool BinSearchMap<K, V, Seq, Compare>::bin_search(const Seq<K>& keys, const KeyLike& key,
+                                    int& index) const
 {
   int start = 0;
-  int end = size() - 1;
+  int end = keys.size() - 1;
   int mid;
   while(start <= end){
     mid = (start + end) / 2;
-    if(key == seq[mid].first){
+    int order = compare(key, keys[mid]);
+    if(order == 0){
       index = mid;
       return true;
-    }else if(key < seq[mid].first){
+    }else if(order < 0){
       end = mid - 1;
     } else {
       start = mid + 1;
     }
   }
+  index = start;
   return false;
 }
 
+//Returns the number of runs, counting the write buffer and main run
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+int BinSearchMap<K, V, Seq, Compare>::parts() const
+{
+  return runs.size() + 2;
+}
+
+//Returns the run with the given number
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+typename BinSearchMap<K, V, Seq, Compare>::Run& BinSearchMap<K, V, Seq, Compare>::part(int number)
+{
+  if(number == 0){
+    return buffer;
+  } else if(number == 1){
+    return main;
+  }
+  return runs[number - 2];
+}
+
+//Returns the run with the given number as a constant
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+const typename BinSearchMap<K, V, Seq, Compare>::Run& BinSearchMap<K, V, Seq, Compare>::part(int number) const
+{
+  if(number == 0){
+    return buffer;
+  } else if(number == 1){
+    return main;
+  }
+  return runs[number - 2];
+}
+
+//Returns the number of pairs in the run that are not erased
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+int BinSearchMap<K, V, Seq, Compare>::live(const Run& run)
+{
+  return run.keys.size() - run.tombstones;
+}
+
+//Returns true if the pair at the index has a tombstone
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::is_erased(const Run& run, int index)
+{
+  return run.tombstones > 0 && run.erased[index];
+}
+
+//Searches the write buffer, then the flushed runs newest first, then
+//the main run. Stops at the first unerased copy of the key.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike>
+bool BinSearchMap<K, V, Seq, Compare>::locate(const KeyLike& key, int& number, int& index) const
+{
+  bool found = false;
+  for(int i = 0; i < parts(); i++){
+    int p = i == 0 ? 0 : parts() - i;
+    int at;
+    if(bin_search(part(p).keys, key, at)){
+      if(!is_erased(part(p), at)){
+        number = p;
+        index = at;
+        return true;
+      }
+      if(!found){
+        number = p;
+        index = at;
+        found = true;
+      }
+    }
+  }
+  return found;
+}
+
+//Returns a pointer to the value of the key's unerased pair, or
+//nullptr if the key is not in the map
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike>
+V* BinSearchMap<K, V, Seq, Compare>::find_value(const KeyLike& key)
+{
+  int number, index;
+  if(locate(key, number, index) && !is_erased(part(number), index)){
+    return &part(number).vals[index];
+  }
+  return nullptr;
+}
+
+//Returns a constant pointer to the value of the key's unerased pair,
+//or nullptr if the key is not in the map
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike>
+const V* BinSearchMap<K, V, Seq, Compare>::find_value(const KeyLike& key) const
+{
+  int number, index;
+  if(locate(key, number, index) && !is_erased(part(number), index)){
+    return &part(number).vals[index];
+  }
+  return nullptr;
+}
+
+//Adds the pair. Keys larger than every other key are appended to the
+//main run directly, all others go into the sorted write buffer, which
+//is flushed once it is full.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename... Args>
+void BinSearchMap<K, V, Seq, Compare>::add(K&& key, Args&&... args)
+{
+  count++;
+  if(buffer.keys.empty() && runs.empty() &&
+     (main.keys.empty() || compare(main.keys[main.keys.size() - 1], key) < 0)){
+    main.keys.push_back(std::move(key));
+    main.vals.emplace_back(std::forward<Args>(args)...);
+    if(!main.erased.empty()){
+      main.erased.push_back(false);
+    }
+    return;
+  }
+  int index;
+  bin_search(buffer.keys, key, index);
+  buffer.keys.emplace(index, std::move(key));
+  buffer.vals.emplace(index, std::forward<Args>(args)...);
+  if(buffer.keys.size() >= buffer_size){
+    flush();
+  }
+}
+
+//Marks the pair erased. The tombstone array of the run is filled in
+//one pass the first time one of its pairs is erased.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::mark_erased(Run& run, int index)
+{
+  if(run.erased.empty()){
+    run.erased.reserve(run.keys.size());
+    for(int i = 0; i < run.keys.size(); i++){
+      run.erased.push_back(false);
+    }
+  }
+  run.erased[index] = true;
+  run.tombstones++;
+  tombstones++;
+  count--;
+  if(tombstones > buffer_size && tombstones > count){
+    merge();
+  }
+}
+
+//Clears the tombstone of the pair
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::revive(Run& run, int index)
+{
+  run.erased[index] = false;
+  run.tombstones--;
+  tombstones--;
+  count++;
+}
+
+//Turns the full write buffer into the newest run. Merging a run into
+//the one before it once it is at least half that size keeps the run
+//sizes falling off geometrically, so each pair is merged O(log n)
+//times. The runs are merged into the main run on the same rule.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::flush()
+{
+  runs.push_back(std::move(buffer));
+  buffer = Run();
+  while(runs.size() >= 2 && 2 * live(runs.back()) >= live(runs[runs.size() - 2])){
+    Run merged = merge_runs(runs[runs.size() - 2], runs.back());
+    runs.pop_back();
+    runs.back() = std::move(merged);
+  }
+  if(2 * live(runs.front()) >= live(main)){
+    merge();
+  }
+}
+
+//Merges the unerased pairs of two runs in one linear pass. Runs of
+//pairs from one side are moved over as blocks when Seq has data().
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+typename BinSearchMap<K, V, Seq, Compare>::Run BinSearchMap<K, V, Seq, Compare>::merge_runs(Run& a, Run& b)
+{
+  Run merged;
+  merged.keys.reserve(live(a) + live(b));
+  merged.vals.reserve(live(a) + live(b));
+  int i = 0;
+  int j = 0;
+  while(i < a.keys.size() || j < b.keys.size()){
+    if(i < a.keys.size() && is_erased(a, i)){
+      i++;
+    } else if(j < b.keys.size() && is_erased(b, j)){
+      j++;
+    } else if(j == b.keys.size() ||
+              (i < a.keys.size() && compare(a.keys[i], b.keys[j]) < 0)){
+      merged.keys.push_back(std::move(a.keys[i]));
+      merged.vals.push_back(std::move(a.vals[i++]));
+    } else {
+      merged.keys.push_back(std::move(b.keys[j]));
+      merged.vals.push_back(std::move(b.vals[j++]));
+    }
+  }
+  tombstones -= a.tombstones + b.tombstones;
+  return merged;
+}
+
+//Opens a cursor on each run. Without bounds a cursor covers the whole
+//run, with them it covers the keys from k1 through k2.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::open_cursors(std::vector<Cursor>& cursors, const K* k1,
+                                                    const K* k2) const
+{
+  cursors.reserve(parts());
+  for(int p = 0; p < parts(); p++){
+    const Run& run = part(p);
+    int start = 0;
+    int end = run.keys.size();
+    if(k1){
+      bin_search(run.keys, *k1, start);
+      if(bin_search(run.keys, *k2, end)){
+        end++;
+      }
+    }
+    if(start < end){
+      cursors.push_back({&run, start, end});
+    }
+  }
+}
+
+//Returns the cursor whose next unerased key is smallest
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+int BinSearchMap<K, V, Seq, Compare>::next_cursor(std::vector<Cursor>& cursors) const
+{
+  int best = -1;
+  for(int c = 0; c < (int) cursors.size(); c++){
+    Cursor& cursor = cursors[c];
+    while(cursor.index < cursor.end && is_erased(*cursor.run, cursor.index)){
+      cursor.index++;
+    }
+    if(cursor.index < cursor.end &&
+       (best == -1 || compare(cursor.run -> keys[cursor.index],
+                              cursors[best].run -> keys[cursors[best].index]) < 0)){
+      best = c;
+    }
+  }
+  return best;
+}
+
+//Appends the main run keys in [start, end) to keys. Reads a GapSeq
+//around its gap rather than moving it, so const calls never write to
+//the sequence.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::append_keys(ArraySeq<K>& keys, int start, int end) const
+{
+  if(start >= end){
+    return;
+  }
+  if constexpr(has_const_data<Seq<K>>::value){
+    keys.insert_range(keys.size(), main.keys.data() + start, main.keys.data() + end);
+  } else {
+    keys.reserve(keys.size() + end - start);
+    for(int i = start; i < end; i++){
+      keys.push_back(main.keys[i]);
+    }
+  }
+}
+
+//Returns true if the main run holds every pair
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::only_main() const
+{
+  return buffer.keys.empty() && runs.empty() && main.tombstones == 0;
+}
+
 //Returns the size of the current BinSearchMap
-template<typename K, typename V>
-int BinSearchMap<K, V>::size() const
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+int BinSearchMap<K, V, Seq, Compare>::size() const
 {
-  return seq.size();
+  return count;
 }
 
 //Returns true if the current BinSearchMap is empty, false if not
-template<typename K, typename V>
-bool BinSearchMap<K, V>::empty() const
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::empty() const
 {
-  return seq.empty();
+  return count == 0;
 }
 
 //Returns the assocated value pair of the input key, 
 //throws an out_of_range exception if key is not contained 
 //in the BinSearchMap 
-template<typename K, typename V>
-V& BinSearchMap<K, V>::operator[](const K& key)
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+V& BinSearchMap<K, V, Seq, Compare>::operator[](const K& key)
 {
-  int index;
-  if(bin_search(key, index)){
-    return seq[index].second;
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator BinSearchMap"); 
   }
-  throw std::out_of_range("Out of Range in Operator BinSearchMap"); 
+  return *value;
 }
 
 //Returns the assocated value pair of the input key, 
 //throws an out_of_range exception if key is not contained 
 //in the BinSearchMap 
-template<typename K, typename V>
-const V& BinSearchMap<K, V>::operator[](const K& key) const
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+const V& BinSearchMap<K, V, Seq, Compare>::operator[](const K& key) const
 {
-  int index;
-  if(bin_search(key, index)){
-    return seq[index].second;
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator BinSearchMap"); 
   }
-  throw std::out_of_range("Out of Range in Operator BinSearchMap"); 
+  return *value;
 }
 
-//Inserts the given key value pair in the BinSearchMap
-template<typename K, typename V>
-void BinSearchMap<K, V>::insert(const K& key, const V& value)
+//Inserts the given key value pair, at its place in the write buffer
+//unless it can be appended to the main run
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::insert(const K& key, const V& value)
 {
-  if(empty() || seq[size() - 1].first < key){
-    seq.insert(std::make_pair(key, value), size());
-  } else if(seq[0].first > key){
-    seq.insert(std::make_pair(key, value), 0);
-  } else {
-    K previous;
-    int index;
-    prev_key(key, previous);
-    bin_search(previous, index);
-    seq.insert(std::make_pair(key, value), index + 1);
-  }
+  emplace(key, value);
+}
+
+//Moves the given key value pair into the BinSearchMap
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::insert(K&& key, V&& value)
+{
+  emplace(std::move(key), std::move(value));
+}
+
+//Constructs the pair at its place in the write buffer unless it can
+//be appended to the main run. The key is built first so the buffer
+//search compares against a K.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyArg, typename... Args>
+void BinSearchMap<K, V, Seq, Compare>::emplace(KeyArg&& key, Args&&... args)
+{
+  add(K(std::forward<KeyArg>(key)), std::forward<Args>(args)...);
 }
 
 //Removes the key value pair of the given key in the BinSearchMap,
 //throws an out_of_range exception if key is not in the list
-template<typename K, typename V>
-void BinSearchMap<K, V>::erase(const K& key)
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::erase(const K& key)
 {
-  int index;
-  if(!bin_search(key, index)){
+  if(!try_erase(key)){
     throw std::out_of_range("Out of Range in Erase"); 
   }
-  seq.erase(index);
 }
 
 //Returns true if the given key is found in the BinSearchMap, false if not
-template<typename K, typename V>
-bool BinSearchMap<K, V>::contains(const K& key) const
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::contains(const K& key) const
 {
-  int index;
-  return bin_search(key, index);
+  return find_value(key) != nullptr;
+}
+
+//Returns a pointer to the value of the given key, or nullptr if the
+//key is not in the BinSearchMap
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+V* BinSearchMap<K, V, Seq, Compare>::find(const K& key)
+{
+  return find_value(key);
+}
+
+//Returns a constant pointer to the value of the given key, or nullptr
+//if the key is not in the BinSearchMap
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+const V* BinSearchMap<K, V, Seq, Compare>::find(const K& key) const
+{
+  return find_value(key);
+}
+
+//transparent lookup, given a valid key-like value returns the
+//corrisponding key value. throws an out_of_range exception if it is
+//not a key in the tree
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike, typename>
+V& BinSearchMap<K, V, Seq, Compare>::operator[](const KeyLike& key)
+{
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator BinSearchMap");
+  }
+  return *value;
+}
+
+//transparent lookup, given a valid key-like value returns the
+//corrisponding key value as a constant
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike, typename>
+const V& BinSearchMap<K, V, Seq, Compare>::operator[](const KeyLike& key) const
+{
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator BinSearchMap");
+  }
+  return *value;
+}
+
+//transparent lookup, returns true if a key equal to the given value
+//is in the tree
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike, typename>
+bool BinSearchMap<K, V, Seq, Compare>::contains(const KeyLike& key) const
+{
+  return find_value(key) != nullptr;
+}
+
+//transparent lookup, returns a pointer to the value of the matching
+//key, or nullptr
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike, typename>
+V* BinSearchMap<K, V, Seq, Compare>::find(const KeyLike& key)
+{
+  return find_value(key);
+}
+
+//transparent lookup, returns a constant pointer to the value of the
+//matching key, or nullptr
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename KeyLike, typename>
+const V* BinSearchMap<K, V, Seq, Compare>::find(const KeyLike& key) const
+{
+  return find_value(key);
+}
+
+//Replaces the value of the given key if it is in the BinSearchMap,
+//otherwise adds the pair. An erased copy of the key still in a run
+//is brought back in place instead of buffering a new pair. Returns
+//true if the pair was added.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::insert_or_assign(const K& key, const V& value)
+{
+  int number, index;
+  if(locate(key, number, index)){
+    Run& run = part(number);
+    run.vals[index] = value;
+    if(!is_erased(run, index)){
+      return false;
+    }
+    revive(run, index);
+    return true;
+  }
+  add(K(key), value);
+  return true;
+}
+
+//Adds the pair if the key is not in the BinSearchMap, reusing an
+//erased copy of the key in a run if there is one. Returns true if
+//the pair was added.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::try_emplace(const K& key, const V& value)
+{
+  int number, index;
+  if(locate(key, number, index)){
+    Run& run = part(number);
+    if(!is_erased(run, index)){
+      return false;
+    }
+    run.vals[index] = value;
+    revive(run, index);
+    return true;
+  }
+  add(K(key), value);
+  return true;
+}
+
+//Removes the key value pair of the given key from the write buffer,
+//or marks it erased in its run. Returns false if the key is not in
+//the BinSearchMap.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::try_erase(const K& key)
+{
+  int number, index;
+  if(!locate(key, number, index) || is_erased(part(number), index)){
+    return false;
+  }
+  if(number == 0){
+    buffer.keys.erase(index);
+    buffer.vals.erase(index);
+    count--;
+  } else {
+    mark_erased(part(number), index);
+  }
+  return true;
 }
 
 //Returns all of the keys between or equal to the values of k1 and k2
-template<typename K, typename V>
-ArraySeq<K> BinSearchMap<K, V>::find_keys(const K& k1, const K& k2) const
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+ArraySeq<K> BinSearchMap<K, V, Seq, Compare>::find_keys(const K& k1, const K& k2) const
 {
   ArraySeq<K> keys;
-  int index;
-  if(!empty() && k1 <= seq[size() - 1].first){
-    if(k1 < seq[0].first){
-      index = 0;
-    } 
-    bin_search(k1, index);
-    while(index < size() && seq[index].first <= k2){
-      keys.insert(seq[index].first, keys.size());
-      index++;
+  if(only_main()){
+    int start, end;
+    bin_search(main.keys, k1, start);
+    if(bin_search(main.keys, k2, end)){
+      end++;
     }
+    append_keys(keys, start, end);
+    return keys;
   }
+  find_keys(k1, k2, keys);
   return keys;
 }
 
-//Returns a sorted ArraySeq of all of the keys
-template<typename K, typename V>
-ArraySeq<K> BinSearchMap<K, V>::sorted_keys() const
+//Adds all of the keys between or equal to the values of k1 and k2 to
+//the given sequence, merging the runs
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
+  std::vector<Cursor> cursors;
+  open_cursors(cursors, &k1, &k2);
+  int c;
+  while((c = next_cursor(cursors)) != -1){
+    keys.insert(cursors[c].run -> keys[cursors[c].index++], keys.size());
+  }
+}
+
+//Returns a sorted ArraySeq of all of the keys. With every pair in the
+//main run this is a straight copy of its keys, otherwise the runs are
+//merged.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+ArraySeq<K> BinSearchMap<K, V, Seq, Compare>::sorted_keys() const
 {
   ArraySeq<K> keys;
-  for(int i = 0; i < size(); i++){
-    keys.insert(seq[i].first, keys.size());
+  if(only_main()){
+    append_keys(keys, 0, main.keys.size());
+    return keys;
+  }
+  keys.reserve(count);
+  std::vector<Cursor> cursors;
+  open_cursors(cursors, nullptr, nullptr);
+  int c;
+  while((c = next_cursor(cursors)) != -1){
+    keys.push_back(cursors[c].run -> keys[cursors[c].index++]);
   }
   return keys;
 }
 
+//Calls f on each unerased pair in key order, merging the runs
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+template<typename F>
+void BinSearchMap<K, V, Seq, Compare>::for_each(F f) const
+{
+  std::vector<Cursor> cursors;
+  open_cursors(cursors, nullptr, nullptr);
+  int c;
+  while((c = next_cursor(cursors)) != -1){
+    int index = cursors[c].index++;
+    f(cursors[c].run -> keys[index], cursors[c].run -> vals[index]);
+  }
+}
+
 //Returns true if there is a key larger than the input key and
 //updates the next_key parameter. Returns false if not
-template<typename K, typename V>
-bool BinSearchMap<K, V>::next_key(const K& key, K& next_key) const
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::next_key(const K& key, K& next_key) const
 {
-  if(empty() || seq[size() - 1].first <= key){
-    return false;
-  }
-  int index;
-  if(bin_search(key, index)){
-    next_key = seq[index + 1].first;
-    return true;
-  } else {
-    for(int i = 1; i < size(); i++){
-      if(seq[i - 1].first <= key && key < seq[i].first){
-        next_key = seq[i].first;
-        return true;
-      }
+  bool found = false;
+  for(int p = 0; p < parts(); p++){
+    const Run& run = part(p);
+    int index;
+    if(bin_search(run.keys, key, index)){
+      index++;
+    }
+    while(index < run.keys.size() && is_erased(run, index)){
+      index++;
+    }
+    if(index < run.keys.size() && (!found || compare(run.keys[index], next_key) < 0)){
+      next_key = run.keys[index];
+      found = true;
     }
   }
+  return found;
 }
 
 //Returns true if there is a key smaller than the input key and
-//updates the next_key parameter. Returns false if not
-template<typename K, typename V>
-bool BinSearchMap<K, V>::prev_key(const K& key, K& prev_key) const
+//updates the prev_key parameter. Returns false if not
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+bool BinSearchMap<K, V, Seq, Compare>::prev_key(const K& key, K& prev_key) const
 {
-  if(empty() || seq[0].first >= key){
-    return false;
-  }
-  int index;
-  if(bin_search(key, index)){
-    prev_key = seq[index - 1].first;
-    return true;
-  } else {
-    for(int i = 0; i < size() - 1; i++){
-      if(seq[i].first < key && key <= seq[i + 1].first){
-        prev_key = seq[i].first;
-        return true;
-      }
+  bool found = false;
+  for(int p = 0; p < parts(); p++){
+    const Run& run = part(p);
+    int index;
+    bin_search(run.keys, key, index);
+    index--;
+    while(index >= 0 && is_erased(run, index)){
+      index--;
+    }
+    if(index >= 0 && (!found || compare(prev_key, run.keys[index]) < 0)){
+      prev_key = run.keys[index];
+      found = true;
     }
   }
+  return found;
 }
 
 //Clears the current BinSearchMap
-template<typename K, typename V>
-void BinSearchMap<K, V>::clear()
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::clear()
 {
-  seq.clear();
+  buffer = Run();
+  main = Run();
+  runs.clear();
+  count = 0;
+  tombstones = 0;
+}
+
+//Merges the write buffer and the runs into the main run, dropping
+//the erased pairs. The smallest runs are merged first, so with the
+//run sizes falling off geometrically this is linear overall.
+template<typename K, typename V, template<typename> class Seq, typename Compare>
+void BinSearchMap<K, V, Seq, Compare>::merge()
+{
+  if(buffer.keys.empty() && runs.empty() && tombstones == 0){
+    return;
+  }
+  if(!buffer.keys.empty()){
+    runs.push_back(std::move(buffer));
+    buffer = Run();
+  }
+  while(runs.size() >= 2){
+    Run merged = merge_runs(runs[runs.size() - 2], runs.back());
+    runs.pop_back();
+    runs.back() = std::move(merged);
+  }
+  Run rest;
+  if(!runs.empty()){
+    rest = std::move(runs.back());
+    runs.clear();
+  }
+  main = merge_runs(main, rest);
 }
 
 #endif
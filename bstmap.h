@@ -2,7 +2,8 @@
 // NAME: Connor Goldschmidt
 // FILE: bstmap.h
 // DATE: Spring 2022
-// DESC: Binary Search Tree implimentation of the map interface.
+// DESC: Binary Search Tree implimentation of the map interface. Keys
+//       are ordered by a three-way Compare (see compare.h).
 //---------------------------------------------------------------------------
 
 #ifndef BSTMAP_H
@@ -10,10 +11,14 @@
 
 #include "map.h"
 #include "arrayseq.h"
+#include "poolalloc.h"
+#include "compare.h"
+#include <type_traits>
 
 
-template<typename K, typename V>
-class BSTMap : public Map<K,V>
+template<typename K, typename V, template<typename> class Alloc = HeapAlloc,
+         typename Compare = ThreeWayCompare>
+class BSTMap final : public Map<K,V>
 {
 public:
 
@@ -53,6 +58,16 @@ public:
   // Expects key to not exist in map prior to insertion.
   void insert(const K& key, const V& value);
 
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
   // Shrinks the collection by removing the key-value pair with the
   // given key. Does not modify the collection if the collection does
   // not contain the key. Throws out_of_range if the given key is not
@@ -62,9 +77,50 @@ public:
   // Returns true if the key is in the collection, and false otherwise.
   bool contains(const K& key) const;
 
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Transparent lookups. When Compare has an is_transparent member
+  // (ThreeWayCompare does) these take any key it can order against a
+  // K, such as a std::string_view or const char* for a std::string
+  // key, without building a temporary K. See transparent_lookup_t in
+  // compare.h.
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  V& operator[](const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  const V& operator[](const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  bool contains(const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  V* find(const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  const V* find(const KeyLike& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
   // Returns the keys k in the collection such that k1 <= k <= k2
   ArraySeq<K> find_keys(const K& k1, const K& k2) const;
 
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
   // Returns the keys in the collection in ascending sorted order
   ArraySeq<K> sorted_keys() const;  
 
@@ -88,10 +144,14 @@ private:
 
   // node for linked-list separate chaining
   struct Node {
+    // builds a leaf with the key made from key and the value from args
+    template<typename KeyArg, typename... Args>
+    Node(KeyArg&& key, Args&&... args)
+      : key(std::forward<KeyArg>(key)), value(std::forward<Args>(args)...) {}
     K key;
     V value;
-    Node* left;
-    Node* right;
+    Node* left = nullptr;
+    Node* right = nullptr;
   };
 
   // number of key-value pairs in map
@@ -100,18 +160,36 @@ private:
   // array of linked lists
   Node* root = nullptr;
 
+  // allocator for the nodes
+  Alloc<Node> nodes;
+
+  // three-way key comparator
+  Compare compare;
+
   // clean up the tree and reset count to zero given subtree root
   void clear(Node* st_root);
 
   // copy assignment helper
-  Node* copy(const Node* rhs_st_root) const;
+  Node* copy(const Node* rhs_st_root);
   
-  // erase helper
-  Node* erase(const K& key, Node* st_root);
+  // returns the node with the key, or nullptr. The key can be any
+  // type Compare orders against K.
+  template<typename KeyLike>
+  Node* find_node(const KeyLike& key) const;
+
+  // returns the link to the key's node, or the null link where it
+  // would be added
+  Node** find_link(const K& key);
+
+  // links a new leaf in at the given null link
+  void add_leaf(Node** link, Node* new_node);
+
+  // removes the node the link points to
+  void unlink(Node** link);
 
   // find_keys helper
   void find_keys(const K& k1, const K& k2, const Node* st_root,
-                 ArraySeq<K>& keys) const;
+                 Sequence<K>& keys) const;
 
   // sorted_keys helper
   void sorted_keys(const Node* st_root, ArraySeq<K>& keys) const;
@@ -122,8 +200,8 @@ private:
 };
 
 
-template<typename K, typename V>
-BSTMap<K,V>::BSTMap()
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+BSTMap<K, V, Alloc, Compare>::BSTMap()
 {
 }
 
@@ -133,22 +211,22 @@ BSTMap<K,V>::BSTMap()
 // notes.
 
 //initalizes the copy constructor
-template<typename K, typename V>
-BSTMap<K,V>::BSTMap(const BSTMap& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+BSTMap<K, V, Alloc, Compare>::BSTMap(const BSTMap& rhs)
 {
   *this = rhs;
 }
 
 //initalizes the move constructor
-template<typename K, typename V>
-BSTMap<K,V>::BSTMap(BSTMap&& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+BSTMap<K, V, Alloc, Compare>::BSTMap(BSTMap&& rhs)
 {
   *this = std::move(rhs);
 }
 
 //initalizes the copy assignment
-template<typename K, typename V>
-BSTMap<K, V>& BSTMap<K, V>::operator=(const BSTMap& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+BSTMap<K, V, Alloc, Compare>& BSTMap<K, V, Alloc, Compare>::operator=(const BSTMap& rhs)
 {
   if(this != &rhs){
     clear();
@@ -159,13 +237,14 @@ BSTMap<K, V>& BSTMap<K, V>::operator=(const BSTMap& rhs)
 }
 
 //initalizes the move assignment
-template<typename K, typename V>
-BSTMap<K, V>& BSTMap<K, V>::operator=(BSTMap&& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+BSTMap<K, V, Alloc, Compare>& BSTMap<K, V, Alloc, Compare>::operator=(BSTMap&& rhs)
 {
   if(this != &rhs){
     clear();
     root = rhs.root;
     count = rhs.count;
+    nodes = std::move(rhs.nodes);
     rhs.count = 0;
     rhs.root = nullptr;
   }
@@ -173,22 +252,22 @@ BSTMap<K, V>& BSTMap<K, V>::operator=(BSTMap&& rhs)
 }
 
 //initalizes the destructor
-template<typename K, typename V>
-BSTMap<K, V>::~BSTMap()
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+BSTMap<K, V, Alloc, Compare>::~BSTMap()
 {
   clear();
 }
 
 //returns the number of nodes stored in the tree
-template<typename K, typename V>
-int BSTMap<K, V>::size() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+int BSTMap<K, V, Alloc, Compare>::size() const
 {
   return count; 
 }
 
 //returns true if the tree is empty, false if not
-template<typename K, typename V>
-bool BSTMap<K, V>::empty() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool BSTMap<K, V, Alloc, Compare>::empty() const
 {
   if(count == 0){
     return true;
@@ -198,279 +277,401 @@ bool BSTMap<K, V>::empty() const
 
 //given a valid key, returns the corrisponding key value
 //throws an out_of_range exception if key is invalid
-template<typename K, typename V>
-V& BSTMap<K, V>::operator[](const K& key)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+V& BSTMap<K, V, Alloc, Compare>::operator[](const K& key)
 {
-  Node* temp = root;
-  while(temp){
-    if(temp -> key == key){
-      return temp -> value;
-    }
-    if(key < temp -> key){
-      temp = temp -> left;
-    } else {
-      temp = temp -> right;
-    }
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator");
   }
-  throw std::out_of_range("Out of Range in Operator");
+  return *value;
 }
 
 //given a valid key, returns the corrisponding key value as a constant
 //throws an out_of_range exception if key is invalid
-template<typename K, typename V>
-const V& BSTMap<K, V>::operator[](const K& key) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+const V& BSTMap<K, V, Alloc, Compare>::operator[](const K& key) const
 {
-  Node* temp = root;
-  while(temp){
-    if(temp -> key == key){
-      return temp -> value;
-    }
-    if(key < temp -> key){
-      temp = temp -> left;
-    } else {
-      temp = temp -> right;
-    }
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator");
   }
-  throw std::out_of_range("Out of Range in Operator");
+  return *value;
 }
 
 //inserts the given key, value pair into a leaf node in the tree
-template<typename K, typename V>
-void BSTMap<K, V>::insert(const K& key, const V& value)
-{
-  Node* new_node = new Node;
-  new_node -> key = key;
-  new_node -> value = value;
-  new_node -> left = nullptr;
-  new_node -> right = nullptr;
-  if(empty()){
-    root = new_node;
-  } else {
-    Node* temp = root;
-    Node* parent;
-    while(temp){
-      parent = temp;
-      if(key < temp -> key){
-        temp = temp -> left;
-      } else {
-        temp = temp -> right;
-      }
-    }
-    if(key < parent -> key){
-      parent -> left = new_node;
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::insert(const K& key, const V& value)
+{
+  emplace(key, value);
+}
+
+//moves the given key, value pair into a leaf node in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::insert(K&& key, V&& value)
+{
+  emplace(std::move(key), std::move(value));
+}
+
+//constructs the pair in a new node and links it in as a leaf
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyArg, typename... Args>
+void BSTMap<K, V, Alloc, Compare>::emplace(KeyArg&& key, Args&&... args)
+{
+  Node* new_node = nodes.create(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+  Node** link = &root;
+  while(*link){
+    if(compare(new_node -> key, (*link) -> key) < 0){
+      link = &(*link) -> left;
     } else {
-      parent -> right = new_node;
+      link = &(*link) -> right;
     }
   }
-  count++;
+  add_leaf(link, new_node);
 }
 
 //removes the given key and corrisponding value pair from the tree
-template<typename K, typename V>
-void BSTMap<K, V>::erase(const K& key)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::erase(const K& key)
 {
-  if(empty() || !contains(key)){
+  if(!try_erase(key)){
     throw std::out_of_range("Out of Range in Erase");
   }
-  root = erase(key, root);
-  count--;
 }
 
 //returns true if given key is in the tree, false if not
-template<typename K, typename V>
-bool BSTMap<K, V>::contains(const K& key) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool BSTMap<K, V, Alloc, Compare>::contains(const K& key) const
 {
-  Node* temp = root;
-  while(temp){
-    if(temp -> key == key){
-      return true;
-    }
-    if(key < temp -> key){
-      temp = temp -> left;
-    } else {
-      temp = temp -> right;
-    }
+  return find_node(key) != nullptr;
+}
+
+//returns a pointer to the value of the given key, or nullptr if it is
+//not in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+V* BSTMap<K, V, Alloc, Compare>::find(const K& key)
+{
+  Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+//returns a constant pointer to the value of the given key, or nullptr
+//if it is not in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+const V* BSTMap<K, V, Alloc, Compare>::find(const K& key) const
+{
+  const Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+//transparent lookup, given a valid key-like value returns the
+//corrisponding key value. throws an out_of_range exception if it is
+//not a key in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+V& BSTMap<K, V, Alloc, Compare>::operator[](const KeyLike& key)
+{
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator");
   }
-  return false;
+  return *value;
+}
+
+//transparent lookup, given a valid key-like value returns the
+//corrisponding key value as a constant
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+const V& BSTMap<K, V, Alloc, Compare>::operator[](const KeyLike& key) const
+{
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator");
+  }
+  return *value;
+}
+
+//transparent lookup, returns true if a key equal to the given value
+//is in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+bool BSTMap<K, V, Alloc, Compare>::contains(const KeyLike& key) const
+{
+  return find_node(key) != nullptr;
+}
+
+//transparent lookup, returns a pointer to the value of the matching
+//key, or nullptr
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+V* BSTMap<K, V, Alloc, Compare>::find(const KeyLike& key)
+{
+  Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+//transparent lookup, returns a constant pointer to the value of the
+//matching key, or nullptr
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike, typename>
+const V* BSTMap<K, V, Alloc, Compare>::find(const KeyLike& key) const
+{
+  const Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+//replaces the value of the given key, or adds the pair as a new leaf
+//where the search for it ended. Returns true if the pair was added.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool BSTMap<K, V, Alloc, Compare>::insert_or_assign(const K& key, const V& value)
+{
+  Node** link = find_link(key);
+  if(*link){
+    (*link) -> value = value;
+    return false;
+  }
+  add_leaf(link, nodes.create(key, value));
+  return true;
+}
+
+//adds the pair as a new leaf where the search for the key ended, if
+//the key was not found. Returns true if the pair was added.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool BSTMap<K, V, Alloc, Compare>::try_emplace(const K& key, const V& value)
+{
+  Node** link = find_link(key);
+  if(*link){
+    return false;
+  }
+  add_leaf(link, nodes.create(key, value));
+  return true;
+}
+
+//removes the given key and corrisponding value pair if it is in the
+//tree. Returns true if a pair was removed.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool BSTMap<K, V, Alloc, Compare>::try_erase(const K& key)
+{
+  Node** link = find_link(key);
+  if(!*link){
+    return false;
+  }
+  unlink(link);
+  return true;
 }
 
 //returns an ArraySeq of key values that are between k1 and k2
-template<typename K, typename V>
-ArraySeq<K> BSTMap<K, V>::find_keys(const K& k1, const K& k2) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+ArraySeq<K> BSTMap<K, V, Alloc, Compare>::find_keys(const K& k1, const K& k2) const
 {
   ArraySeq<K> keys;
   find_keys(k1, k2, root, keys);
   return keys;
 }
 
+//adds the key values that are between k1 and k2 to the given sequence
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
+  find_keys(k1, k2, root, keys);
+}
+
 //returns an array seq of all of the keys in sorted order
-template<typename K, typename V>
-ArraySeq<K> BSTMap<K, V>::sorted_keys() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+ArraySeq<K> BSTMap<K, V, Alloc, Compare>::sorted_keys() const
 {
   ArraySeq<K> keys;
+  keys.reserve(count);
   sorted_keys(root, keys);
   return keys;
 }
 
-//returns the next key value in the tree
-template<typename K, typename V>
-bool BSTMap<K, V>::next_key(const K& key, K& next_key) const
+//returns the next key value in the tree. The last node where the
+//search turned left is the smallest key larger than the given key.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool BSTMap<K, V, Alloc, Compare>::next_key(const K& key, K& next_key) const
 {
-  Node* temp = root;
-  K temp_next_key = key;
+  const Node* temp = root;
+  const Node* next = nullptr;
   while(temp){
-    if(temp -> key > key && (temp -> key < temp_next_key || temp_next_key == key)){
-      temp_next_key = temp -> key;
-    }
-    if(key < temp -> key){
+    if(compare(key, temp -> key) < 0){
+      next = temp;
       temp = temp -> left;
     } else {
       temp = temp -> right;
     }
   }
-  if(temp_next_key == key){
+  if(!next){
     return false;
-  } else {
-    next_key = temp_next_key;
-    return true;
   }
+  next_key = next -> key;
+  return true;
 }
 
-//returns the previous key value in the tree
-template<typename K, typename V>
-bool BSTMap<K, V>::prev_key(const K& key, K& prev_key) const
+//returns the previous key value in the tree. The last node where the
+//search turned right is the largest key smaller than the given key.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+bool BSTMap<K, V, Alloc, Compare>::prev_key(const K& key, K& prev_key) const
 {
-  Node* temp = root;
-  K temp_prev_key = key;
+  const Node* temp = root;
+  const Node* prev = nullptr;
   while(temp){
-    if(temp -> key < key && (temp -> key > temp_prev_key || temp_prev_key == key)){
-      temp_prev_key = temp -> key;
-    }
-    if(key <= temp -> key){
-      temp = temp -> left;
-    } else {
+    if(compare(temp -> key, key) < 0){
+      prev = temp;
       temp = temp -> right;
-    } 
+    } else {
+      temp = temp -> left;
+    }
   }
-  if(temp_prev_key == key){
+  if(!prev){
     return false;
-  } else {
-    prev_key = temp_prev_key;
-    return true;
   }
+  prev_key = prev -> key;
+  return true;
 }
 
-//deletes all of the values in the tree
-template<typename K, typename V>
-void BSTMap<K, V>::clear()
+//deletes all of the values in the tree. Pool allocated nodes that
+//need no destructor are dropped with their slabs instead of one at a
+//time.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::clear()
 {
-  clear(root);
+  if(!Alloc<Node>::bulk || !std::is_trivially_destructible<Node>::value){
+    clear(root);
+  }
+  nodes.release();
   count = 0;
   root = nullptr;
 }
 
 //returns the largest root to leaf path in the tree
-template<typename K, typename V>
-int BSTMap<K, V>::height() const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+int BSTMap<K, V, Alloc, Compare>::height() const
 {
   return height(root);
 }
 
 //helper function for the clear method
-template<typename K, typename V>
-void BSTMap<K, V>::clear(Node* st_root)
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::clear(Node* st_root)
 {
   if(!st_root){
     return;
   }
   clear(st_root -> left);
   clear(st_root -> right);
-  delete st_root;
+  nodes.destroy(st_root);
 }
 
 //returns the root of the copied tree
-template<typename K, typename V>
-typename BSTMap<K,V>::Node* BSTMap<K, V>::copy(const Node* rhs_st_root) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+typename BSTMap<K, V, Alloc, Compare>::Node* BSTMap<K, V, Alloc, Compare>::copy(const Node* rhs_st_root)
 {
   if(!rhs_st_root){
     return nullptr;
   } else {
-    Node* new_node = new Node;
-    new_node -> key = rhs_st_root -> key;
-    new_node -> value = rhs_st_root -> value;
+    Node* new_node = nodes.create(rhs_st_root -> key, rhs_st_root -> value);
     new_node -> left = copy(rhs_st_root -> left);
     new_node -> right = copy(rhs_st_root -> right);
     return new_node;
   }
 }
 
-//helper function for the erase method
-template<typename K, typename V>
-typename BSTMap<K,V>::Node* BSTMap<K, V>::erase(const K& key, Node* st_root)
+//walks down from the root with one three-way comparison per level
+//and returns the key's node, or nullptr if it is not in the tree
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+template<typename KeyLike>
+typename BSTMap<K, V, Alloc, Compare>::Node* BSTMap<K, V, Alloc, Compare>::find_node(const KeyLike& key) const
 {
-  if(!st_root){
-    return nullptr;
+  Node* temp = root;
+  while(temp){
+    int order = compare(key, temp -> key);
+    if(order == 0){
+      return temp;
+    }
+    temp = order < 0 ? temp -> left : temp -> right;
   }
-  if(key < st_root -> key ){
-    st_root -> left = erase(key, st_root -> left);
-  } else if(key > st_root -> key){
-    st_root -> right = erase(key, st_root -> right);
-  } else {
-    if(st_root -> left == nullptr && st_root -> right == nullptr){
-      delete st_root;
-      st_root = nullptr;
-    } else if(st_root -> left == nullptr){
-      Node* temp = st_root;
-      st_root = st_root -> right;
-      delete temp;
-    } else if(st_root -> right == nullptr){
-      Node* temp = st_root;
-      st_root = st_root -> left;
-      delete temp;
-    } else {
-      Node* temp = st_root -> right;
-      while(temp -> left){
-        temp = temp -> left;
-      }
-      st_root -> key = temp -> key;
-      st_root -> value = temp -> value;
-      st_root -> right = erase(temp -> key, st_root -> right);
+  return nullptr;
+}
+
+//walks down from the root towards the key and stops at its node or at
+//the empty link where it would be added
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+typename BSTMap<K, V, Alloc, Compare>::Node** BSTMap<K, V, Alloc, Compare>::find_link(const K& key)
+{
+  Node** link = &root;
+  while(*link){
+    int order = compare(key, (*link) -> key);
+    if(order == 0){
+      break;
+    }
+    link = order < 0 ? &(*link) -> left : &(*link) -> right;
+  }
+  return link;
+}
+
+//links a new node into the empty link
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::add_leaf(Node** link, Node* new_node)
+{
+  *link = new_node;
+  count++;
+}
+
+//removes the node from the tree. A node with two children takes its
+//in-order successor's pair and the successor is unlinked instead.
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::unlink(Node** link)
+{
+  Node* temp = *link;
+  if(temp -> left && temp -> right){
+    link = &temp -> right;
+    while((*link) -> left){
+      link = &(*link) -> left;
     }
+    Node* successor = *link;
+    temp -> key = std::move(successor -> key);
+    temp -> value = std::move(successor -> value);
+    temp = successor;
   }
-  return st_root;
+  *link = temp -> left ? temp -> left : temp -> right;
+  nodes.destroy(temp);
+  count--;
 }
 
 //helper function for the find_keys method
-template<typename K, typename V>
-void BSTMap<K, V>::find_keys(const K& k1, const K& k2, const Node* st_root, ArraySeq<K>& keys) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::find_keys(const K& k1, const K& k2, const Node* st_root, Sequence<K>& keys) const
 {
   if(st_root){
-    if(k1 <= st_root -> key){
+    int low = compare(k1, st_root -> key);
+    int high = compare(k2, st_root -> key);
+    if(low <= 0){
       find_keys(k1, k2, st_root -> left, keys);
     }
-    if(k2 >= st_root -> key && k1 <= st_root -> key){
+    if(high >= 0 && low <= 0){
       keys.insert(st_root -> key, keys.size());
     }
-    if(k2 >= st_root -> key){
+    if(high >= 0){
       find_keys(k1, k2, st_root -> right, keys);
     }
   }
 }
 
 //helper function for the sorted_keys method
-template<typename K, typename V>
-void BSTMap<K, V>::sorted_keys(const Node* st_root, ArraySeq<K>& keys) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+void BSTMap<K, V, Alloc, Compare>::sorted_keys(const Node* st_root, ArraySeq<K>& keys) const
 {
   if(st_root){
     sorted_keys(st_root -> left, keys);
-    keys.insert(st_root -> key, keys.size());
+    keys.push_back(st_root -> key);
     sorted_keys(st_root -> right, keys);
   }
 }
 
 //helper function for the height method
-template<typename K, typename V>
-int BSTMap<K, V>::height(const Node* st_root) const
+template<typename K, typename V, template<typename> class Alloc, typename Compare>
+int BSTMap<K, V, Alloc, Compare>::height(const Node* st_root) const
 {
   if(!st_root){
     return 0;
@@ -0,0 +1,961 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: compactavlmap.h
+// DATE: Spring 2022
+// DESC: Compact AVL tree implementation of the Map interface. All of
+//       the nodes live in one contiguous array and link to each other
+//       with 32-bit indices instead of pointers. Each node keeps a
+//       2-bit balance factor (packed into its left index) instead of
+//       an int height, since rebalancing only needs to know which
+//       side is taller. For int keys and values a node is 16 bytes,
+//       against 40 for an AVLMap node, so more of the tree fits in
+//       cache. The array stays dense: an erase moves the last node
+//       into the freed slot. Keys are ordered by a three-way Compare
+//       (see compare.h).
+//---------------------------------------------------------------------------
+
+#ifndef COMPACTAVLMAP_H
+#define COMPACTAVLMAP_H
+
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "map.h"
+#include "arrayseq.h"
+#include "compare.h"
+
+
+template<typename K, typename V, typename Compare = ThreeWayCompare>
+class CompactAVLMap final : public Map<K,V>
+{
+public:
+
+  // default constructor
+  CompactAVLMap();
+
+  // copy constructor
+  CompactAVLMap(const CompactAVLMap& rhs);
+
+  // move constructor
+  CompactAVLMap(CompactAVLMap&& rhs);
+
+  // copy assignment
+  CompactAVLMap& operator=(const CompactAVLMap& rhs);
+
+  // move assignment
+  CompactAVLMap& operator=(CompactAVLMap&& rhs);
+
+  // destructor
+  ~CompactAVLMap();
+
+  // Returns the number of key-value pairs in the map
+  int size() const;
+
+  // Tests if the map is empty
+  bool empty() const;
+
+  // Allows values associated with a key to be updated. Throws
+  // out_of_range if the given key is not in the collection.
+  V& operator[](const K& key);
+
+  // Returns the value for a given key. Throws out_of_range if the
+  // given key is not in the collection.
+  const V& operator[](const K& key) const;
+
+  // Extends the collection by adding the given key-value pair.
+  // Expects key to not exist in map prior to insertion. Throws
+  // out_of_range if the map already holds max_size() pairs.
+  void insert(const K& key, const V& value);
+
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
+  // Shrinks the collection by removing the key-value pair with the
+  // given key. Throws out_of_range if the given key is not in the
+  // collection.
+  void erase(const K& key);
+
+  // Returns true if the key is in the collection, and false otherwise.
+  bool contains(const K& key) const;
+
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Transparent lookups. When Compare has an is_transparent member
+  // (ThreeWayCompare does) these take any key it can order against a
+  // K, such as a std::string_view or const char* for a std::string
+  // key, without building a temporary K. See transparent_lookup_t in
+  // compare.h.
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  V& operator[](const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  const V& operator[](const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  bool contains(const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  V* find(const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Compare, K, KeyLike>>
+  const V* find(const KeyLike& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
+  // Returns the keys k in the collection such that k1 <= k <= k2
+  ArraySeq<K> find_keys(const K& k1, const K& k2) const;
+
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
+  // Returns the keys in the collection in ascending sorted order
+  ArraySeq<K> sorted_keys() const;
+
+  // Gives the key (as an ouptput parameter) immediately after the
+  // given key according to ascending sort order. Returns true if a
+  // successor key exists, and false otherwise.
+  bool next_key(const K& key, K& next_key) const;
+
+  // Gives the key (as an ouptput parameter) immediately before the
+  // given key according to ascending sort order. Returns true if a
+  // predecessor key exists, and false otherwise.
+  bool prev_key(const K& key, K& prev_key) const;
+
+  // Removes all key-value pairs from the map.
+  void clear();
+
+  // Returns the height of the tree
+  int height() const;
+
+  // Returns the most pairs the map can hold (the indices are 30 bits)
+  static int max_size();
+
+  // Returns the bytes used per node
+  static int node_size();
+
+private:
+
+  // A node. Index 0 is the null index, so the nodes are stored from
+  // index 1 on.
+  struct Node {
+    // builds a balanced leaf with the key made from key and the value
+    // from args. Disabled for a Node argument so copying a non-const
+    // node still uses the copy constructor.
+    template<typename KeyArg, typename... Args,
+             typename = std::enable_if_t<!std::is_same_v<std::decay_t<KeyArg>, Node>>>
+    Node(KeyArg&& key, Args&&... args)
+      : key(std::forward<KeyArg>(key)), value(std::forward<Args>(args)...) {}
+    K key;
+    V value;
+    // left and right child indices. The top 2 bits of link[0] hold
+    // the balance factor, the top 2 bits of link[1] are always 0.
+    uint32_t link[2] = {0, 0};
+  };
+
+  // balance factors, also used as heavy(dir) for dir 0 (left) and 1
+  // (right)
+  static const uint32_t balanced = 0;
+  static const uint32_t left_heavy = 1;
+  static const uint32_t right_heavy = 2;
+
+  // the index bits of a link
+  static const uint32_t index_mask = (1u << 30) - 1;
+
+  // deepest possible path, an AVL tree of 2^30 nodes is at most 44
+  // levels
+  static const int max_depth = 64;
+
+  // true if nodes can be moved around with memcpy
+  static const bool trivial = std::is_trivially_copyable<Node>::value;
+
+  // the node array, slots 1 to count hold nodes
+  Node* nodes = nullptr;
+
+  // number of key-value pairs in map
+  int count = 0;
+
+  // number of slots in the node array (including slot 0)
+  int capacity = 0;
+
+  // index of the root, 0 if empty
+  uint32_t root = 0;
+
+  // three-way key comparator
+  Compare compare;
+
+  // node field helpers
+  uint32_t child(uint32_t index, int dir) const;
+  uint32_t balance(uint32_t index) const;
+  void set_child(uint32_t index, int dir, uint32_t child);
+  void set_balance(uint32_t index, uint32_t balance);
+
+  // returns the balance factor of a node taller on the dir side
+  static uint32_t heavy(int dir);
+
+  // returns the index of the node with the key, or 0. The key can be
+  // any type Compare orders against K.
+  template<typename KeyLike>
+  uint32_t find_index(const KeyLike& key) const;
+
+  // returns the index of the node with the key, or 0, recording the
+  // nodes and directions taken on the way down in path and dir
+  uint32_t find_path(const K& key, uint32_t* path, int* dir, int& depth) const;
+
+  // links the new node leaf below path[depth - 1] on the
+  // dir[depth - 1] side and rebalances back up the path
+  void add_leaf(uint32_t leaf, uint32_t* path, int* dir, int depth);
+
+  // removes the node at the end of the path and rebalances back up
+  // the path
+  void unlink(uint32_t index, uint32_t* path, int* dir, int depth);
+
+  // rotates the child on the dir side of index up to its place, and
+  // returns the child
+  uint32_t lift(uint32_t index, int dir);
+
+  // rebalances a node that is two levels taller on the dir side.
+  // Returns the new subtree root, and sets shrank if the subtree is
+  // now shorter than before the rotation.
+  uint32_t rotate(uint32_t index, int dir, bool& shrank);
+
+  // makes the subtree root new_root the child of path[depth - 1] on
+  // the dir[depth - 1] side, or the root if depth is 0
+  void replace(const uint32_t* path, const int* dir, int depth, uint32_t new_root);
+
+  // constructs a node from the arguments in the next free slot and
+  // returns its index. Throws out_of_range if the map is full.
+  template<typename... Args>
+  uint32_t new_node(Args&&... args);
+
+  // moves the last node into the slot of a removed node
+  void remove_slot(uint32_t index);
+
+  // moves the nodes into a new array with the given number of slots
+  void reallocate(int new_capacity);
+
+  // find_keys helper
+  void find_keys(const K& k1, const K& k2, uint32_t st_root,
+                 Sequence<K>& keys) const;
+
+};
+
+
+template<typename K, typename V, typename Compare>
+CompactAVLMap<K,V,Compare>::CompactAVLMap()
+{
+}
+
+//initalizes the copy constructor
+template<typename K, typename V, typename Compare>
+CompactAVLMap<K,V,Compare>::CompactAVLMap(const CompactAVLMap& rhs)
+{
+  *this = rhs;
+}
+
+//initalizes the move constructor
+template<typename K, typename V, typename Compare>
+CompactAVLMap<K,V,Compare>::CompactAVLMap(CompactAVLMap&& rhs)
+{
+  *this = std::move(rhs);
+}
+
+//initalizes the copy assignment. The nodes keep their indices, so the
+//array is copied slot by slot.
+template<typename K, typename V, typename Compare>
+CompactAVLMap<K,V,Compare>& CompactAVLMap<K,V,Compare>::operator=(const CompactAVLMap& rhs)
+{
+  if(this != &rhs){
+    clear();
+    if(rhs.count > 0){
+      reallocate(rhs.count + 1);
+      if(trivial){
+        std::memcpy((void*) (nodes + 1), (const void*) (rhs.nodes + 1), sizeof(Node) * rhs.count);
+      } else {
+        for(int i = 1; i <= rhs.count; i++){
+          new (nodes + i) Node(rhs.nodes[i]);
+        }
+      }
+      count = rhs.count;
+      root = rhs.root;
+    }
+  }
+  return *this;
+}
+
+//initalizes the move assignment
+template<typename K, typename V, typename Compare>
+CompactAVLMap<K,V,Compare>& CompactAVLMap<K,V,Compare>::operator=(CompactAVLMap&& rhs)
+{
+  if(this != &rhs){
+    clear();
+    nodes = rhs.nodes;
+    count = rhs.count;
+    capacity = rhs.capacity;
+    root = rhs.root;
+    rhs.nodes = nullptr;
+    rhs.count = 0;
+    rhs.capacity = 0;
+    rhs.root = 0;
+  }
+  return *this;
+}
+
+//initalizes the destructor
+template<typename K, typename V, typename Compare>
+CompactAVLMap<K,V,Compare>::~CompactAVLMap()
+{
+  clear();
+}
+
+//returns the number of nodes stored in the tree
+template<typename K, typename V, typename Compare>
+int CompactAVLMap<K,V,Compare>::size() const
+{
+  return count;
+}
+
+//returns true if the tree is empty, false if not
+template<typename K, typename V, typename Compare>
+bool CompactAVLMap<K,V,Compare>::empty() const
+{
+  return count == 0;
+}
+
+//given a valid key, returns the corrisponding key value
+//throws an out_of_range exception if key is invalid
+template<typename K, typename V, typename Compare>
+V& CompactAVLMap<K,V,Compare>::operator[](const K& key)
+{
+  uint32_t index = find_index(key);
+  if(!index){
+    throw std::out_of_range("Out of Range in Operator");
+  }
+  return nodes[index].value;
+}
+
+//given a valid key, returns the corrisponding key value as a constant
+//throws an out_of_range exception if key is invalid
+template<typename K, typename V, typename Compare>
+const V& CompactAVLMap<K,V,Compare>::operator[](const K& key) const
+{
+  uint32_t index = find_index(key);
+  if(!index){
+    throw std::out_of_range("Out of Range in Operator");
+  }
+  return nodes[index].value;
+}
+
+//adds a leaf for the key at the bottom of its search path
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::insert(const K& key, const V& value)
+{
+  emplace(key, value);
+}
+
+//moves the pair into a leaf at the bottom of its search path
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::insert(K&& key, V&& value)
+{
+  emplace(std::move(key), std::move(value));
+}
+
+//constructs the pair in the next free slot, then links it in at the
+//bottom of its search path
+template<typename K, typename V, typename Compare>
+template<typename KeyArg, typename... Args>
+void CompactAVLMap<K,V,Compare>::emplace(KeyArg&& key, Args&&... args)
+{
+  uint32_t leaf = new_node(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+  const K& new_key = nodes[leaf].key;
+  uint32_t path[max_depth];
+  int dir[max_depth];
+  int depth = 0;
+  uint32_t cur = root;
+  while(cur){
+    path[depth] = cur;
+    dir[depth] = compare(new_key, nodes[cur].key) < 0 ? 0 : 1;
+    cur = child(cur, dir[depth]);
+    depth++;
+  }
+  add_leaf(leaf, path, dir, depth);
+}
+
+//removes the node with the key, throws an out_of_range exception if
+//the key is not in the tree
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::erase(const K& key)
+{
+  if(!try_erase(key)){
+    throw std::out_of_range("Out of Range in Erase");
+  }
+}
+
+//returns the index of the key's node, or 0, recording the search path
+template<typename K, typename V, typename Compare>
+uint32_t CompactAVLMap<K,V,Compare>::find_path(const K& key, uint32_t* path, int* dir, int& depth) const
+{
+  uint32_t cur = root;
+  while(cur){
+    int order = compare(key, nodes[cur].key);
+    if(order == 0){
+      break;
+    }
+    path[depth] = cur;
+    dir[depth] = order < 0 ? 0 : 1;
+    cur = child(cur, dir[depth]);
+    depth++;
+  }
+  return cur;
+}
+
+//links the leaf in at the end of the path, then walks back up the
+//path updating balance factors. Stops at the first node whose height
+//does not change, which is at most one rotation.
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::add_leaf(uint32_t leaf, uint32_t* path, int* dir, int depth)
+{
+  replace(path, dir, depth, leaf);
+  for(int i = depth - 1; i >= 0; i--){
+    uint32_t node = path[i];
+    uint32_t bal = balance(node);
+    if(bal == balanced){
+      set_balance(node, heavy(dir[i]));
+    } else if(bal != heavy(dir[i])){
+      set_balance(node, balanced);
+      return;
+    } else {
+      bool shrank;
+      replace(path, dir, i, rotate(node, dir[i], shrank));
+      return;
+    }
+  }
+}
+
+//unlinks the node (or its in-order successor, after moving the
+//successor's pair into it), then walks back up the path updating
+//balance factors until a subtree's height stops changing
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::unlink(uint32_t cur, uint32_t* path, int* dir, int depth)
+{
+  uint32_t removed = cur;
+  if(child(cur, 0) && child(cur, 1)){
+    path[depth] = cur;
+    dir[depth] = 1;
+    depth++;
+    removed = child(cur, 1);
+    while(child(removed, 0)){
+      path[depth] = removed;
+      dir[depth] = 0;
+      depth++;
+      removed = child(removed, 0);
+    }
+    nodes[cur].key = std::move(nodes[removed].key);
+    nodes[cur].value = std::move(nodes[removed].value);
+  }
+  replace(path, dir, depth, child(removed, 0) ? child(removed, 0) : child(removed, 1));
+  for(int i = depth - 1; i >= 0; i--){
+    uint32_t node = path[i];
+    uint32_t bal = balance(node);
+    if(bal == heavy(dir[i])){
+      set_balance(node, balanced);
+    } else if(bal == balanced){
+      set_balance(node, heavy(1 - dir[i]));
+      break;
+    } else {
+      bool shrank;
+      replace(path, dir, i, rotate(node, 1 - dir[i], shrank));
+      if(!shrank){
+        break;
+      }
+    }
+  }
+  remove_slot(removed);
+}
+
+//returns true if given key is in the tree, false if not
+template<typename K, typename V, typename Compare>
+bool CompactAVLMap<K,V,Compare>::contains(const K& key) const
+{
+  return find_index(key) != 0;
+}
+
+//returns a pointer to the value of the key, or nullptr if not in the
+//tree
+template<typename K, typename V, typename Compare>
+V* CompactAVLMap<K,V,Compare>::find(const K& key)
+{
+  uint32_t index = find_index(key);
+  return index ? &nodes[index].value : nullptr;
+}
+
+//returns a constant pointer to the value of the key, or nullptr if not
+//in the tree
+template<typename K, typename V, typename Compare>
+const V* CompactAVLMap<K,V,Compare>::find(const K& key) const
+{
+  uint32_t index = find_index(key);
+  return index ? &nodes[index].value : nullptr;
+}
+
+//transparent lookup, given a valid key-like value returns the
+//corrisponding key value. throws an out_of_range exception if it is
+//not a key in the tree
+template<typename K, typename V, typename Compare>
+template<typename KeyLike, typename>
+V& CompactAVLMap<K,V,Compare>::operator[](const KeyLike& key)
+{
+  uint32_t index = find_index(key);
+  if(!index){
+    throw std::out_of_range("Out of Range in Operator");
+  }
+  return nodes[index].value;
+}
+
+//transparent lookup, given a valid key-like value returns the
+//corrisponding key value as a constant
+template<typename K, typename V, typename Compare>
+template<typename KeyLike, typename>
+const V& CompactAVLMap<K,V,Compare>::operator[](const KeyLike& key) const
+{
+  uint32_t index = find_index(key);
+  if(!index){
+    throw std::out_of_range("Out of Range in Operator");
+  }
+  return nodes[index].value;
+}
+
+//transparent lookup, returns true if a key equal to the given value
+//is in the tree
+template<typename K, typename V, typename Compare>
+template<typename KeyLike, typename>
+bool CompactAVLMap<K,V,Compare>::contains(const KeyLike& key) const
+{
+  return find_index(key) != 0;
+}
+
+//transparent lookup, returns a pointer to the value of the matching
+//key, or nullptr
+template<typename K, typename V, typename Compare>
+template<typename KeyLike, typename>
+V* CompactAVLMap<K,V,Compare>::find(const KeyLike& key)
+{
+  uint32_t index = find_index(key);
+  return index ? &nodes[index].value : nullptr;
+}
+
+//transparent lookup, returns a constant pointer to the value of the
+//matching key, or nullptr
+template<typename K, typename V, typename Compare>
+template<typename KeyLike, typename>
+const V* CompactAVLMap<K,V,Compare>::find(const KeyLike& key) const
+{
+  uint32_t index = find_index(key);
+  return index ? &nodes[index].value : nullptr;
+}
+
+//sets the value of the key, or adds a leaf where the search ended.
+//Returns true if the pair was added.
+template<typename K, typename V, typename Compare>
+bool CompactAVLMap<K,V,Compare>::insert_or_assign(const K& key, const V& value)
+{
+  uint32_t path[max_depth];
+  int dir[max_depth];
+  int depth = 0;
+  uint32_t index = find_path(key, path, dir, depth);
+  if(index){
+    nodes[index].value = value;
+    return false;
+  }
+  add_leaf(new_node(key, value), path, dir, depth);
+  return true;
+}
+
+//adds a leaf where the search ended if the key is not in the tree.
+//Returns true if the pair was added.
+template<typename K, typename V, typename Compare>
+bool CompactAVLMap<K,V,Compare>::try_emplace(const K& key, const V& value)
+{
+  uint32_t path[max_depth];
+  int dir[max_depth];
+  int depth = 0;
+  if(find_path(key, path, dir, depth)){
+    return false;
+  }
+  add_leaf(new_node(key, value), path, dir, depth);
+  return true;
+}
+
+//removes the node of the key if it is in the tree. Returns true if a
+//pair was removed.
+template<typename K, typename V, typename Compare>
+bool CompactAVLMap<K,V,Compare>::try_erase(const K& key)
+{
+  uint32_t path[max_depth];
+  int dir[max_depth];
+  int depth = 0;
+  uint32_t index = find_path(key, path, dir, depth);
+  if(!index){
+    return false;
+  }
+  unlink(index, path, dir, depth);
+  return true;
+}
+
+//returns an ArraySeq of key values that are between k1 and k2
+template<typename K, typename V, typename Compare>
+ArraySeq<K> CompactAVLMap<K,V,Compare>::find_keys(const K& k1, const K& k2) const
+{
+  ArraySeq<K> keys;
+  find_keys(k1, k2, root, keys);
+  return keys;
+}
+
+//adds the key values that are between k1 and k2 to the given sequence
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
+  find_keys(k1, k2, root, keys);
+}
+
+//returns an array seq of all of the keys in sorted order, using an
+//explicit stack for the in-order walk
+template<typename K, typename V, typename Compare>
+ArraySeq<K> CompactAVLMap<K,V,Compare>::sorted_keys() const
+{
+  ArraySeq<K> keys;
+  keys.reserve(count);
+  uint32_t stack[max_depth];
+  int depth = 0;
+  uint32_t cur = root;
+  while(cur || depth > 0){
+    while(cur){
+      stack[depth++] = cur;
+      cur = child(cur, 0);
+    }
+    cur = stack[--depth];
+    keys.push_back(nodes[cur].key);
+    cur = child(cur, 1);
+  }
+  return keys;
+}
+
+//returns the next key value in the tree
+template<typename K, typename V, typename Compare>
+bool CompactAVLMap<K,V,Compare>::next_key(const K& key, K& next_key) const
+{
+  uint32_t cur = root;
+  uint32_t next = 0;
+  while(cur){
+    if(compare(key, nodes[cur].key) < 0){
+      next = cur;
+      cur = child(cur, 0);
+    } else {
+      cur = child(cur, 1);
+    }
+  }
+  if(!next){
+    return false;
+  }
+  next_key = nodes[next].key;
+  return true;
+}
+
+//returns the previous key value in the tree
+template<typename K, typename V, typename Compare>
+bool CompactAVLMap<K,V,Compare>::prev_key(const K& key, K& prev_key) const
+{
+  uint32_t cur = root;
+  uint32_t prev = 0;
+  while(cur){
+    if(compare(nodes[cur].key, key) < 0){
+      prev = cur;
+      cur = child(cur, 1);
+    } else {
+      cur = child(cur, 0);
+    }
+  }
+  if(!prev){
+    return false;
+  }
+  prev_key = nodes[prev].key;
+  return true;
+}
+
+//deletes all of the values in the tree and frees the node array
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::clear()
+{
+  if(!std::is_trivially_destructible<Node>::value){
+    for(int i = 1; i <= count; i++){
+      nodes[i].~Node();
+    }
+  }
+  ::operator delete(nodes);
+  nodes = nullptr;
+  count = 0;
+  capacity = 0;
+  root = 0;
+}
+
+//returns the largest root to leaf path in the tree, following the
+//taller child at each level
+template<typename K, typename V, typename Compare>
+int CompactAVLMap<K,V,Compare>::height() const
+{
+  int h = 0;
+  uint32_t cur = root;
+  while(cur){
+    h++;
+    cur = child(cur, balance(cur) == right_heavy ? 1 : 0);
+  }
+  return h;
+}
+
+//returns the largest number of pairs
+template<typename K, typename V, typename Compare>
+int CompactAVLMap<K,V,Compare>::max_size()
+{
+  return index_mask - 1;
+}
+
+//returns the size of a node
+template<typename K, typename V, typename Compare>
+int CompactAVLMap<K,V,Compare>::node_size()
+{
+  return sizeof(Node);
+}
+
+//returns the left (dir 0) or right (dir 1) child index
+template<typename K, typename V, typename Compare>
+uint32_t CompactAVLMap<K,V,Compare>::child(uint32_t index, int dir) const
+{
+  return nodes[index].link[dir] & index_mask;
+}
+
+//returns the balance factor
+template<typename K, typename V, typename Compare>
+uint32_t CompactAVLMap<K,V,Compare>::balance(uint32_t index) const
+{
+  return nodes[index].link[0] >> 30;
+}
+
+//sets the left (dir 0) or right (dir 1) child index
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::set_child(uint32_t index, int dir, uint32_t child)
+{
+  nodes[index].link[dir] = (nodes[index].link[dir] & ~index_mask) | child;
+}
+
+//sets the balance factor
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::set_balance(uint32_t index, uint32_t balance)
+{
+  nodes[index].link[0] = (nodes[index].link[0] & index_mask) | (balance << 30);
+}
+
+//returns left_heavy for dir 0 and right_heavy for dir 1
+template<typename K, typename V, typename Compare>
+uint32_t CompactAVLMap<K,V,Compare>::heavy(int dir)
+{
+  return dir == 0 ? left_heavy : right_heavy;
+}
+
+//returns the index of the key's node, or 0 if it is not in the tree.
+//One three-way comparison per level. The turn is a branch rather than
+//link[order > 0] so that, for keys whose compare misses the cache
+//(strings), the next node is loaded speculatively instead of waiting
+//on the comparison.
+template<typename K, typename V, typename Compare>
+template<typename KeyLike>
+uint32_t CompactAVLMap<K,V,Compare>::find_index(const KeyLike& key) const
+{
+  uint32_t cur = root;
+  while(cur){
+    const Node& node = nodes[cur];
+    int order = compare(key, node.key);
+    if(order == 0){
+      return cur;
+    }
+    if(order < 0){
+      cur = node.link[0] & index_mask;
+    } else {
+      cur = node.link[1] & index_mask;
+    }
+  }
+  return 0;
+}
+
+//Rotates the given node right (dir 0) or left (dir 1)
+template<typename K, typename V, typename Compare>
+uint32_t CompactAVLMap<K,V,Compare>::lift(uint32_t index, int dir)
+{
+  uint32_t up = child(index, dir);
+  set_child(index, dir, child(up, 1 - dir));
+  set_child(up, 1 - dir, index);
+  return up;
+}
+
+//Single rotation if the taller child leans the same way (or neither
+//way, which only happens on erase), otherwise a double rotation, with
+//the balance factors set from the child (or grandchild) before it
+template<typename K, typename V, typename Compare>
+uint32_t CompactAVLMap<K,V,Compare>::rotate(uint32_t index, int dir, bool& shrank)
+{
+  uint32_t up = child(index, dir);
+  uint32_t up_bal = balance(up);
+  if(up_bal != heavy(1 - dir)){
+    uint32_t top = lift(index, dir);
+    if(up_bal == balanced){
+      set_balance(index, heavy(dir));
+      set_balance(up, heavy(1 - dir));
+      shrank = false;
+    } else {
+      set_balance(index, balanced);
+      set_balance(up, balanced);
+      shrank = true;
+    }
+    return top;
+  }
+  uint32_t mid = child(up, 1 - dir);
+  uint32_t mid_bal = balance(mid);
+  set_child(index, dir, lift(up, 1 - dir));
+  uint32_t top = lift(index, dir);
+  set_balance(index, mid_bal == heavy(dir) ? heavy(1 - dir) : balanced);
+  set_balance(up, mid_bal == heavy(1 - dir) ? heavy(dir) : balanced);
+  set_balance(mid, balanced);
+  shrank = true;
+  return top;
+}
+
+//Links the new subtree root to its parent on the path
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::replace(const uint32_t* path, const int* dir, int depth, uint32_t new_root)
+{
+  if(depth == 0){
+    root = new_root;
+  } else {
+    set_child(path[depth - 1], dir[depth - 1], new_root);
+  }
+}
+
+//Adds a balanced leaf at the end of the array, doubling the array if
+//it is full. The leaf is not linked into the tree.
+template<typename K, typename V, typename Compare>
+template<typename... Args>
+uint32_t CompactAVLMap<K,V,Compare>::new_node(Args&&... args)
+{
+  if(count == max_size()){
+    throw std::out_of_range("Out of Range in Insert");
+  }
+  if(count + 1 >= capacity){
+    long new_capacity = capacity < 16 ? 16 : 2L * capacity;
+    if(new_capacity > (long) index_mask + 1){
+      new_capacity = (long) index_mask + 1;
+    }
+    reallocate(new_capacity);
+  }
+  new (nodes + count + 1) Node(std::forward<Args>(args)...);
+  return ++count;
+}
+
+//Moves the last node into the removed node's slot, so the array
+//stays dense. The last node's parent is found by searching for its
+//key, or by scanning the array if duplicate keys hide it.
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::remove_slot(uint32_t index)
+{
+  uint32_t last = count;
+  if(index != last){
+    uint32_t parent = 0;
+    int parent_dir = 0;
+    uint32_t cur = root;
+    while(cur && cur != last){
+      parent = cur;
+      parent_dir = compare(nodes[last].key, nodes[cur].key) < 0 ? 0 : 1;
+      cur = child(cur, parent_dir);
+    }
+    if(!cur){
+      for(parent = 1; parent <= last; parent++){
+        if(child(parent, 0) == last || child(parent, 1) == last){
+          break;
+        }
+      }
+      parent_dir = child(parent, 0) == last ? 0 : 1;
+    }
+    nodes[index] = std::move(nodes[last]);
+    if(last == root){
+      root = index;
+    } else {
+      set_child(parent, parent_dir, index);
+    }
+  }
+  nodes[last].~Node();
+  count--;
+}
+
+//Moves the nodes into a new array with the given number of slots
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::reallocate(int new_capacity)
+{
+  Node* new_nodes = static_cast<Node*>(::operator new(sizeof(Node) * new_capacity));
+  if(trivial){
+    if(count > 0){
+      std::memcpy((void*) (new_nodes + 1), (const void*) (nodes + 1), sizeof(Node) * count);
+    }
+  } else {
+    for(int i = 1; i <= count; i++){
+      new (new_nodes + i) Node(std::move(nodes[i]));
+      nodes[i].~Node();
+    }
+  }
+  ::operator delete(nodes);
+  nodes = new_nodes;
+  capacity = new_capacity;
+}
+
+//helper function for the find_keys method
+template<typename K, typename V, typename Compare>
+void CompactAVLMap<K,V,Compare>::find_keys(const K& k1, const K& k2, uint32_t st_root, Sequence<K>& keys) const
+{
+  if(st_root){
+    const K& key = nodes[st_root].key;
+    int low = compare(k1, key);
+    int high = compare(k2, key);
+    if(low <= 0){
+      find_keys(k1, k2, child(st_root, 0), keys);
+    }
+    if(high >= 0 && low <= 0){
+      keys.insert(key, keys.size());
+    }
+    if(high >= 0){
+      find_keys(k1, k2, child(st_root, 1), keys);
+    }
+  }
+}
+
+
+#endif
@@ -0,0 +1,167 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: compare.h
+// DATE: Spring 2022
+// DESC: Three-way key comparators for the ordered maps. A comparator
+//       called as comp(a, b) returns a negative int if a orders before
+//       b, zero if they are equivalent, and a positive int if a orders
+//       after b. A tree level or binary search step can then branch
+//       three ways on one call, instead of testing == and then <
+//       (two full passes over a string key).
+//---------------------------------------------------------------------------
+
+#ifndef COMPARE_H
+#define COMPARE_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#if defined(__cpp_lib_three_way_comparison)
+#include <compare>
+#endif
+
+
+//----------------------------------------------------------------------
+// True if a.compare(b) exists, as it does for std::string and
+// std::string_view
+//----------------------------------------------------------------------
+template<typename A, typename B, typename = void>
+struct has_compare_member : std::false_type {};
+
+template<typename A, typename B>
+struct has_compare_member<A, B, std::void_t<decltype(std::declval<const A&>().compare(std::declval<const B&>()))>>
+  : std::true_type {};
+
+
+//----------------------------------------------------------------------
+// True if both a < b and b < a exist
+//----------------------------------------------------------------------
+template<typename A, typename B, typename = void>
+struct has_less_than : std::false_type {};
+
+template<typename A, typename B>
+struct has_less_than<A, B, std::void_t<
+  decltype(std::declval<const A&>() < std::declval<const B&>()),
+  decltype(std::declval<const B&>() < std::declval<const A&>())>>
+  : std::true_type {};
+
+
+//----------------------------------------------------------------------
+// True if ThreeWayCompare can order an A against a B, by any of the
+// ways it tries
+//----------------------------------------------------------------------
+template<typename A, typename B>
+struct is_three_way_comparable
+  : std::bool_constant<
+#if defined(__cpp_lib_three_way_comparison)
+      std::three_way_comparable_with<A, B> ||
+#endif
+      has_compare_member<A, B>::value || has_compare_member<B, A>::value ||
+      has_less_than<A, B>::value> {};
+
+
+//----------------------------------------------------------------------
+// The default comparator. Uses operator<=> when the standard library
+// has it (C++20), otherwise a compare() member of either argument (one
+// pass over a string), otherwise (b < a) - (a < b), which for
+// arithmetic keys compiles to two flag sets and no branches. It is
+// transparent: the maps accept lookup keys of any type it can order
+// against the key type, such as a std::string_view or const char* for
+// a std::string key. The call only exists for types it can order, so
+// a lookup key it cannot compare against the key type is not an error
+// but falls back to the map's const K& overload.
+//----------------------------------------------------------------------
+struct ThreeWayCompare
+{
+  using is_transparent = void;
+
+  template<typename A, typename B,
+           typename = std::enable_if_t<is_three_way_comparable<A, B>::value>>
+  int operator()(const A& a, const B& b) const
+  {
+#if defined(__cpp_lib_three_way_comparison)
+    if constexpr(std::three_way_comparable_with<A, B>){
+      auto order = a <=> b;
+      return order < 0 ? -1 : (order > 0 ? 1 : 0);
+    } else
+#endif
+    if constexpr(has_compare_member<A, B>::value){
+      return a.compare(b);
+    } else if constexpr(has_compare_member<B, A>::value){
+      int order = b.compare(a);
+      return (order < 0) - (order > 0);
+    } else {
+      return (b < a) - (a < b);
+    }
+  }
+};
+
+
+//----------------------------------------------------------------------
+// True if Comp is a comparator that can order a KeyLike against a K,
+// as comp(key_like, key) in the ordered maps
+//----------------------------------------------------------------------
+template<typename Comp, typename K, typename KeyLike, typename = void>
+struct can_order_lookup : std::false_type {};
+
+template<typename Comp, typename K, typename KeyLike>
+struct can_order_lookup<Comp, K, KeyLike, std::void_t<
+  decltype(std::declval<const Comp&>()(std::declval<const KeyLike&>(), std::declval<const K&>()))>>
+  : std::is_convertible<decltype(std::declval<const Comp&>()(std::declval<const KeyLike&>(), std::declval<const K&>())), int> {};
+
+
+//----------------------------------------------------------------------
+// True if Comp is a hash that can hash a KeyLike, and a K can be
+// tested == against it, as HashMap does along a chain
+//----------------------------------------------------------------------
+template<typename Comp, typename K, typename KeyLike, typename = void>
+struct can_hash_lookup : std::false_type {};
+
+template<typename Comp, typename K, typename KeyLike>
+struct can_hash_lookup<Comp, K, KeyLike, std::void_t<
+  decltype(std::declval<const Comp&>()(std::declval<const KeyLike&>())),
+  decltype(std::declval<const K&>() == std::declval<const KeyLike&>())>>
+  : std::bool_constant<
+      std::is_convertible_v<decltype(std::declval<const Comp&>()(std::declval<const KeyLike&>())), std::size_t> &&
+      std::is_convertible_v<decltype(std::declval<const K&>() == std::declval<const KeyLike&>()), bool>> {};
+
+
+//----------------------------------------------------------------------
+// Enables a map's transparent lookup overloads for a KeyLike argument.
+// Requires Comp (a comparator or hash) to have is_transparent and to
+// accept a KeyLike against a K. Not for arithmetic keys, which cost
+// nothing to convert, and where comparing an int key against, say, a
+// double or an unsigned argument would change what the lookup finds.
+//----------------------------------------------------------------------
+template<typename Comp, typename K, typename KeyLike, typename = void>
+struct is_transparent_lookup : std::false_type {};
+
+template<typename Comp, typename K, typename KeyLike>
+struct is_transparent_lookup<Comp, K, KeyLike, std::void_t<typename Comp::is_transparent>>
+  : std::bool_constant<!std::is_arithmetic_v<K> && !std::is_same_v<KeyLike, K> &&
+                       (can_order_lookup<Comp, K, KeyLike>::value ||
+                        can_hash_lookup<Comp, K, KeyLike>::value)> {};
+
+template<typename Comp, typename K, typename KeyLike>
+using transparent_lookup_t = std::enable_if_t<is_transparent_lookup<Comp, K, KeyLike>::value>;
+
+
+//----------------------------------------------------------------------
+// Adapts a less-than predicate such as std::less or std::greater to a
+// three-way comparator. Costs two calls of the predicate, so it is
+// for custom orders rather than speed.
+//----------------------------------------------------------------------
+template<typename Less>
+struct LessCompare
+{
+  Less less;
+
+  template<typename A, typename B>
+  int operator()(const A& a, const B& b) const
+  {
+    return less(b, a) - less(a, b);
+  }
+};
+
+#endif
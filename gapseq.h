@@ -0,0 +1,527 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: gapseq.h
+// DATE: Spring 2022
+// DESC: Gap buffer implementation of the sequence interface. The
+//       elements live in one array with an unused gap somewhere in the
+//       middle, and inserts and erases happen at the gap. Moving the
+//       gap costs the distance it moves, so a run of edits near each
+//       other is close to O(1) each, while scattered edits cost about
+//       the same as an ArraySeq.
+//---------------------------------------------------------------------------
+
+#ifndef GAPSEQ_H
+#define GAPSEQ_H
+
+#include <stdexcept>
+#include <ostream>
+#include <new>
+#include <cstring>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include "sequence.h"
+
+
+template<typename T>
+class GapSeq : public Sequence<T>
+{
+public:
+
+  // Default constructor
+  GapSeq();
+
+  // Copy constructor
+  GapSeq(const GapSeq& rhs);
+
+  // Move constructor
+  GapSeq(GapSeq&& rhs);
+
+  // Copy assignment operator
+  GapSeq& operator=(const GapSeq& rhs);
+
+  // Move assignment operator
+  GapSeq& operator=(GapSeq&& rhs);
+
+  // Destructor
+  ~GapSeq();
+
+  // Returns the number of elements in the sequence
+  int size() const;
+
+  // Tests if the sequence is empty
+  bool empty() const;
+
+  // Removes all of the elements from the sequence
+  void clear();
+
+  // Returns a reference to the element at the index in the
+  // sequence. Throws out_of_range if index is invalid (less than 0 or
+  // greater than or equal to size()).
+  T& operator[](int index);
+
+  // Returns a constant address to the element at the index in the
+  // sequence. Throws out_of_range if index is invalid (less than 0 or
+  // greater than or equal to size()).
+  const T& operator[](int index) const;
+
+  // Extends the sequence by inserting the element at the given index.
+  // Throws out_of_range if the index is invalid (less than 0 or
+  // greater than size()).
+  void insert(const T& elem, int index);
+
+  // Same as above, but moves the element into the sequence.
+  void insert(T&& elem, int index);
+
+  // Extends the sequence by constructing an element from the given
+  // arguments in the gap at the given index. Throws out_of_range if
+  // the index is invalid.
+  template<typename... Args>
+  void emplace(int index, Args&&... args);
+
+  // Adds the element to the end of the sequence
+  void push_back(const T& elem);
+  void push_back(T&& elem);
+
+  // Constructs an element at the end of the sequence
+  template<typename... Args>
+  void emplace_back(Args&&... args);
+
+  // Shrinks the sequence by removing the element at the index in the
+  // sequence. Throws out_of_range if index is invalid.
+  void erase(int index);
+
+  // Inserts copies of the elements in [first, last) starting at the
+  // given index. The range must not come from this sequence. Throws
+  // out_of_range if the index is invalid.
+  template<typename Iter>
+  void insert_range(int index, Iter first, Iter last);
+
+  // Removes the elements at indexes [start, end). Throws out_of_range
+  // if the range is invalid.
+  void erase_range(int start, int end);
+
+  // Makes sure the sequence can hold at least n elements without
+  // growing again
+  void reserve(int n);
+
+  // Returns a pointer to the elements as one contiguous array. Moves
+  // the gap to the end first, so the pointer is only valid until the
+  // next insert or erase. There is no const version, since a const
+  // sequence must not move its gap (concurrent readers would race).
+  T* data();
+
+  // Returns true if the element is in the sequence, and false
+  // otherwise.
+  bool contains(const T& elem) const;
+
+  // Sorts the elements in the sequence in place (heap sort over the
+  // contiguous elements)
+  void sort();
+
+private:
+
+  // true if elements can be moved around with memcpy/memmove
+  static const bool trivial = std::is_trivially_copyable<T>::value;
+
+  // the elements are array[0, gap_start) followed by
+  // array[gap_end, max_count)
+  T* array = nullptr;
+  int gap_start = 0;
+  int gap_end = 0;
+
+  // size of the array, including the gap
+  int max_count = 0;
+
+  // moves the gap so that it starts at the given index
+  void move_gap(int index);
+
+  // grows the array (by at least doubling) until the gap holds n
+  void make_room(int n);
+
+  // returns the array slot holding the element at the index
+  int slot(int index) const;
+
+  // moves n elements from src to the uninitialized dst, the ranges may
+  // overlap
+  static void relocate(T* dst, T* src, int n);
+
+  // sift down helper for the heap sort
+  void sift_down(T* elems, int index, int n);
+
+};
+
+
+template<typename T>
+std::ostream& operator<<(std::ostream& stream, const GapSeq<T>& seq)
+{
+  int n = seq.size();
+  for (int i = 0; i < n - 1; ++i)
+    stream << seq[i] << ", ";
+  if (n > 0)
+    stream << seq[n - 1];
+  return stream;
+}
+
+
+template<typename T>
+GapSeq<T>::GapSeq()
+{
+}
+
+//Post: Initializes the copy constructor.
+template<typename T>
+GapSeq<T>::GapSeq(const GapSeq& rhs)
+{
+  *this = rhs;
+}
+
+//Post: Initializes the move constructor.
+template<typename T>
+GapSeq<T>::GapSeq(GapSeq&& rhs)
+{
+  *this = std::move(rhs);
+}
+
+//Post: Initializes the copy assignment. The copy has its gap at the
+//end.
+template<typename T>
+GapSeq<T>& GapSeq<T>::operator=(const GapSeq& rhs)
+{
+  if(this != &rhs){
+    clear();
+    reserve(rhs.size());
+    for(int i = 0; i < rhs.size(); i++){
+      new (array + i) T(rhs[i]);
+    }
+    gap_start = rhs.size();
+  }
+  return *this;
+}
+
+//Post: Initializes the move assignment.
+template<typename T>
+GapSeq<T>& GapSeq<T>::operator=(GapSeq&& rhs)
+{
+  if(this != &rhs){
+    clear();
+    array = rhs.array;
+    gap_start = rhs.gap_start;
+    gap_end = rhs.gap_end;
+    max_count = rhs.max_count;
+    rhs.array = nullptr;
+    rhs.gap_start = 0;
+    rhs.gap_end = 0;
+    rhs.max_count = 0;
+  }
+  return *this;
+}
+
+//Post: Initalizes the deconstructor.
+template<typename T>
+GapSeq<T>::~GapSeq()
+{
+  clear();
+}
+
+//Post: Returns the current size.
+template<typename T>
+int GapSeq<T>::size() const
+{
+  return max_count - (gap_end - gap_start);
+}
+
+//Post: Returns true if the sequence is empty, false if not.
+template<typename T>
+bool GapSeq<T>::empty() const
+{
+  return size() == 0;
+}
+
+//Post: Destroys the elements and frees the array.
+template<typename T>
+void GapSeq<T>::clear()
+{
+  for(int i = 0; i < size(); i++){
+    array[slot(i)].~T();
+  }
+  ::operator delete(array);
+  array = nullptr;
+  gap_start = 0;
+  gap_end = 0;
+  max_count = 0;
+}
+
+//Post: Overrides the access operator.
+template<typename T>
+T& GapSeq<T>::operator[](int index)
+{
+  if(index < 0 || index >= size()){
+    throw std::out_of_range("Out of Range in GapSeq Operator");
+  }
+  return array[slot(index)];
+}
+
+//Post: Overrides the update operator.
+template<typename T>
+const T& GapSeq<T>::operator[](int index) const
+{
+  if(index < 0 || index >= size()){
+    throw std::out_of_range("Out of Range in GapSeq Operator");
+  }
+  return array[slot(index)];
+}
+
+//Pre: Index must be in range. Must be greater or equal to
+//0 and less than or equal to size.
+//Post: Inserts a copy of the element at the index.
+template<typename T>
+void GapSeq<T>::insert(const T& elem, int index)
+{
+  emplace(index, elem);
+}
+
+//Pre: Index must be in range. Must be greater or equal to
+//0 and less than or equal to size.
+//Post: Moves the element into the sequence at the index.
+template<typename T>
+void GapSeq<T>::insert(T&& elem, int index)
+{
+  emplace(index, std::move(elem));
+}
+
+//Pre: Index must be in range. Must be greater or equal to
+//0 and less than or equal to size.
+//Post: Moves the gap to the index and fills its first slot. The
+//element is built first since the arguments may refer to an element
+//of this sequence.
+template<typename T>
+template<typename... Args>
+void GapSeq<T>::emplace(int index, Args&&... args)
+{
+  if(index < 0 || index > size()){
+    throw std::out_of_range("Out of Range in Insert");
+  }
+  T value(std::forward<Args>(args)...);
+  make_room(1);
+  move_gap(index);
+  new (array + gap_start) T(std::move(value));
+  gap_start++;
+}
+
+//Post: Adds a copy of the given value to the end of the sequence.
+template<typename T>
+void GapSeq<T>::push_back(const T& elem)
+{
+  emplace(size(), elem);
+}
+
+//Post: Moves the given value to the end of the sequence.
+template<typename T>
+void GapSeq<T>::push_back(T&& elem)
+{
+  emplace(size(), std::move(elem));
+}
+
+//Post: Constructs a new element at the end of the sequence.
+template<typename T>
+template<typename... Args>
+void GapSeq<T>::emplace_back(Args&&... args)
+{
+  emplace(size(), std::forward<Args>(args)...);
+}
+
+//Pre: Index must be in range. Must be greater or equal to
+//0 and less than size.
+//Post: Moves the gap to the index and widens it over the element.
+template<typename T>
+void GapSeq<T>::erase(int index)
+{
+  if(index < 0 || index >= size()){
+    throw std::out_of_range("Out of Range in Erase");
+  }
+  move_gap(index);
+  array[gap_end].~T();
+  gap_end++;
+}
+
+//Pre: Index must be in range. Must be greater or equal to
+//0 and less than or equal to size.
+//Post: Moves the gap to the index once and copies the range into it.
+template<typename T>
+template<typename Iter>
+void GapSeq<T>::insert_range(int index, Iter first, Iter last)
+{
+  if(index < 0 || index > size()){
+    throw std::out_of_range("Out of Range in Insert Range");
+  }
+  int n = std::distance(first, last);
+  make_room(n);
+  move_gap(index);
+  for(int i = 0; i < n; i++, ++first){
+    new (array + gap_start + i) T(*first);
+  }
+  gap_start += n;
+}
+
+//Pre: 0 <= start <= end <= size.
+//Post: Moves the gap to start and widens it over the range.
+template<typename T>
+void GapSeq<T>::erase_range(int start, int end)
+{
+  if(start < 0 || start > end || end > size()){
+    throw std::out_of_range("Out of Range in Erase Range");
+  }
+  move_gap(start);
+  for(int i = 0; i < end - start; i++){
+    array[gap_end + i].~T();
+  }
+  gap_end += end - start;
+}
+
+//Post: Grows the array to hold at least n elements.
+template<typename T>
+void GapSeq<T>::reserve(int n)
+{
+  if(n > size()){
+    make_room(n - size());
+  }
+}
+
+//Post: Moves the gap to the end and returns the elements.
+template<typename T>
+T* GapSeq<T>::data()
+{
+  move_gap(size());
+  return array;
+}
+
+//Post: Returns true if the given element is in the sequence, false if
+//not.
+template<typename T>
+bool GapSeq<T>::contains(const T& elem) const
+{
+  for(int i = 0; i < size(); i++){
+    if(array[slot(i)] == elem){
+      return true;
+    }
+  }
+  return false;
+}
+
+//Post: Sorts the sequence in place using heap sort.
+template<typename T>
+void GapSeq<T>::sort()
+{
+  T* elems = data();
+  int count = size();
+  for(int i = count / 2 - 1; i >= 0; i--){
+    sift_down(elems, i, count);
+  }
+  for(int n = count - 1; n > 0; n--){
+    std::swap(elems[0], elems[n]);
+    sift_down(elems, 0, n);
+  }
+}
+
+//Post: Moves the elements between the old and new gap positions to
+//the other side of the gap. An empty gap (a full array) is moved by
+//relabelling alone, since no element changes position.
+template<typename T>
+void GapSeq<T>::move_gap(int index)
+{
+  int gap = gap_end - gap_start;
+  if(gap == 0){
+    gap_start = index;
+    gap_end = index;
+    return;
+  }
+  if(index < gap_start){
+    int n = gap_start - index;
+    relocate(array + gap_end - n, array + index, n);
+  } else if(index > gap_start){
+    int n = index - gap_start;
+    relocate(array + gap_start, array + gap_end, n);
+  }
+  gap_start = index;
+  gap_end = index + gap;
+}
+
+//Post: If the gap holds fewer than n slots, moves the elements into
+//an array at least twice the size, keeping the gap where it was.
+template<typename T>
+void GapSeq<T>::make_room(int n)
+{
+  if(gap_end - gap_start >= n){
+    return;
+  }
+  int count = size();
+  int new_capacity = max_count * 2;
+  if(new_capacity < count + n){
+    new_capacity = count + n;
+  }
+  T* new_array = static_cast<T*>(::operator new(sizeof(T) * new_capacity));
+  int back = max_count - gap_end;
+  relocate(new_array, array, gap_start);
+  relocate(new_array + new_capacity - back, array + gap_end, back);
+  ::operator delete(array);
+  array = new_array;
+  gap_end = new_capacity - back;
+  max_count = new_capacity;
+}
+
+//Post: Returns the position in the array of the element at the index.
+template<typename T>
+int GapSeq<T>::slot(int index) const
+{
+  if(index < gap_start){
+    return index;
+  }
+  return index + gap_end - gap_start;
+}
+
+//Post: Moves n elements from src into the uninitialized slots of dst,
+//copying from the far end first when dst is to the right of src so
+//an overlap is never overwritten before it is read. Does nothing when
+//dst is src.
+template<typename T>
+void GapSeq<T>::relocate(T* dst, T* src, int n)
+{
+  if(n == 0 || dst == src){
+    return;
+  }
+  if(trivial){
+    std::memmove((void*) dst, (const void*) src, sizeof(T) * n);
+  } else if(dst > src){
+    for(int i = n - 1; i >= 0; i--){
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  } else {
+    for(int i = 0; i < n; i++){
+      new (dst + i) T(std::move(src[i]));
+      src[i].~T();
+    }
+  }
+}
+
+//Post: Moves the element at index down the max heap of the first n
+//elements until it is no smaller than its children.
+template<typename T>
+void GapSeq<T>::sift_down(T* elems, int index, int n)
+{
+  while(2 * index + 1 < n){
+    int child = 2 * index + 1;
+    if(child + 1 < n && elems[child] < elems[child + 1]){
+      child++;
+    }
+    if(!(elems[index] < elems[child])){
+      return;
+    }
+    std::swap(elems[index], elems[child]);
+    index = child;
+  }
+}
+
+
+#endif
@@ -10,11 +10,18 @@
 
 #include "map.h"
 #include "arrayseq.h"
+#include "topk.h"
+#include "poolalloc.h"
+#include "keyhash.h"
+#include "compare.h"
+#include <type_traits>
 #include <functional>
+#include <atomic>
 
 
-template<typename K, typename V>
-class HashMap : public Map<K,V>
+template<typename K, typename V, template<typename> class Alloc = HeapAlloc,
+         typename Hash = KeyHash<K>>
+class HashMap final : public Map<K,V>
 {
 public:
 
@@ -54,6 +61,16 @@ public:
   // Expects key to not exist in map prior to insertion.
   void insert(const K& key, const V& value);
 
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
   // Shrinks the collection by removing the key-value pair with the
   // given key. Does not modify the collection if the collection does
   // not contain the key. Throws out_of_range if the given key is not
@@ -63,12 +80,82 @@ public:
   // Returns true if the key is in the collection, and false otherwise.
   bool contains(const K& key) const;
 
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Transparent lookups. When Hash has an is_transparent member
+  // (KeyHash<std::string> does) these take any key it hashes the same
+  // as an equal K and that compares equal to it with ==, such as a
+  // std::string_view or const char* for a std::string key, without
+  // building a temporary K. See transparent_lookup_t in compare.h.
+  template<typename KeyLike, typename = transparent_lookup_t<Hash, K, KeyLike>>
+  V& operator[](const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Hash, K, KeyLike>>
+  const V& operator[](const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Hash, K, KeyLike>>
+  bool contains(const KeyLike& key) const;
+  template<typename KeyLike, typename = transparent_lookup_t<Hash, K, KeyLike>>
+  V* find(const KeyLike& key);
+  template<typename KeyLike, typename = transparent_lookup_t<Hash, K, KeyLike>>
+  const V* find(const KeyLike& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
   // Returns the keys k in the collection such that k1 <= k <= k2
   ArraySeq<K> find_keys(const K& k1, const K& k2) const;
 
-  // Returns the keys in the collection in ascending sorted order
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
+  // Returns the keys in the collection in ascending sorted order.
+  // Maps of at least parallel_sort_min keys are sorted with
+  // sort_threads() threads.
   ArraySeq<K> sorted_keys() const;  
 
+  // Returns the keys in the collection in ascending sorted order,
+  // sorting with the given number of threads (0 for one per hardware
+  // thread) if there are at least parallel_sort_min keys
+  ArraySeq<K> sorted_keys(int threads) const;
+
+  // Sets the number of threads sorted_keys() uses for large maps, for
+  // every map of this type. 0 (the default) uses one per hardware
+  // thread, and 1 always sorts on the calling thread. Safe to call
+  // while other threads are sorting.
+  static void set_sort_threads(int threads);
+
+  // Returns the thread count set by set_sort_threads
+  static int sort_threads();
+
+  // sorted_keys only starts threads for maps of at least this many
+  // keys, below it the threads cost more than they save
+  static const int parallel_sort_min = 1 << 17;
+
+  // Calls f(key, value) on each key-value pair, in table order (not
+  // sorted)
+  template<typename F>
+  void for_each(F f) const;
+
+  // Returns the (up to) n smallest keys k in the collection such that
+  // k1 <= k, in ascending sorted order, without sorting every key
+  ArraySeq<K> first_keys(const K& k1, int n) const;
+
   // Gives the key (as an ouptput parameter) immediately after the
   // given key according to ascending sort order. Returns true if a
   // successor key exists, and false otherwise.
@@ -92,9 +179,13 @@ private:
 
   // node for linked-list separate chaining
   struct Node {
+    // builds the key from key and the value from args
+    template<typename KeyArg, typename... Args>
+    Node(KeyArg&& key, Args&&... args)
+      : key(std::forward<KeyArg>(key)), value(std::forward<Args>(args)...) {}
     K key;
     V value;
-    Node* next;
+    Node* next = nullptr;
   };
 
   // number of key-value pairs in map
@@ -109,8 +200,31 @@ private:
   // array of linked lists
   Node** table = new Node*[capacity];
 
-  // the hash function
-  int hash(const K& key) const;
+  // allocator for the nodes
+  Alloc<Node> nodes;
+
+  // thread count for sorted_keys(), shared by every map of this type
+  static std::atomic<int> default_sort_threads;
+
+  // the key hash
+  Hash hash_code;
+
+  // the hash function, gives the key's index in the table. The key
+  // can be a K or, if Hash is transparent, a KeyLike.
+  template<typename KeyLike>
+  int hash(const KeyLike& key) const;
+
+  // returns the key's node, or nullptr if it is not in the map
+  template<typename KeyLike>
+  Node* find_node(const KeyLike& key) const;
+
+  // returns the link to the key's node in the chain at the given
+  // index, or the null link at the end of the chain
+  Node** find_link(const K& key, int index);
+
+  // adds a node whose key is not in the map to the front of the chain
+  // at index (the key's hash), growing the table first if needed
+  void add(Node* new_node, int index);
 
   // resize and rehash the table
   void resize_and_rehash();
@@ -121,31 +235,31 @@ private:
 };
 
 
-template<typename K, typename V>
-HashMap<K,V>::HashMap()
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+HashMap<K, V, Alloc, Hash>::HashMap()
 {
   init_table();
 }
 
 // copy constructor
-template<typename K, typename V>
-HashMap<K, V>::HashMap(const HashMap& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+HashMap<K, V, Alloc, Hash>::HashMap(const HashMap& rhs)
 {
   init_table();
   *this = rhs;
 }
 
 // move constructor
-template<typename K, typename V>
-HashMap<K, V>::HashMap(HashMap&& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+HashMap<K, V, Alloc, Hash>::HashMap(HashMap&& rhs)
 {
   init_table();
   *this = std::move(rhs);
 }
 
 // copy assignment
-template<typename K, typename V>
-HashMap<K, V>& HashMap<K, V>::operator=(const HashMap<K, V>& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+HashMap<K, V, Alloc, Hash>& HashMap<K, V, Alloc, Hash>::operator=(const HashMap<K, V, Alloc, Hash>& rhs)
 {
   if(this != &rhs){
     clear();
@@ -161,11 +275,12 @@ HashMap<K, V>& HashMap<K, V>::operator=(const HashMap<K, V>& rhs)
       }
     }
   }
+  return *this;
 }
 
 // move assignment
-template<typename K, typename V>
-HashMap<K, V>& HashMap<K, V>::operator=(HashMap<K, V>&& rhs)
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+HashMap<K, V, Alloc, Hash>& HashMap<K, V, Alloc, Hash>::operator=(HashMap<K, V, Alloc, Hash>&& rhs)
 {
   if(this != &rhs){
     clear();
@@ -173,124 +288,239 @@ HashMap<K, V>& HashMap<K, V>::operator=(HashMap<K, V>&& rhs)
     table = rhs.table;
     capacity = rhs.capacity;
     count = rhs.count;
+    nodes = std::move(rhs.nodes);
     rhs.capacity = 16;
     rhs.count = 0;
     rhs.table = new Node*[rhs.capacity];
     rhs.init_table();
   }
+  return *this;
 }  
 
 // destructor
-template<typename K, typename V>
-HashMap<K, V>::~HashMap()
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+HashMap<K, V, Alloc, Hash>::~HashMap()
 {
   clear();
   delete[] table;
 }
 
 // Returns the number of key-value pairs in the map
-template<typename K, typename V>
-int HashMap<K, V>::size() const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+int HashMap<K, V, Alloc, Hash>::size() const
 {
   return count;
 }
 
 // Tests if the map is empty
-template<typename K, typename V>
-bool HashMap<K, V>::empty() const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+bool HashMap<K, V, Alloc, Hash>::empty() const
 {
   return count == 0;
 }
 
 // Allows values associated with a key to be updated. Throws
 // out_of_range if the given key is not in the collection.
-template<typename K, typename V>
-V& HashMap<K, V>::operator[](const K& key)
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+V& HashMap<K, V, Alloc, Hash>::operator[](const K& key)
 {
-  if(!contains(key)){
+  V* value = find(key);
+  if(!value){
     throw std::out_of_range("Out of Range in Operator"); 
   }
-  int index = hash(key);
-  Node* temp = table[index];
-  while(temp){
-    if(temp -> key == key){
-      return temp -> value;
-    }
-  }
+  return *value;
 }
 
 // Returns the value for a given key. Throws out_of_range if the
 // given key is not in the collection. 
-template<typename K, typename V>
-const V& HashMap<K, V>::operator[](const K& key) const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+const V& HashMap<K, V, Alloc, Hash>::operator[](const K& key) const
 {
-  if(!contains(key)){
+  const V* value = find(key);
+  if(!value){
     throw std::out_of_range("Out of Range in Operator"); 
   }
-  int index = hash(key);
-  Node* temp = table[index];
-  while(temp){
-    if(temp -> key == key){
-      return temp -> value;
-    }
-  }
+  return *value;
 }
 
 // Extends the collection by adding the given key-value pair.
 // Expects key to not exist in map prior to insertion.
-template<typename K, typename V>
-void HashMap<K, V>::insert(const K& key, const V& value)
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::insert(const K& key, const V& value)
 {
-  if(count/(capacity*1.0) >= load_factor_threshold){
-    resize_and_rehash();
-  }
-  int index = hash(key);
-  Node* temp = table[index];
-  Node* insertNode = new Node;
-  insertNode -> key = key;
-  insertNode -> value = value;
-  insertNode -> next = temp;
-  table[index] = insertNode;
-  count++;
+  emplace(key, value);
+}
+
+// Extends the collection by moving the given key-value pair into
+// it. Expects key to not exist in map prior to insertion.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::insert(K&& key, V&& value)
+{
+  emplace(std::move(key), std::move(value));
+}
+
+// Extends the collection with a key made from key and a value
+// constructed in place from args. The node is built first and its
+// key is hashed. Expects key to not exist in map prior to insertion.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename KeyArg, typename... Args>
+void HashMap<K, V, Alloc, Hash>::emplace(KeyArg&& key, Args&&... args)
+{
+  Node* new_node = nodes.create(std::forward<KeyArg>(key), std::forward<Args>(args)...);
+  add(new_node, hash(new_node -> key));
 }
 
 // Shrinks the collection by removing the key-value pair with the
 // given key. Does not modify the collection if the collection does
 // not contain the key. Throws out_of_range if the given key is not
 // in the collection.
-template<typename K, typename V>
-void HashMap<K, V>::erase(const K& key)
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::erase(const K& key)
 {
-  if(!contains(key)){
+  if(!try_erase(key)){
     throw std::out_of_range("Out of Range in Erase"); 
   }
-  int index = hash(key);
-  Node* temp = table[index] -> next;
-  delete table[index];
-  table[index] = temp;
-  count--;
 }
 
 // Returns true if the key is in the collection, and false otherwise.
-template<typename K, typename V>
-bool HashMap<K, V>::contains(const K& key) const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+bool HashMap<K, V, Alloc, Hash>::contains(const K& key) const
+{
+  return find_node(key) != nullptr;
+}
+
+// Returns a pointer to the value for the given key, or nullptr if
+// the key is not in the collection
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+V* HashMap<K, V, Alloc, Hash>::find(const K& key)
+{
+  Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+// Returns a pointer to the value for the given key as a constant,
+// or nullptr if the key is not in the collection
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+const V* HashMap<K, V, Alloc, Hash>::find(const K& key) const
+{
+  const Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+// Transparent lookup. Allows values associated with a key to be
+// updated. Throws out_of_range if no key equals the given one.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename KeyLike, typename>
+V& HashMap<K, V, Alloc, Hash>::operator[](const KeyLike& key)
+{
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator"); 
+  }
+  return *value;
+}
+
+// Transparent lookup. Returns the value for a given key. Throws
+// out_of_range if no key equals the given one.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename KeyLike, typename>
+const V& HashMap<K, V, Alloc, Hash>::operator[](const KeyLike& key) const
+{
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator"); 
+  }
+  return *value;
+}
+
+// Transparent lookup. Returns true if a key equal to the given one is
+// in the collection, and false otherwise.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename KeyLike, typename>
+bool HashMap<K, V, Alloc, Hash>::contains(const KeyLike& key) const
+{
+  return find_node(key) != nullptr;
+}
+
+// Transparent lookup. Returns a pointer to the value for the matching
+// key, or nullptr if there is none.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename KeyLike, typename>
+V* HashMap<K, V, Alloc, Hash>::find(const KeyLike& key)
+{
+  Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+// Transparent lookup. Returns a pointer to the value for the matching
+// key as a constant, or nullptr if there is none.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename KeyLike, typename>
+const V* HashMap<K, V, Alloc, Hash>::find(const KeyLike& key) const
+{
+  const Node* node = find_node(key);
+  return node ? &node -> value : nullptr;
+}
+
+// Sets the value for the given key, adding the key-value pair if
+// the key is not in the collection. Returns true if the pair was
+// added. The key is hashed once.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+bool HashMap<K, V, Alloc, Hash>::insert_or_assign(const K& key, const V& value)
 {
   int index = hash(key);
-  Node* temp = table[index];
-  while(temp){
-    if(temp -> key == key){
-      return true;
-    }
-    temp = temp -> next;
+  Node** link = find_link(key, index);
+  if(*link){
+    (*link) -> value = value;
+    return false;
+  }
+  add(nodes.create(key, value), index);
+  return true;
+}
+
+// Adds the key-value pair only if the key is not in the
+// collection. Returns true if the pair was added.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+bool HashMap<K, V, Alloc, Hash>::try_emplace(const K& key, const V& value)
+{
+  int index = hash(key);
+  if(*find_link(key, index)){
+    return false;
   }
-  return false;
+  add(nodes.create(key, value), index);
+  return true;
+}
+
+// Removes the key-value pair with the given key if there is
+// one. Returns true if a pair was removed.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+bool HashMap<K, V, Alloc, Hash>::try_erase(const K& key)
+{
+  Node** link = find_link(key, hash(key));
+  if(!*link){
+    return false;
+  }
+  Node* temp = *link;
+  *link = temp -> next;
+  nodes.destroy(temp);
+  count--;
+  return true;
 }
 
 // Returns the keys k in the collection such that k1 <= k <= k2
-template<typename K, typename V>
-ArraySeq<K> HashMap<K, V>::find_keys(const K& k1, const K& k2) const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+ArraySeq<K> HashMap<K, V, Alloc, Hash>::find_keys(const K& k1, const K& k2) const
 {
   ArraySeq<K> keys;
+  find_keys(k1, k2, keys);
+  return keys;
+}
+
+// Adds the keys k in the collection such that k1 <= k <= k2 to the
+// given sequence
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
   for(int i = 0; i < capacity; i++){
     Node* temp = table[i];
     while(temp){
@@ -300,30 +530,89 @@ ArraySeq<K> HashMap<K, V>::find_keys(const K& k1, const K& k2) const
       temp = temp -> next;
     }
   }
-  return keys;
 }
 
 // Returns the keys in the collection in ascending sorted order
-template<typename K, typename V>
-ArraySeq<K> HashMap<K, V>::sorted_keys() const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+ArraySeq<K> HashMap<K, V, Alloc, Hash>::sorted_keys() const
+{
+  return sorted_keys(sort_threads());
+}
+
+// Returns the keys in ascending sorted order, sorted on the given
+// number of threads when the map is large. The keys are unique, so
+// the parallel sort not being stable does not change the result.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+ArraySeq<K> HashMap<K, V, Alloc, Hash>::sorted_keys(int threads) const
 {
   ArraySeq<K> keys;
+  keys.reserve(count);
   for(int i = 0; i < capacity; i++){
     Node* temp = table[i];
     while(temp){
-      keys.insert(temp -> key, keys.size());
+      keys.push_back(temp -> key);
       temp = temp -> next;
     }
   }
-  keys.sort();
+  if(threads != 1 && count >= parallel_sort_min){
+    keys.parallel_sort(threads);
+  } else {
+    keys.sort();
+  }
   return keys;
 }
 
+// Sets the thread count sorted_keys() uses for large maps
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::set_sort_threads(int threads)
+{
+  default_sort_threads.store(threads < 0 ? 0 : threads, std::memory_order_relaxed);
+}
+
+// Returns the thread count sorted_keys() uses for large maps
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+int HashMap<K, V, Alloc, Hash>::sort_threads()
+{
+  return default_sort_threads.load(std::memory_order_relaxed);
+}
+
+// Calls f(key, value) on each key-value pair, in table order (not
+// sorted)
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename F>
+void HashMap<K, V, Alloc, Hash>::for_each(F f) const
+{
+  for(int i = 0; i < capacity; i++){
+    for(const Node* temp = table[i]; temp; temp = temp -> next){
+      f(temp -> key, temp -> value);
+    }
+  }
+}
+
+// Returns the (up to) n smallest keys k in the collection such that
+// k1 <= k, in ascending sorted order. The keys are streamed through a
+// bounded heap, so this is O(count log n) rather than a full sort.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+ArraySeq<K> HashMap<K, V, Alloc, Hash>::first_keys(const K& k1, int n) const
+{
+  TopK<K> keys(n < count ? n : count);
+  for(int i = 0; i < capacity; i++){
+    Node* temp = table[i];
+    while(temp){
+      if(temp -> key >= k1){
+        keys.push(temp -> key);
+      }
+      temp = temp -> next;
+    }
+  }
+  return keys.sorted();
+}
+
 // Gives the key (as an ouptput parameter) immediately after the
 // given key according to ascending sort order. Returns true if a
 // successor key exists, and false otherwise.
-template<typename K, typename V>
-bool HashMap<K, V>::next_key(const K& key, K& next_key) const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+bool HashMap<K, V, Alloc, Hash>::next_key(const K& key, K& next_key) const
 {
   K temp_next_key = key;
   for(int i = 0; i < capacity; i++){
@@ -346,8 +635,8 @@ bool HashMap<K, V>::next_key(const K& key, K& next_key) const
 // Gives the key (as an ouptput parameter) immediately before the
 // given key according to ascending sort order. Returns true if a
 // predecessor key exists, and false otherwise.
-template<typename K, typename V>
-bool HashMap<K, V>::prev_key(const K& key, K& next_key) const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+bool HashMap<K, V, Alloc, Hash>::prev_key(const K& key, K& next_key) const
 {
   K temp_prev_key = key;
   for(int i = 0; i < capacity; i++){
@@ -368,24 +657,30 @@ bool HashMap<K, V>::prev_key(const K& key, K& next_key) const
 }
 
 // Removes all key-value pairs from the map. Does not change the
-// current capacity of the table.
-template<typename K, typename V>
-void HashMap<K, V>::clear()
+// current capacity of the table. Pool allocated nodes that need no
+// destructor are dropped with their slabs instead of one at a time.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::clear()
 {
-  for(int i = 0; i < capacity; i++){
-    Node* temp = table[i];
-    while(temp){
-      temp = temp -> next;
-      delete table[i];
-      table[i] = temp;
+  if(Alloc<Node>::bulk && std::is_trivially_destructible<Node>::value){
+    init_table();
+  } else {
+    for(int i = 0; i < capacity; i++){
+      Node* temp = table[i];
+      while(temp){
+        temp = temp -> next;
+        nodes.destroy(table[i]);
+        table[i] = temp;
+      }
     }
   }
+  nodes.release();
   count = 0;
 }
 
 // statistics functions for the hash table implementation
-template<typename K, typename V>
-int HashMap<K, V>::min_chain_length() const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+int HashMap<K, V, Alloc, Hash>::min_chain_length() const
 {
   if(empty()){
     return 0;
@@ -407,8 +702,8 @@ int HashMap<K, V>::min_chain_length() const
   return min;
 }
 
-template<typename K, typename V>
-int HashMap<K, V>::max_chain_length() const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+int HashMap<K, V, Alloc, Hash>::max_chain_length() const
 {
   if(empty()){
     return 0;
@@ -430,8 +725,8 @@ int HashMap<K, V>::max_chain_length() const
   return max;
 }
 
-template<typename K, typename V>
-double HashMap<K, V>::avg_chain_length() const
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+double HashMap<K, V, Alloc, Hash>::avg_chain_length() const
 {
   if(empty()){
     return 0.0;
@@ -445,45 +740,85 @@ double HashMap<K, V>::avg_chain_length() const
   return (count/total_links);
 }
 
-// the hash function
-template<typename K, typename V>
-int HashMap<K, V>::hash(const K& key) const
+// the hash function, gives the key's index in the table. The key
+// can be a K or, if Hash is transparent, a KeyLike.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename KeyLike>
+int HashMap<K, V, Alloc, Hash>::hash(const KeyLike& key) const
 {
-  std::hash<K>hash_code;
   return hash_code(key) % capacity;
 }
 
-// resize and rehash the table
-template<typename K, typename V>
-void HashMap<K, V>::resize_and_rehash()
+// returns the key's node, or nullptr if it is not in the map
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+template<typename KeyLike>
+typename HashMap<K, V, Alloc, Hash>::Node* HashMap<K, V, Alloc, Hash>::find_node(const KeyLike& key) const
+{
+  Node* temp = table[hash(key)];
+  while(temp){
+    if(temp -> key == key){
+      return temp;
+    }
+    temp = temp -> next;
+  }
+  return nullptr;
+}
+
+// returns the link to the key's node in the chain at the given
+// index, or the null link at the end of the chain
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+typename HashMap<K, V, Alloc, Hash>::Node** HashMap<K, V, Alloc, Hash>::find_link(const K& key, int index)
+{
+  Node** link = &table[index];
+  while(*link && !((*link) -> key == key)){
+    link = &(*link) -> next;
+  }
+  return link;
+}
+
+// adds the node to the front of its chain. If the table has to grow
+// first, the key is hashed again for the new capacity.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::add(Node* new_node, int index)
+{
+  if(count/(capacity*1.0) >= load_factor_threshold){
+    resize_and_rehash();
+    index = hash(new_node -> key);
+  }
+  new_node -> next = table[index];
+  table[index] = new_node;
+  count++;
+}
+
+// resize and rehash the table. The nodes are relinked into the new
+// table rather than copied, so no nodes are allocated or freed.
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::resize_and_rehash()
 {
   int old_capacity = capacity;
   capacity = capacity * 2;
-  count = 0;
   Node** old_table = table;
   table = new Node*[capacity];
   init_table();
   for(int i = 0; i < old_capacity; i++){
     Node* temp = old_table[i];
     while(temp){
-      insert(temp -> key, temp -> value);
-      temp = temp -> next;
-    }
-  }
-  for(int i = 0; i < old_capacity; i++){
-    Node* temp = old_table[i];
-    while(temp){
-      temp = temp -> next;
-      delete old_table[i];
-      old_table[i] = temp;
+      Node* next = temp -> next;
+      int index = hash(temp -> key);
+      temp -> next = table[index];
+      table[index] = temp;
+      temp = next;
     }
   }
   delete[] old_table;
 }
 
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+std::atomic<int> HashMap<K, V, Alloc, Hash>::default_sort_threads{0};
+
 // initialize the table to all nullptr
-template<typename K, typename V>
-void HashMap<K, V>::init_table()
+template<typename K, typename V, template<typename> class Alloc, typename Hash>
+void HashMap<K, V, Alloc, Hash>::init_table()
 {
   for(int i = 0; i < capacity; i++){
     table[i] = nullptr;
@@ -27,18 +27,31 @@
 #include "hashmap.h"
 #include "bstmap.h"
 #include "avlmap.h"
+#include "pmamap.h"
 
 using namespace std;
 using namespace std::chrono;
 
 // NOTE: all data is "shuffled"
 
-double timed_insert(Map<int,int>& m, int key);
-double timed_erase(Map<int,int>& m, int key);
-double timed_contains(const Map<int,int>& m, int key);
-double timed_find_range(const Map<int,int>& m, int key1, int key2);
-double timed_next_key(const Map<int,int>& m, int key); 
-double timed_sorted_keys(const Map<int,int>& m);
+// The timing functions take the concrete map type, so the timed calls
+// are bound statically (the maps are final) rather than through the
+// Map vtable. Lookup results go to sink so that the inlined calls are
+// not optimized away.
+volatile bool sink;
+
+template<typename M>
+double timed_insert(M& m, int key);
+template<typename M>
+double timed_erase(M& m, int key);
+template<typename M>
+double timed_contains(const M& m, int key);
+template<typename M>
+double timed_find_range(const M& m, int key1, int key2);
+template<typename M>
+double timed_next_key(const M& m, int key); 
+template<typename M>
+double timed_sorted_keys(const M& m);
 
 // test parameters
 const int start = 0;
@@ -90,6 +103,13 @@ int main(int argc, char* argv[])
   cout << "# Column 26 = bst map height" << endl;
   cout << "# Column 27 = avl map height" << endl;
   cout << "# Column 28 = log base 2 of input size" << endl;  
+
+  cout << "# Column 29 = pma map insert" << endl;
+  cout << "# Column 30 = pma map erase" << endl;
+  cout << "# Column 31 = pma map contains" << endl;
+  cout << "# Column 32 = pma map find range" << endl;
+  cout << "# Column 33 = pma map next key" << endl;
+  cout << "# Column 34 = pma map sorted keys" << endl;
   
   // generate shuffled data
   ArraySeq<int> keys, vals;
@@ -106,11 +126,13 @@ int main(int argc, char* argv[])
     HashMap<int,int> m2;
     BSTMap<int,int> m3;    
     AVLMap<int,int> m4;
+    PMAMap<int,int> m5;
     for (int i = 0; i < n; ++i) {
       m1.insert(keys[i], vals[i]);
       m2.insert(keys[i], vals[i]);
       m3.insert(keys[i], vals[i]);
       m4.insert(keys[i], vals[i]);
+      m5.insert(keys[i], vals[i]);
     }
 
     int min = 2;
@@ -192,6 +214,21 @@ int main(int argc, char* argv[])
     cout << c27 << " " << flush;
     int c28 = (n == 0) ? 0 : ceil(log2(n));
     cout << c28 << " " << flush;
+
+    // pma map
+    double c29 = timed_insert(m5, med + 1);
+    cout << c29 << " " << flush;
+    double c30 = timed_erase(m5, med + 1);
+    cout << c30 << " " << flush;
+    assert(m5.size() == n);
+    double c31 = timed_contains(m5, max + 1);
+    cout << c31 << " " << flush;
+    double c32 = timed_find_range(m5, med, med + (n/20));
+    cout << c32 << " " << flush;
+    double c33 = timed_next_key(m5, med);
+    cout << c33 << " " << flush;
+    double c34 = timed_sorted_keys(m5);
+    cout << c34 << " " << flush;
     
     cout << endl;
   }
@@ -200,7 +237,8 @@ int main(int argc, char* argv[])
 
 
 // assumes keys are multiples of 2 and key to insert is odd
-double timed_insert(Map<int,int>& m, int key)
+template<typename M>
+double timed_insert(M& m, int key)
 {
   double total = 0;
   for (int r = 0; r < runs; ++r) {
@@ -213,7 +251,8 @@ double timed_insert(Map<int,int>& m, int key)
 }
 
 // removes the odd values inserted from timed_insert
-double timed_erase(Map<int,int>& m, int key)
+template<typename M>
+double timed_erase(M& m, int key)
 {
   double total = 0;
   for (int r = 0; r < runs; ++r) {
@@ -225,19 +264,21 @@ double timed_erase(Map<int,int>& m, int key)
   return (total/1000) / runs;
 }
 
-double timed_contains(const Map<int,int>& m, int key) 
+template<typename M>
+double timed_contains(const M& m, int key) 
 {
   double total = 0;
   for (int r = 0; r < runs; ++r) {
     auto t0 = high_resolution_clock::now();
-    m.contains(key);
+    sink = m.contains(key);
     auto t1 = high_resolution_clock::now();
     total += duration_cast<microseconds>(t1 - t0).count();
   }
   return (total/1000) / runs;
 }
 
-double timed_find_range(const Map<int,int>& m, int key1, int key2)
+template<typename M>
+double timed_find_range(const M& m, int key1, int key2)
 {
   double total = 0;
   for (int r = 0; r < runs; ++r) {
@@ -249,13 +290,14 @@ double timed_find_range(const Map<int,int>& m, int key1, int key2)
   return (total/1000) / runs;
 }
 
-double timed_next_key(const Map<int,int>& m, int key)
+template<typename M>
+double timed_next_key(const M& m, int key)
 {
   double total = 0;
   for (int r = 0; r < runs; ++r) {
     auto t0 = high_resolution_clock::now();
     int next_key;
-    m.next_key(key, next_key);
+    sink = m.next_key(key, next_key);
     auto t1 = high_resolution_clock::now();
     total += duration_cast<microseconds>(t1 - t0).count();
   }
@@ -263,7 +305,8 @@ double timed_next_key(const Map<int,int>& m, int key)
 }
 
 
-double timed_sorted_keys(const Map<int,int>& m)
+template<typename M>
+double timed_sorted_keys(const M& m)
 {
   double total = 0;
   for (int r = 0; r < runs; ++r) {
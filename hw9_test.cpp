@@ -7,9 +7,31 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <map>
+#include <climits>
+#include <functional>
+#include <thread>
+#include <chrono>
 #include <gtest/gtest.h>
 #include "arrayseq.h"
 #include "avlmap.h"
+#include "arraymap.h"
+#include "binsearchmap.h"
+#include "pmamap.h"
+#include "adaptivemap.h"
+#include "workloadmap.h"
+#include "simdsearch.h"
+#include "sortnet.h"
+#include "smallseq.h"
+#include "gapseq.h"
+#include "topk.h"
+#include "hashmap.h"
+#include "bstmap.h"
+#include "poolalloc.h"
+#include "compactavlmap.h"
+#include "keyhash.h"
+#include "staticmap.h"
 
 using namespace std;
 
@@ -553,7 +575,1660 @@ TEST(BasicAVLMapTests, EraseRebalanceCheck) {
   ASSERT_EQ(3, c3.height());
 }
 
+TEST(BasicAVLMapTests, LargeInsertEraseCheck) {
+  AVLMap<int,int> m;
+  // in order inserts rotate at most once each and stay balanced
+  for (int i = 0; i < 65535; ++i)
+    m.insert(i, i);
+  ASSERT_EQ(16, m.height());
+  // erase in a scattered order, through nodes with two children
+  for (int i = 0; i < 65535; i += 3)
+    m.erase((i * 7919) % 65535);
+  ASSERT_EQ(43690, m.size());
+  ASSERT_LE(m.height(), 16);
+  ASSERT_THROW(m.erase(0), std::out_of_range);
+  ArraySeq<int> keys = m.sorted_keys();
+  for (int i = 1; i < keys.size(); ++i)
+    ASSERT_LT(keys[i - 1], keys[i]);
+  for (int i = 0; i < 65535; i += 3)
+    m.insert((i * 7919) % 65535, i);
+  ASSERT_EQ(65535, m.size());
+  ASSERT_LE(m.height(), 18);
+}
+
+
+
+//----------------------------------------------------------------------
+// Basic Tests for the ArrayMap implementation of Map
+//----------------------------------------------------------------------
+
+TEST(BasicArrayMapTests, UnorderedKeyCheck)
+{
+  ArrayMap<char,int> m;
+  m.insert('e', 50);
+  m.insert('a', 10);
+  m.insert('h', 80);
+  m.insert('c', 30);
+  m['h'] = 90;
+  ASSERT_EQ(90, m['h']);
+  char key = 0;
+  ASSERT_EQ(true, m.next_key('c', key));
+  ASSERT_EQ('e', key);
+  ASSERT_EQ(true, m.prev_key('e', key));
+  ASSERT_EQ('c', key);
+  ASSERT_EQ(false, m.next_key('h', key));
+  ASSERT_EQ(false, m.prev_key('a', key));
+  m.erase('a');
+  ArraySeq<char> k = m.sorted_keys();
+  ASSERT_EQ(3, k.size());
+  ASSERT_EQ('c', k[0]);
+  ASSERT_EQ('e', k[1]);
+  ASSERT_EQ('h', k[2]);
+}
+
+
+//----------------------------------------------------------------------
+// Basic Tests for the BinSearchMap write buffer
+//----------------------------------------------------------------------
+
+TEST(BasicBinSearchMapTests, BufferedInsertCheck)
+{
+  BinSearchMap<int,int> m;
+  // out of order inserts go through the write buffer and merges
+  for (int i = 0; i < 1000; ++i)
+    m.insert((i * 7919) % 1000, i);
+  ASSERT_EQ(1000, m.size());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i, m[(i * 7919) % 1000]);
+  ArraySeq<int> k = m.sorted_keys();
+  ASSERT_EQ(1000, k.size());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i, k[i]);
+}
+
+TEST(BasicBinSearchMapTests, UnmergedQueryCheck)
+{
+  BinSearchMap<int,int> m;
+  for (int i = 0; i < 10; ++i)
+    m.insert(i * 10, i);
+  // 15 is buffered and 20 is a tombstone until the next merge
+  m.insert(15, 1);
+  m.erase(20);
+  ASSERT_EQ(10, m.size());
+  ASSERT_EQ(true, m.contains(15));
+  ASSERT_EQ(false, m.contains(20));
+  EXPECT_THROW(m.erase(20), std::out_of_range);
+  int key = 0;
+  ASSERT_EQ(true, m.next_key(10, key));
+  ASSERT_EQ(15, key);
+  ASSERT_EQ(true, m.next_key(15, key));
+  ASSERT_EQ(30, key);
+  ASSERT_EQ(true, m.prev_key(30, key));
+  ASSERT_EQ(15, key);
+  ArraySeq<int> k = m.find_keys(10, 30);
+  ASSERT_EQ(3, k.size());
+  ASSERT_EQ(10, k[0]);
+  ASSERT_EQ(15, k[1]);
+  ASSERT_EQ(30, k[2]);
+  // re-inserting an erased key must not bring back the old value
+  m.insert(20, 200);
+  m.merge();
+  ASSERT_EQ(11, m.size());
+  ASSERT_EQ(200, m[20]);
+  ASSERT_EQ(1, m[15]);
+}
+
+TEST(BasicBinSearchMapTests, RunEraseCheck)
+{
+  BinSearchMap<int,int> m;
+  for (int i = 0; i < 4000; i += 2)
+    m.insert(i, i);
+  // the odd keys are flushed from the write buffer into several runs
+  for (int i = 999; i > 0; i -= 2)
+    m.insert(i, i);
+  // erase from the main run and the flushed runs, then bring some back
+  for (int i = 0; i < 1000; i += 3)
+    m.erase(i);
+  for (int i = 0; i < 1000; i += 6)
+    ASSERT_EQ(true, m.try_emplace(i, -i));
+  ASSERT_EQ(false, m.try_emplace(1, 0));
+  int expected = 0;
+  int prev = -1;
+  m.for_each([&](const int& key, const int& value) {
+    ASSERT_LT(prev, key);
+    ASSERT_EQ(key % 6 == 0 && key < 1000 ? -key : key, value);
+    prev = key;
+    ++expected;
+  });
+  ASSERT_EQ(m.size(), expected);
+  ASSERT_EQ(false, m.contains(3));
+  ASSERT_EQ(true, m.contains(6));
+  ASSERT_EQ(true, m.contains(1002));
+  ArraySeq<int> k = m.find_keys(0, 10);
+  ASSERT_EQ(9, k.size());
+  ASSERT_EQ(0, k[0]);
+  ASSERT_EQ(4, k[3]);
+  ASSERT_EQ(10, k[8]);
+  m.merge();
+  ASSERT_EQ(expected, m.size());
+  ASSERT_EQ(expected, m.sorted_keys().size());
+}
+
+
+//----------------------------------------------------------------------
+// Basic Tests for the PMAMap implementation of Map
+//----------------------------------------------------------------------
+
+TEST(BasicPMAMapTests, InsertAndContainsCheck)
+{
+  PMAMap<int,int> m;
+  // insert in a shuffled order to force segment redistributions
+  for (int i = 0; i < 1000; ++i)
+    m.insert((i * 7919) % 1000, i);
+  ASSERT_EQ(1000, m.size());
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(true, m.contains(i));
+    ASSERT_EQ(i, m[(i * 7919) % 1000]);
+  }
+  ASSERT_EQ(false, m.contains(-1));
+  ASSERT_EQ(false, m.contains(1000));
+  ArraySeq<int> k = m.sorted_keys();
+  ASSERT_EQ(1000, k.size());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i, k[i]);
+}
+
+TEST(BasicPMAMapTests, EraseCheck)
+{
+  PMAMap<int,int> m;
+  for (int i = 0; i < 1000; ++i)
+    m.insert(i, i);
+  // erase every other key and then the rest to shrink the array
+  for (int i = 0; i < 1000; i += 2)
+    m.erase(i);
+  ASSERT_EQ(500, m.size());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i % 2 == 1, m.contains(i));
+  for (int i = 999; i >= 1; i -= 2)
+    m.erase(i);
+  ASSERT_EQ(true, m.empty());
+  EXPECT_THROW(m.erase(1), std::out_of_range);
+  m.insert(5, 50);
+  ASSERT_EQ(50, m[5]);
+}
+
+TEST(BasicPMAMapTests, KeyRangeCheck)
+{
+  PMAMap<int,int> m;
+  for (int i = 100; i > 0; --i)
+    m.insert(i * 2, i);
+  ArraySeq<int> k = m.find_keys(11, 40);
+  ASSERT_EQ(15, k.size());
+  for (int i = 0; i < 15; ++i)
+    ASSERT_EQ(12 + i * 2, k[i]);
+  int key = 0;
+  ASSERT_EQ(true, m.next_key(11, key));
+  ASSERT_EQ(12, key);
+  ASSERT_EQ(true, m.next_key(12, key));
+  ASSERT_EQ(14, key);
+  ASSERT_EQ(false, m.next_key(200, key));
+  ASSERT_EQ(true, m.prev_key(12, key));
+  ASSERT_EQ(10, key);
+  ASSERT_EQ(true, m.prev_key(201, key));
+  ASSERT_EQ(200, key);
+  ASSERT_EQ(false, m.prev_key(2, key));
+}
+
+TEST(BasicPMAMapTests, CopyAndMoveCheck)
+{
+  PMAMap<int,int> m1;
+  for (int i = 0; i < 100; ++i)
+    m1.insert(i, i * 10);
+  PMAMap<int,int> m2(m1);
+  m1.erase(50);
+  ASSERT_EQ(100, m2.size());
+  ASSERT_EQ(500, m2[50]);
+  PMAMap<int,int> m3(std::move(m2));
+  ASSERT_EQ(0, m2.size());
+  ASSERT_EQ(100, m3.size());
+  m2 = m3;
+  ASSERT_EQ(990, m2[99]);
+}
+
+
+//----------------------------------------------------------------------
+// Basic Tests for the AdaptiveMap implementation of Map
+//----------------------------------------------------------------------
+
+TEST(BasicAdaptiveMapTests, GrowAndShrinkCheck)
+{
+  typedef AdaptiveMap<int,int> IntMap;
+  IntMap m(4, 16);
+  ASSERT_EQ(IntMap::ARRAY, m.representation());
+  for (int i = 0; i < 5; ++i)
+    m.insert(i, i * 10);
+  ASSERT_EQ(IntMap::BINSEARCH, m.representation());
+  for (int i = 5; i < 17; ++i)
+    m.insert(i, i * 10);
+  ASSERT_EQ(IntMap::TREE, m.representation());
+  ASSERT_EQ(17, m.size());
+  for (int i = 0; i < 17; ++i)
+    ASSERT_EQ(i * 10, m[i]);
+  // stays a tree until the size drops below half the limit
+  m.erase(16);
+  m.erase(15);
+  ASSERT_EQ(IntMap::TREE, m.representation());
+  for (int i = 14; i >= 7; --i)
+    m.erase(i);
+  ASSERT_EQ(IntMap::BINSEARCH, m.representation());
+  for (int i = 6; i >= 1; --i)
+    m.erase(i);
+  ASSERT_EQ(IntMap::ARRAY, m.representation());
+  ASSERT_EQ(1, m.size());
+  ASSERT_EQ(0, m[0]);
+}
+
+TEST(BasicAdaptiveMapTests, CopyCheck)
+{
+  AdaptiveMap<int,int> m1(4, 16);
+  for (int i = 0; i < 20; ++i)
+    m1.insert(i, i);
+  AdaptiveMap<int,int> m2(m1);
+  m2.insert(20, 20);
+  m1.erase(0);
+  ASSERT_EQ(19, m1.size());
+  ASSERT_EQ(21, m2.size());
+  ASSERT_EQ(true, m2.contains(0));
+  ArraySeq<int> k = m2.sorted_keys();
+  for (int i = 0; i < 21; ++i)
+    ASSERT_EQ(i, k[i]);
+}
+
+
+//----------------------------------------------------------------------
+// Basic Tests for the WorkloadMap implementation of Map
+//----------------------------------------------------------------------
+
+TEST(BasicWorkloadMapTests, SwitchRepresentationCheck)
+{
+  typedef WorkloadMap<int,int> IntMap;
+  IntMap m(10, 0.1);
+  ASSERT_EQ(IntMap::TREE, m.representation());
+  // point reads and writes only (two windows) -> hash table
+  for (int i = 0; i < 10; ++i)
+    m.insert(i, i);
+  for (int i = 0; i < 10; ++i)
+    m.contains(i);
+  m.wait_for_rebuild();
+  ASSERT_EQ(IntMap::HASH, m.representation());
+  // read-only with range queries (two windows) -> sorted array
+  for (int i = 0; i < 20; ++i)
+    m.find_keys(0, i);
+  m.wait_for_rebuild();
+  ASSERT_EQ(IntMap::SORTED, m.representation());
+  ASSERT_EQ(10, m.size());
+  for (int i = 0; i < 10; ++i)
+    ASSERT_EQ(i, m[i]);
+}
+
+TEST(BasicWorkloadMapTests, WritesDuringRebuildCheck)
+{
+  typedef WorkloadMap<int,int> IntMap;
+  IntMap m(10, 0.1);
+  for (int i = 0; i < 20; ++i)
+    m.insert(i, i);
+  // the rebuild to a hash table starts at the end of the second
+  // window, these writes happen after its snapshot
+  m.insert(100, 100);
+  m.erase(0);
+  m[1] = 10;
+  m.wait_for_rebuild();
+  ASSERT_EQ(IntMap::HASH, m.representation());
+  ASSERT_EQ(20, m.size());
+  ASSERT_EQ(false, m.contains(0));
+  ASSERT_EQ(10, m[1]);
+  ASSERT_EQ(100, m[100]);
+  ArraySeq<int> k = m.sorted_keys();
+  ASSERT_EQ(20, k.size());
+  ASSERT_EQ(1, k[0]);
+  ASSERT_EQ(100, k[19]);
+}
+
+TEST(BasicWorkloadMapTests, ConstReadsKeepMapCheck)
+{
+  typedef WorkloadMap<int,int> IntMap;
+  IntMap m(10, 0.1);
+  for (int i = 0; i < 20; ++i)
+    m.insert(i, i);
+  const IntMap& c = m;
+  // the rebuild to a hash table starts during these reads
+  for (int i = 0; i < 20; ++i)
+    ASSERT_EQ(true, c.contains(i));
+  const int& r = c[5];
+  // a const wait swaps in the hash table, and the tree it replaces is
+  // kept until the next non-const operation, so r is still valid
+  c.wait_for_rebuild();
+  ASSERT_EQ(IntMap::HASH, c.representation());
+  ASSERT_EQ(5, r);
+  ASSERT_EQ(true, c.contains(5));
+  m.insert(100, 100);
+  ASSERT_EQ(5, m[5]);
+  ASSERT_EQ(21, m.size());
+}
+
+TEST(BasicWorkloadMapTests, ReadOnlySwapCheck)
+{
+  typedef WorkloadMap<int,int> IntMap;
+  IntMap m(10, 0.1);
+  for (int i = 0; i < 10; ++i)
+    m.insert(i, i);
+  const IntMap& c = m;
+  // read-only range queries choose a sorted array, and with no
+  // non-const operation to come a const read must swap it in
+  for (int i = 0; i < 20; ++i)
+    c.find_keys(0, i);
+  auto start = std::chrono::steady_clock::now();
+  while (c.representation() != IntMap::SORTED &&
+         std::chrono::steady_clock::now() - start < std::chrono::seconds(10)) {
+    ASSERT_EQ(3, c.find_keys(0, 2).size());
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(IntMap::SORTED, c.representation());
+  for (int i = 0; i < 10; ++i)
+    ASSERT_EQ(i, c[i]);
+}
+
+TEST(BasicWorkloadMapTests, HandedOutRefCheck)
+{
+  typedef WorkloadMap<int,int> IntMap;
+  IntMap m(10, 0.1);
+  // a window of writes picks a hash table
+  for (int i = 0; i < 10; ++i)
+    m.insert(i, i);
+  // the reference is handed out before any rebuild is in progress,
+  // then the second window, closed by const reads, starts one
+  int& v = m[3];
+  const IntMap& c = m;
+  for (int i = 0; i < 9; ++i)
+    c.contains(i);
+  // const reads must not swap while v may be in use, and the write
+  // through v must reach the rebuilt map
+  v = 33;
+  ASSERT_EQ(IntMap::TREE, c.representation());
+  m.wait_for_rebuild();
+  ASSERT_EQ(IntMap::HASH, m.representation());
+  ASSERT_EQ(33, m[3]);
+}
+
+
+//----------------------------------------------------------------------
+// Basic Tests for the linear search kernel
+//----------------------------------------------------------------------
+
+TEST(BasicSearchKernelTests, IntegralKeyCheck)
+{
+  int keys32[37];
+  long long keys64[37];
+  for (int i = 0; i < 37; ++i) {
+    keys32[i] = (i * 11) % 37 - 5;
+    keys64[i] = keys32[i] * (1LL << 33);
+  }
+  // every position, including the scalar tail after the last block
+  for (int i = 0; i < 37; ++i) {
+    ASSERT_EQ(i, linear_search(keys32, 37, keys32[i]));
+    ASSERT_EQ(i, linear_search(keys64, 37, keys64[i]));
+  }
+  ASSERT_EQ(-1, linear_search(keys32, 37, 100));
+  ASSERT_EQ(-1, linear_search(keys64, 37, 1LL));
+  ASSERT_EQ(-1, linear_search(keys32, 0, 0));
+}
+
+TEST(BasicSearchKernelTests, ScalarFallbackCheck)
+{
+  string keys[] = {"d", "b", "a", "c"};
+  ASSERT_EQ(2, linear_search(keys, 4, string("a")));
+  ASSERT_EQ(-1, linear_search(keys, 4, string("e")));
+}
+
+
+//----------------------------------------------------------------------
+// Basic Tests for the sorting network kernels
+//----------------------------------------------------------------------
+
+TEST(BasicSortNetworkTests, BlockSizeCheck)
+{
+  // every size up to the largest network, so every padding amount
+  for (int n = 0; n <= network_max; ++n) {
+    int keys32[network_max];
+    long long keys64[network_max];
+    for (int i = 0; i < n; ++i) {
+      keys32[i] = (i * 67) % n - n / 2;
+      keys64[i] = keys32[i] * (1LL << 40);
+    }
+    network_sort(keys32, n);
+    network_sort(keys64, n);
+    for (int i = 0; i < n; ++i) {
+      ASSERT_EQ(i - n / 2, keys32[i]);
+      ASSERT_EQ((i - n / 2) * (1LL << 40), keys64[i]);
+    }
+  }
+}
+
+TEST(BasicSortNetworkTests, ExtremeKeyCheck)
+{
+  // keys equal to the padding value must still come out in place
+  int keys[] = {INT_MAX, 3, INT_MIN, INT_MAX, -1, 0, INT_MIN, 7, 3, INT_MAX, 2};
+  network_sort(keys, 11);
+  int sorted[] = {INT_MIN, INT_MIN, -1, 0, 2, 3, 3, 7, INT_MAX, INT_MAX, INT_MAX};
+  for (int i = 0; i < 11; ++i)
+    ASSERT_EQ(sorted[i], keys[i]);
+  ASSERT_FALSE(SortNetwork<unsigned>::value);
+  ASSERT_FALSE(SortNetwork<short>::value);
+}
+
+
+//----------------------------------------------------------------------
+// Basic Tests for the ArraySeq growth and emplace operations
+//----------------------------------------------------------------------
+
+TEST(BasicArraySeqTests, ReserveCheck)
+{
+  ArraySeq<int> s;
+  s.reserve(100);
+  ASSERT_EQ(100, s.capacity());
+  ASSERT_EQ(0, s.size());
+  int* before = s.data();
+  for (int i = 0; i < 100; ++i)
+    s.push_back(i);
+  // no growth while within the reserved capacity
+  ASSERT_EQ(before, s.data());
+  s.push_back(100);
+  ASSERT_EQ(200, s.capacity());
+  for (int i = 0; i <= 100; ++i)
+    ASSERT_EQ(i, s[i]);
+}
+
+TEST(BasicArraySeqTests, EmplaceCheck)
+{
+  ArraySeq<string> s;
+  s.emplace_back(3, 'c');
+  s.emplace(0, "a");
+  s.push_back(string("d"));
+  s.insert(string("b"), 1);
+  ASSERT_EQ(4, s.size());
+  ASSERT_EQ("a", s[0]);
+  ASSERT_EQ("b", s[1]);
+  ASSERT_EQ("ccc", s[2]);
+  ASSERT_EQ("d", s[3]);
+  // inserting an element of the sequence into itself while growing
+  while (s.size() < s.capacity())
+    s.push_back("x");
+  s.insert(s[2], 0);
+  ASSERT_EQ("ccc", s[0]);
+  ASSERT_EQ("ccc", s[3]);
+  s.erase(0);
+  ASSERT_EQ("a", s[0]);
+  ArraySeq<string> t = s;
+  s.clear();
+  ASSERT_EQ(0, s.capacity());
+  ASSERT_EQ("d", t[3]);
+}
+
+
+TEST(BasicArraySeqTests, LargeGrowthCheck)
+{
+  // large enough to be past the mapped storage threshold
+  ArraySeq<int> s;
+  int n = 3 << 20;
+  for (int i = 0; i < n; ++i)
+    s.push_back(i);
+  ASSERT_EQ(n, s.size());
+  ASSERT_LE(n, s.capacity());
+  s.insert(-1, 0);
+  s.erase(n / 2);
+  ArraySeq<int> t = s;
+  ArraySeq<int> u = std::move(s);
+  ASSERT_EQ(0, s.size());
+  ASSERT_EQ(-1, t[0]);
+  ASSERT_EQ(n / 2, u[n / 2]);
+  ASSERT_EQ(n - 1, u[n - 1]);
+  t.clear();
+  t.push_back(7);
+  ASSERT_EQ(7, t[0]);
+}
+
+// an element this large caps the capacity at SIZE_MAX / 2^40 (about
+// 2^24) elements, so the overflow checks can run without allocating
+struct HugeElem
+{
+  char bytes[1LL << 40];
+  bool operator==(const HugeElem& rhs) const { return bytes[0] == rhs.bytes[0]; }
+  bool operator<(const HugeElem& rhs) const { return bytes[0] < rhs.bytes[0]; }
+};
+
+TEST(BasicArraySeqTests, CapacityOverflowCheck)
+{
+  ArraySeq<HugeElem> s;
+  ASSERT_THROW(s.reserve(1 << 25), std::length_error);
+  ASSERT_THROW(s.reserve(INT_MAX), std::length_error);
+  ASSERT_EQ(0, s.capacity());
+  ASSERT_EQ(0, s.size());
+}
+
+TEST(BasicArraySeqTests, RangeInsertEraseCheck)
+{
+  ArraySeq<int> s;
+  int vals[] = {10, 11, 12};
+  s.insert_range(0, vals, vals + 3);
+  s.insert_range(1, vals, vals + 3);
+  s.insert_range(s.size(), vals, vals + 1);
+  // 10 10 11 12 11 12 10
+  ASSERT_EQ(7, s.size());
+  ASSERT_EQ(10, s[1]);
+  ASSERT_EQ(12, s[3]);
+  ASSERT_EQ(10, s[6]);
+  s.erase_range(1, 4);
+  ASSERT_EQ(4, s.size());
+  ASSERT_EQ(11, s[1]);
+  s.append(s);
+  ASSERT_EQ(8, s.size());
+  ASSERT_EQ(10, s[4]);
+  ASSERT_EQ(10, s[7]);
+  s.erase_range(0, s.size());
+  ASSERT_TRUE(s.empty());
+  ASSERT_THROW(s.erase_range(0, 1), std::out_of_range);
+  ASSERT_THROW(s.insert_range(1, vals, vals + 1), std::out_of_range);
+}
+
+TEST(BasicArraySeqTests, RangeNonTrivialCheck)
+{
+  ArraySeq<string> s;
+  s.push_back("a");
+  s.push_back("e");
+  string mid[] = {"b", "c", "d"};
+  s.insert_range(1, mid, mid + 3);
+  ArraySeq<string> t;
+  t.push_back("x");
+  t.append(s);
+  ASSERT_EQ(6, t.size());
+  for (int i = 0; i < 5; ++i)
+    ASSERT_EQ(string(1, 'a' + i), t[i + 1]);
+  t.erase_range(0, 2);
+  ASSERT_EQ("b", t[0]);
+  ASSERT_EQ("e", t[3]);
+}
+
+TEST(BasicArraySeqTests, IntroSortCheck)
+{
+  // sorted, reversed, organ pipe, few distinct values, and shuffled
+  for (int pattern = 0; pattern < 5; ++pattern) {
+    for (int n = 0; n <= 5000; n = n * 3 + 1) {
+      ArraySeq<int> s;
+      long long sum = 0;
+      for (int i = 0; i < n; ++i) {
+        int val = i;
+        if (pattern == 1)
+          val = n - i;
+        else if (pattern == 2)
+          val = i < n / 2 ? i : n - i;
+        else if (pattern == 3)
+          val = (i * 7919) % 5;
+        else if (pattern == 4)
+          val = (i * 7919) % (n + 13) - n / 2;
+        s.push_back(val);
+        sum += val;
+      }
+      s.intro_sort();
+      ASSERT_EQ(n, s.size());
+      for (int i = 0; i < n - 1; ++i)
+        ASSERT_LE(s[i], s[i + 1]);
+      for (int i = 0; i < n; ++i)
+        sum -= s[i];
+      ASSERT_EQ(0, sum);
+    }
+  }
+}
+
+TEST(BasicArraySeqTests, IntroSortNonTrivialCheck)
+{
+  ArraySeq<string> s;
+  for (int i = 0; i < 1000; ++i)
+    s.push_back(to_string((i * 7919) % 1000));
+  s.sort();
+  for (int i = 0; i < s.size() - 1; ++i)
+    ASSERT_LE(s[i], s[i + 1]);
+  ArraySeq<int> t;
+  for (int i = 0; i < 1000; ++i)
+    t.push_back((i * 7919) % 1000);
+  t.quick_sort_random();
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i, t[i]);
+}
+
+// compares on key only, so stability shows up in the order values
+struct SortItem
+{
+  int key;
+  int order;
+  bool operator<(const SortItem& rhs) const { return key < rhs.key; }
+  bool operator==(const SortItem& rhs) const { return key == rhs.key; }
+};
+
+TEST(BasicArraySeqTests, MergeSortStableCheck)
+{
+  ArraySeq<SortItem> s;
+  for (int i = 0; i < 3000; ++i)
+    s.push_back({(i * 7919) % 10, i});
+  // a long sorted run and a long descending run on the end
+  for (int i = 0; i < 500; ++i)
+    s.push_back({20 + i, 3000 + i});
+  for (int i = 0; i < 500; ++i)
+    s.push_back({1000 - i, 3500 + i});
+  s.merge_sort();
+  ASSERT_EQ(4000, s.size());
+  for (int i = 0; i < s.size() - 1; ++i) {
+    ASSERT_LE(s[i].key, s[i + 1].key);
+    if (s[i].key == s[i + 1].key) {
+      ASSERT_LT(s[i].order, s[i + 1].order);
+    }
+  }
+}
+
+TEST(BasicArraySeqTests, MergeSortLargeCheck)
+{
+  // large enough that the old recursive version ran out of stack
+  ArraySeq<int> s;
+  int n = 4000000;
+  s.reserve(n);
+  for (int i = 0; i < n; ++i)
+    s.push_back((i * 7919LL) % n);
+  s.merge_sort();
+  for (int i = 0; i < n; ++i)
+    ASSERT_EQ(i, s[i]);
+}
+
+TEST(BasicArraySeqTests, RadixSortCheck)
+{
+  ArraySeq<int> s1;
+  ArraySeq<long long> s2;
+  for (int i = 0; i < 5000; ++i) {
+    s1.push_back((i * 7919) % 5000 - 2500);
+    s2.push_back(((i * 7919) % 5000 - 2500) * (1LL << 35));
+  }
+  s1.radix_sort();
+  s2.sort();
+  for (int i = 0; i < 5000; ++i) {
+    ASSERT_EQ(i - 2500, s1[i]);
+    ASSERT_EQ((i - 2500) * (1LL << 35), s2[i]);
+  }
+}
+
+TEST(BasicArraySeqTests, RadixSortPairCheck)
+{
+  ArraySeq<pair<int,string>> s;
+  for (int i = 0; i < 1000; ++i)
+    s.push_back(make_pair(-(i % 300), to_string((i * 7) % 10)));
+  s.sort();
+  for (int i = 0; i < s.size() - 1; ++i)
+    ASSERT_LE(s[i], s[i + 1]);
+  ASSERT_EQ(-299, s[0].first);
+  ASSERT_EQ(0, s[999].first);
+}
+
+TEST(BasicArraySeqTests, ParallelSortCheck)
+{
+  // thread counts that do and do not divide the size evenly
+  int n = 100003;
+  for (int threads = 1; threads <= 7; threads += 2) {
+    ArraySeq<int> s;
+    for (int i = 0; i < n; ++i)
+      s.push_back((i * 7919LL) % n - 50000);
+    s.parallel_sort(threads);
+    for (int i = 0; i < n; ++i)
+      ASSERT_EQ(i - 50000, s[i]);
+  }
+  ArraySeq<string> s;
+  for (int i = 0; i < 3000; ++i)
+    s.push_back(to_string((i * 7919) % 1000));
+  s.parallel_sort(4);
+  for (int i = 0; i < s.size() - 1; ++i)
+    ASSERT_LE(s[i], s[i + 1]);
+  ArraySeq<int> small;
+  small.push_back(2);
+  small.push_back(1);
+  small.parallel_sort(16);
+  ASSERT_EQ(1, small[0]);
+  ASSERT_EQ(2, small[1]);
+}
+
+TEST(BasicArraySeqTests, LargeSortCheck)
+{
+  // sort() stays sequential at any size, parallel_sort is the opt-in
+  ArraySeq<double> s;
+  int n = 300000;
+  for (int i = 0; i < n; ++i)
+    s.push_back((i * 7919LL) % n / 2.0);
+  ArraySeq<double> p = s;
+  s.sort();
+  p.parallel_sort(3);
+  for (int i = 0; i < n; ++i) {
+    ASSERT_EQ(i / 2.0, s[i]);
+    ASSERT_EQ(i / 2.0, p[i]);
+  }
+}
+
+TEST(BasicArraySeqTests, HashMapParallelKeysCheck)
+{
+  // large enough for sorted_keys to sort on several threads
+  typedef HashMap<int,int> IntMap;
+  IntMap m;
+  int n = IntMap::parallel_sort_min + 1001;
+  for (int i = 0; i < n; ++i)
+    m.insert((i * 7919LL) % n, i);
+  ASSERT_EQ(0, IntMap::sort_threads());
+  IntMap::set_sort_threads(3);
+  ASSERT_EQ(3, IntMap::sort_threads());
+  ArraySeq<int> keys = m.sorted_keys();
+  IntMap::set_sort_threads(0);
+  ArraySeq<int> single = m.sorted_keys(1);
+  ArraySeq<int> four = m.sorted_keys(4);
+  ASSERT_EQ(n, keys.size());
+  for (int i = 0; i < n; ++i) {
+    ASSERT_EQ(i, keys[i]);
+    ASSERT_EQ(i, single[i]);
+    ASSERT_EQ(i, four[i]);
+  }
+}
+
+TEST(BasicArraySeqTests, NthElementCheck)
+{
+  int n = 10007;
+  ArraySeq<int> s;
+  for (int i = 0; i < n; ++i)
+    s.push_back((i * 7919LL) % n);
+  for (int index : {0, 1, 5000, n - 2, n - 1}) {
+    s.nth_element(index);
+    ASSERT_EQ(index, s[index]);
+    for (int i = 0; i < index; ++i)
+      ASSERT_LT(s[i], index);
+    for (int i = index + 1; i < n; ++i)
+      ASSERT_GT(s[i], index);
+  }
+  // many duplicates, and a non-arithmetic type
+  ArraySeq<string> t;
+  for (int i = 0; i < 3000; ++i)
+    t.push_back(to_string(i % 7));
+  t.nth_element(1500);
+  ASSERT_EQ("3", t[1500]);
+  ASSERT_THROW(s.nth_element(n), std::out_of_range);
+  ASSERT_THROW(s.nth_element(-1), std::out_of_range);
+}
+
+TEST(BasicArraySeqTests, PartialSortCheck)
+{
+  int n = 5003;
+  ArraySeq<long long> s;
+  for (int i = 0; i < n; ++i)
+    s.push_back((i * 7919LL) % n - 100);
+  s.partial_sort(50);
+  for (int i = 0; i < 50; ++i)
+    ASSERT_EQ(i - 100, s[i]);
+  s.partial_sort(n);
+  for (int i = 0; i < n; ++i)
+    ASSERT_EQ(i - 100, s[i]);
+  s.partial_sort(0);
+  ASSERT_THROW(s.partial_sort(n + 1), std::out_of_range);
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for the TopK bounded heap
+//----------------------------------------------------------------------
+
+TEST(BasicTopKTests, SmallestAndLargestCheck)
+{
+  TopK<int> small(5);
+  TopK<int> large(5, true);
+  ASSERT_TRUE(small.empty());
+  for (int i = 0; i < 1000; ++i) {
+    small.push((i * 7919) % 1000);
+    large.push((i * 7919) % 1000);
+  }
+  ASSERT_TRUE(small.full());
+  ASSERT_EQ(4, small.worst());
+  ASSERT_EQ(995, large.worst());
+  ArraySeq<int> first = small.sorted();
+  ArraySeq<int> last = large.sorted();
+  ASSERT_EQ(5, first.size());
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_EQ(i, first[i]);
+    ASSERT_EQ(999 - i, last[i]);
+  }
+  TopK<int> none(0);
+  none.push(1);
+  ASSERT_TRUE(none.empty());
+  ASSERT_THROW(none.worst(), std::out_of_range);
+  ASSERT_THROW(TopK<int>(-1), std::out_of_range);
+}
+
+TEST(BasicTopKTests, HashMapFirstKeysCheck)
+{
+  HashMap<int,int> m;
+  for (int i = 0; i < 500; ++i)
+    m.insert((i * 37) % 500 * 2, i);
+  // even keys 0..998, so the first keys from 101 are 102, 104, ...
+  ArraySeq<int> keys = m.first_keys(101, 4);
+  ASSERT_EQ(4, keys.size());
+  for (int i = 0; i < 4; ++i)
+    ASSERT_EQ(102 + 2 * i, keys[i]);
+  keys = m.first_keys(995, 10);
+  ASSERT_EQ(2, keys.size());
+  ASSERT_EQ(996, keys[0]);
+  ASSERT_EQ(998, keys[1]);
+}
+
+TEST(BasicTopKTests, LargeLimitCheck)
+{
+  // k only bounds the number kept, it is not allocated up front
+  TopK<int> top(INT_MAX);
+  for (int i = 0; i < 10; ++i)
+    top.push(9 - i);
+  ASSERT_EQ(10, top.size());
+  ASSERT_EQ(false, top.full());
+  HashMap<int,int> m;
+  for (int i = 0; i < 10; ++i)
+    m.insert(i, i);
+  ArraySeq<int> keys = m.first_keys(3, INT_MAX);
+  ASSERT_EQ(7, keys.size());
+  for (int i = 0; i < 7; ++i)
+    ASSERT_EQ(3 + i, keys[i]);
+}
 
+//----------------------------------------------------------------------
+// Basic Tests for the pool node allocator
+//----------------------------------------------------------------------
+
+TEST(BasicPoolAllocTests, ReuseAndReleaseCheck)
+{
+  PoolAlloc<long long> pool;
+  ASSERT_EQ(0, pool.slab_count());
+  long long* a = pool.create();
+  long long* b = pool.create();
+  ASSERT_EQ(1, pool.slab_count());
+  pool.destroy(a);
+  // the freed slot is handed out again before any new one
+  ASSERT_EQ(a, pool.create());
+  for (int i = 0; i < 100; ++i)
+    *pool.create() = i;
+  ASSERT_EQ(3, pool.slab_count());
+  PoolAlloc<long long> other(std::move(pool));
+  ASSERT_EQ(0, pool.slab_count());
+  ASSERT_EQ(3, other.slab_count());
+  other.release();
+  ASSERT_EQ(0, other.slab_count());
+  (void) b;
+}
+
+template<typename M>
+void pool_map_check()
+{
+  M m;
+  for (int i = 0; i < 1000; ++i)
+    m.insert((i * 7919) % 1000, i);
+  for (int i = 0; i < 1000; i += 2)
+    m.erase(i);
+  ASSERT_EQ(500, m.size());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i % 2 == 1, m.contains(i));
+  M copy(m);
+  M moved(std::move(m));
+  ASSERT_EQ(0, m.size());
+  ASSERT_EQ(500, copy.size());
+  ASSERT_EQ(500, moved.size());
+  moved.clear();
+  ASSERT_TRUE(moved.empty());
+  // a cleared map is still usable
+  moved.insert(5, 50);
+  ASSERT_EQ(50, moved[5]);
+  ASSERT_EQ(copy.sorted_keys().size(), 500);
+  m = std::move(copy);
+  ASSERT_EQ(999, m.sorted_keys()[499]);
+}
+
+TEST(BasicPoolAllocTests, PoolMapsCheck)
+{
+  pool_map_check<AVLMap<int,int,PoolAlloc>>();
+  pool_map_check<BSTMap<int,int,PoolAlloc>>();
+  pool_map_check<HashMap<int,int,PoolAlloc>>();
+  // keys with destructors take the one node at a time clear
+  AVLMap<string,string,PoolAlloc> m;
+  for (int i = 0; i < 100; ++i)
+    m.insert(to_string(i), string(40, 'a' + i % 26));
+  m.erase("7");
+  ASSERT_EQ(99, m.size());
+  m.clear();
+  ASSERT_TRUE(m.empty());
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for the CompactAVLMap implementation of Map
+//----------------------------------------------------------------------
+
+TEST(BasicCompactAVLMapTests, InsertEraseCheck)
+{
+  CompactAVLMap<int,int> m;
+  ASSERT_EQ(16, (CompactAVLMap<int,int>::node_size()));
+  // in order inserts still give a perfectly balanced tree
+  for (int i = 1; i <= 1023; ++i)
+    m.insert(i, i * 10);
+  ASSERT_EQ(1023, m.size());
+  ASSERT_EQ(10, m.height());
+  for (int i = 2; i <= 1023; i += 2)
+    m.erase(i);
+  ASSERT_EQ(512, m.size());
+  ASSERT_LE(m.height(), 10);
+  for (int i = 1; i <= 1023; ++i)
+    ASSERT_EQ(i % 2 == 1, m.contains(i));
+  ASSERT_EQ(70, m[7]);
+  m[7] = 71;
+  ASSERT_EQ(71, m[7]);
+  ASSERT_THROW(m[8], std::out_of_range);
+  ASSERT_THROW(m.erase(8), std::out_of_range);
+  int k = 0;
+  ASSERT_TRUE(m.next_key(7, k));
+  ASSERT_EQ(9, k);
+  ASSERT_TRUE(m.prev_key(7, k));
+  ASSERT_EQ(5, k);
+  ASSERT_FALSE(m.prev_key(1, k));
+  ArraySeq<int> keys = m.find_keys(10, 20);
+  ASSERT_EQ(5, keys.size());
+  ASSERT_EQ(11, keys[0]);
+  ASSERT_EQ(19, keys[4]);
+  keys = m.sorted_keys();
+  for (int i = 0; i < keys.size(); ++i)
+    ASSERT_EQ(2 * i + 1, keys[i]);
+}
+
+TEST(BasicCompactAVLMapTests, RandomEraseCheck)
+{
+  // erasing moves the last node into the freed slot, so erase in an
+  // order unrelated to the insert order
+  CompactAVLMap<int,int> m;
+  for (int i = 0; i < 1000; ++i)
+    m.insert((i * 7919) % 1000, i);
+  for (int i = 0; i < 1000; ++i) {
+    int key = (i * 389) % 1000;
+    m.erase(key);
+    ASSERT_FALSE(m.contains(key));
+    ASSERT_EQ(999 - i, m.size());
+    if (i % 100 == 0) {
+      ASSERT_EQ(999 - i, m.sorted_keys().size());
+    }
+  }
+  ASSERT_TRUE(m.empty());
+  ASSERT_EQ(0, m.height());
+}
+
+TEST(BasicCompactAVLMapTests, CopyAndMoveCheck)
+{
+  CompactAVLMap<string,string> m;
+  for (int i = 0; i < 100; ++i)
+    m.insert(to_string(i), string(40, 'a' + i % 26));
+  m.erase("7");
+  CompactAVLMap<string,string> copy(m);
+  CompactAVLMap<string,string> moved(std::move(m));
+  ASSERT_EQ(0, m.size());
+  ASSERT_EQ(99, copy.size());
+  ASSERT_EQ(99, moved.size());
+  ASSERT_EQ(string(40, 'a' + 8), copy["8"]);
+  copy.clear();
+  ASSERT_TRUE(copy.empty());
+  copy = moved;
+  ASSERT_FALSE(copy.contains("7"));
+  ASSERT_EQ(string(40, 'a' + 99 % 26), copy["99"]);
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for the single lookup Map operations
+//----------------------------------------------------------------------
+
+template<typename M>
+void single_lookup_check()
+{
+  M m;
+  Map<int,int>& map = m;
+  for (int i = 0; i < 500; ++i)
+    ASSERT_TRUE(map.try_emplace((i * 7919) % 500, i));
+  ASSERT_EQ(500, map.size());
+  // existing keys are left alone by try_emplace and set by
+  // insert_or_assign
+  ASSERT_FALSE(map.try_emplace(10, -1));
+  ASSERT_NE(-1, map[10]);
+  ASSERT_FALSE(map.insert_or_assign(10, -1));
+  ASSERT_EQ(-1, map[10]);
+  ASSERT_TRUE(map.insert_or_assign(600, 6));
+  ASSERT_EQ(501, map.size());
+  // find returns a pointer into the map, or nullptr
+  ASSERT_EQ(nullptr, map.find(1000));
+  *map.find(600) = 60;
+  const Map<int,int>& cmap = map;
+  ASSERT_EQ(60, *cmap.find(600));
+  ASSERT_EQ(nullptr, cmap.find(-5));
+  for (int i = 0; i < 500; i += 2)
+    ASSERT_TRUE(map.try_erase(i));
+  ASSERT_FALSE(map.try_erase(0));
+  ASSERT_FALSE(map.try_erase(1000));
+  ASSERT_EQ(251, map.size());
+  for (int i = 0; i < 500; ++i)
+    ASSERT_EQ(i % 2 == 1, map.find(i) != nullptr);
+  // erased keys can be added back
+  for (int i = 0; i < 500; i += 4)
+    ASSERT_TRUE(map.insert_or_assign(i, i));
+  ASSERT_EQ(376, map.size());
+  ASSERT_EQ(376, map.sorted_keys().size());
+  ASSERT_EQ(8, map[8]);
+  ASSERT_FALSE(map.contains(2));
+}
+
+TEST(BasicSingleLookupTests, AllMapsCheck)
+{
+  single_lookup_check<ArrayMap<int,int>>();
+  single_lookup_check<BinSearchMap<int,int>>();
+  single_lookup_check<AVLMap<int,int>>();
+  single_lookup_check<BSTMap<int,int>>();
+  single_lookup_check<HashMap<int,int>>();
+  single_lookup_check<PMAMap<int,int>>();
+  single_lookup_check<AdaptiveMap<int,int>>();
+  single_lookup_check<WorkloadMap<int,int>>();
+  single_lookup_check<CompactAVLMap<int,int>>();
+}
+
+TEST(BasicSingleLookupTests, TombstoneReviveCheck)
+{
+  BinSearchMap<int,int> m;
+  for (int i = 0; i < 1000; ++i)
+    m.insert(i, i);
+  m.erase(500);
+  ASSERT_EQ(nullptr, m.find(500));
+  // the erased slot is reused rather than buffering a new pair
+  ASSERT_TRUE(m.try_emplace(500, 5));
+  ASSERT_EQ(5, m[500]);
+  ASSERT_EQ(1000, m.size());
+  ArraySeq<int> keys = m.sorted_keys();
+  ASSERT_EQ(1000, keys.size());
+  for (int i = 0; i < 1000; ++i)
+    ASSERT_EQ(i, keys[i]);
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for rvalue and emplace insertion into Maps
+//----------------------------------------------------------------------
+
+// value type that counts its copies
+struct CopyCount
+{
+  static int copies;
+  int id = 0;
+  CopyCount() {}
+  CopyCount(int id) : id(id) {}
+  CopyCount(const CopyCount& rhs) : id(rhs.id) { ++copies; }
+  CopyCount(CopyCount&& rhs) noexcept : id(rhs.id) {}
+  CopyCount& operator=(const CopyCount& rhs) { id = rhs.id; ++copies; return *this; }
+  CopyCount& operator=(CopyCount&& rhs) noexcept { id = rhs.id; return *this; }
+  bool operator==(const CopyCount& rhs) const { return id == rhs.id; }
+  bool operator<(const CopyCount& rhs) const { return id < rhs.id; }
+};
+
+int CopyCount::copies = 0;
+
+template<typename M>
+void move_insert_check()
+{
+  CopyCount::copies = 0;
+  M m;
+  for (int i = 0; i < 300; ++i)
+    m.insert((i * 7919) % 300, CopyCount((i * 7919) % 300));
+  for (int i = 300; i < 600; ++i)
+    m.emplace(i, i);
+  // through the interface the pair is built and then moved in
+  Map<int,CopyCount>& map = m;
+  for (int i = 600; i < 700; ++i)
+    map.emplace(i, i);
+  ASSERT_EQ(0, CopyCount::copies);
+  ASSERT_EQ(700, m.size());
+  for (int i = 0; i < 700; ++i)
+    ASSERT_EQ(i, m[i].id);
+  // an lvalue value is still copied, once
+  CopyCount value(700);
+  m.insert(700, value);
+  ASSERT_EQ(1, CopyCount::copies);
+  ASSERT_EQ(700, m[700].id);
+}
+
+TEST(BasicMoveInsertTests, NoCopiesCheck)
+{
+  move_insert_check<ArrayMap<int,CopyCount>>();
+  move_insert_check<BinSearchMap<int,CopyCount>>();
+  move_insert_check<BinSearchMap<int,CopyCount,GapSeq>>();
+  move_insert_check<AVLMap<int,CopyCount>>();
+  move_insert_check<AVLMap<int,CopyCount,PoolAlloc>>();
+  move_insert_check<BSTMap<int,CopyCount>>();
+  move_insert_check<HashMap<int,CopyCount>>();
+  move_insert_check<PMAMap<int,CopyCount>>();
+  move_insert_check<AdaptiveMap<int,CopyCount>>();
+  move_insert_check<WorkloadMap<int,CopyCount>>();
+  move_insert_check<CompactAVLMap<int,CopyCount>>();
+}
+
+TEST(BasicMoveInsertTests, StringKeyCheck)
+{
+  AVLMap<string,string> m;
+  string key(40, 'k');
+  string value(100, 'v');
+  m.insert(std::move(key), std::move(value));
+  // the key is built from a const char* and the value from (n, c)
+  m.emplace("abc", 3, 'x');
+  ASSERT_EQ(string(100, 'v'), m[string(40, 'k')]);
+  ASSERT_EQ("xxx", m["abc"]);
+  HashMap<string,string> h;
+  h.emplace("abc", 3, 'x');
+  ASSERT_EQ("xxx", h["abc"]);
+  CompactAVLMap<string,string> c;
+  c.emplace(string("abc"), "xyz");
+  ASSERT_EQ("xyz", c["abc"]);
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for three-way key comparison
+//----------------------------------------------------------------------
+
+TEST(BasicCompareTests, ThreeWayCheck)
+{
+  ThreeWayCompare comp;
+  ASSERT_GT(0, comp(1, 2));
+  ASSERT_EQ(0, comp(2, 2));
+  ASSERT_LT(0, comp(3, 2));
+  ASSERT_GT(0, comp(string("ab"), string("abc")));
+  ASSERT_EQ(0, comp(string("abc"), string("abc")));
+  ASSERT_LT(0, comp(string("b"), string("abc")));
+  LessCompare<std::greater<int>> rev;
+  ASSERT_LT(0, rev(1, 2));
+  ASSERT_EQ(0, rev(2, 2));
+  ASSERT_GT(0, rev(3, 2));
+}
+
+// a map over keys 0..99 in descending order
+template<typename M>
+void reverse_order_check()
+{
+  M m;
+  for (int i = 0; i < 100; ++i)
+    m.insert((i * 37) % 100, i);
+  ASSERT_EQ(100, m.size());
+  ArraySeq<int> keys = m.sorted_keys();
+  ASSERT_EQ(100, keys.size());
+  for (int i = 0; i < 100; ++i)
+    ASSERT_EQ(99 - i, keys[i]);
+  int k = 0;
+  ASSERT_EQ(true, m.next_key(50, k));
+  ASSERT_EQ(49, k);
+  ASSERT_EQ(true, m.prev_key(50, k));
+  ASSERT_EQ(51, k);
+  ASSERT_EQ(false, m.next_key(0, k));
+  ASSERT_EQ(false, m.prev_key(99, k));
+  // the range bounds are in the map's order, so k1 is the larger int
+  keys = m.find_keys(60, 55);
+  ASSERT_EQ(6, keys.size());
+  for (int i = 0; i < 6; ++i)
+    ASSERT_EQ(60 - i, keys[i]);
+  ASSERT_EQ(0, m.find_keys(55, 60).size());
+  m.erase(50);
+  ASSERT_EQ(false, m.contains(50));
+  ASSERT_EQ(true, m.next_key(51, k));
+  ASSERT_EQ(49, k);
+}
+
+TEST(BasicCompareTests, ReverseOrderCheck)
+{
+  using Rev = LessCompare<std::greater<int>>;
+  reverse_order_check<AVLMap<int,int,HeapAlloc,Rev>>();
+  reverse_order_check<AVLMap<int,int,PoolAlloc,Rev>>();
+  reverse_order_check<BSTMap<int,int,HeapAlloc,Rev>>();
+  reverse_order_check<BinSearchMap<int,int,ArraySeq,Rev>>();
+  reverse_order_check<BinSearchMap<int,int,GapSeq,Rev>>();
+  reverse_order_check<CompactAVLMap<int,int,Rev>>();
+}
+
+// string keys, where one compare() per level replaces == then <
+template<typename M>
+void string_key_check()
+{
+  M m;
+  for (int i = 0; i < 200; ++i)
+    m.insert("key" + to_string((i * 71) % 200), i);
+  ASSERT_EQ(200, m.size());
+  ArraySeq<string> keys = m.sorted_keys();
+  for (int i = 1; i < 200; ++i)
+    ASSERT_LT(keys[i - 1], keys[i]);
+  ASSERT_EQ(true, m.contains("key199"));
+  ASSERT_EQ(false, m.contains("key"));
+  ASSERT_EQ(false, m.contains("key1999"));
+  string k;
+  ASSERT_EQ(true, m.next_key("key1", k));
+  ASSERT_EQ("key10", k);
+  ASSERT_EQ(true, m.prev_key("key10", k));
+  ASSERT_EQ("key1", k);
+  // key1, key10..key19, key100..key199
+  ASSERT_EQ(111, m.find_keys("key1", "key199").size());
+}
+
+TEST(BasicCompareTests, StringKeyCheck)
+{
+  string_key_check<AVLMap<string,int>>();
+  string_key_check<BSTMap<string,int>>();
+  string_key_check<BinSearchMap<string,int>>();
+  string_key_check<CompactAVLMap<string,int>>();
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for transparent (heterogeneous) key lookup
+//----------------------------------------------------------------------
+
+template<typename M>
+void transparent_lookup_check()
+{
+  M m;
+  for (int i = 0; i < 100; ++i)
+    m.insert("key" + to_string(i), i);
+  // a slice of a larger buffer, as a lookup would see it
+  string buffer = "GET key42 key7 HTTP";
+  string_view k42 = string_view(buffer).substr(4, 5);
+  string_view k7 = string_view(buffer).substr(10, 4);
+  ASSERT_EQ(true, m.contains(k42));
+  ASSERT_EQ(true, m.contains(k7));
+  ASSERT_EQ(false, m.contains(string_view(buffer).substr(4, 3)));
+  ASSERT_EQ(42, m[k42]);
+  ASSERT_EQ(7, *m.find(k7));
+  ASSERT_EQ(nullptr, m.find(string_view("key100")));
+  ASSERT_THROW(m[string_view("key")], std::out_of_range);
+  // const char* and string literals
+  const char* k3 = "key3";
+  ASSERT_EQ(true, m.contains(k3));
+  ASSERT_EQ(99, m["key99"]);
+  ASSERT_EQ(false, m.contains("nokey"));
+  m["key5"] = 500;
+  const M& cm = m;
+  ASSERT_EQ(500, cm[string_view("key5")]);
+  ASSERT_EQ(500, *cm.find("key5"));
+  ASSERT_EQ(nullptr, cm.find("key"));
+  ASSERT_THROW(cm["nokey"], std::out_of_range);
+}
+
+TEST(BasicTransparentLookupTests, StringViewCheck)
+{
+  transparent_lookup_check<AVLMap<string,int>>();
+  transparent_lookup_check<AVLMap<string,int,PoolAlloc>>();
+  transparent_lookup_check<BSTMap<string,int>>();
+  transparent_lookup_check<BinSearchMap<string,int>>();
+  transparent_lookup_check<BinSearchMap<string,int,GapSeq>>();
+  transparent_lookup_check<CompactAVLMap<string,int>>();
+  transparent_lookup_check<HashMap<string,int>>();
+}
+
+TEST(BasicTransparentLookupTests, OnlyWhenTransparentCheck)
+{
+  // a string_view is compared, not converted, for string keys
+  ASSERT_EQ(true, (is_transparent_lookup<ThreeWayCompare, string, string_view>::value));
+  ASSERT_EQ(true, (is_transparent_lookup<KeyHash<string>, string, const char*>::value));
+  // arithmetic keys convert as before, so a double finds its int key
+  ASSERT_EQ(false, (is_transparent_lookup<ThreeWayCompare, int, double>::value));
+  ASSERT_EQ(false, (is_transparent_lookup<KeyHash<int>, int, long>::value));
+  // comparators without is_transparent only take a K
+  ASSERT_EQ(false, (is_transparent_lookup<LessCompare<std::less<string>>, string, string_view>::value));
+  AVLMap<int,int> m;
+  m.insert(2, 20);
+  ASSERT_EQ(true, m.contains(2.5));
+  ASSERT_EQ(20, m[2L]);
+}
+
+TEST(BasicTransparentLookupTests, UnorderableKeyLikeCheck)
+{
+  typedef std::pair<int,int> IntPair;
+  typedef std::pair<long,long> LongPair;
+  // ThreeWayCompare cannot order the pairs against each other, so the
+  // lookup converts to the key type instead
+  ASSERT_EQ(false, (is_three_way_comparable<LongPair, IntPair>::value));
+  ASSERT_EQ(false, (is_transparent_lookup<ThreeWayCompare, IntPair, LongPair>::value));
+  AVLMap<IntPair,int> a;
+  BSTMap<IntPair,int> b;
+  BinSearchMap<IntPair,int> s;
+  CompactAVLMap<IntPair,int> c;
+  a.insert(IntPair(1, 2), 12);
+  b.insert(IntPair(1, 2), 12);
+  s.insert(IntPair(1, 2), 12);
+  c.insert(IntPair(1, 2), 12);
+  ASSERT_EQ(true, a.contains(std::make_pair(1L, 2L)));
+  ASSERT_EQ(true, b.contains(std::make_pair(1L, 2L)));
+  ASSERT_EQ(true, s.contains(std::make_pair(1L, 2L)));
+  ASSERT_EQ(true, c.contains(std::make_pair(1L, 2L)));
+  ASSERT_EQ(false, a.contains(std::make_pair(2L, 1L)));
+  ASSERT_EQ(12, a[std::make_pair(1L, 2L)]);
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for the static map interface
+//----------------------------------------------------------------------
+
+TEST(BasicStaticMapTests, InterfaceCheck)
+{
+  ASSERT_EQ(true, (is_static_map<ArrayMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<BinSearchMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<HashMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<BSTMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<AVLMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<CompactAVLMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<PMAMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<AdaptiveMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<WorkloadMap<int,int>,int,int>::value));
+  ASSERT_EQ(true, (is_static_map<AVLMap<string,int>,string,int>::value));
+  // the abstract Map has the same operations, dispatched virtually
+  ASSERT_EQ(true, (is_static_map<Map<int,int>,int,int>::value));
+  ASSERT_EQ(false, (is_static_map<ArraySeq<int>,int,int>::value));
+  ASSERT_EQ(false, (is_static_map<AVLMap<int,int>,int,string>::value));
+  // final, so calls through the concrete type need no vtable
+  ASSERT_EQ(true, (std::is_final_v<AVLMap<int,int>>));
+  ASSERT_EQ(true, (std::is_final_v<HashMap<int,int>>));
+  ASSERT_EQ(true, (std::is_final_v<BinSearchMap<int,int>>));
+}
+
+template<typename M>
+void batch_helpers_check()
+{
+  ArraySeq<int> keys;
+  for (int i = 0; i < 200; ++i)
+    keys.push_back((i * 37) % 200);
+  ArraySeq<int> vals;
+  for (int i = 0; i < 200; ++i)
+    vals.push_back(2 * keys[i]);
+  M m;
+  insert_all(m, keys.data(), vals.data(), 100);
+  ASSERT_EQ(100, m.size());
+  // the same helpers through the Map interface
+  Map<int,int>& dynamic = m;
+  ASSERT_EQ(100, count_contained(m, keys.data(), 200));
+  ASSERT_EQ(100, count_contained(dynamic, keys.data(), 200));
+  long long total = 0;
+  ASSERT_EQ(100, sum_found(m, keys.data(), 200, total));
+  int dynamic_total = 0;
+  ASSERT_EQ(100, sum_found(dynamic, keys.data(), 200, dynamic_total));
+  long long expected = 0;
+  for (int i = 0; i < 100; ++i)
+    expected += vals[i];
+  ASSERT_EQ(expected, total);
+  ASSERT_EQ(expected, dynamic_total);
+  ASSERT_EQ(50, erase_all(m, keys.data(), 50));
+  ASSERT_EQ(50, erase_all(dynamic, keys.data(), 100));
+  ASSERT_EQ(0, m.size());
+  ASSERT_EQ(0, count_contained(m, keys.data(), 200));
+}
+
+TEST(BasicStaticMapTests, BatchHelpersCheck)
+{
+  batch_helpers_check<ArrayMap<int,int>>();
+  batch_helpers_check<BinSearchMap<int,int>>();
+  batch_helpers_check<HashMap<int,int>>();
+  batch_helpers_check<BSTMap<int,int>>();
+  batch_helpers_check<AVLMap<int,int>>();
+  batch_helpers_check<CompactAVLMap<int,int>>();
+  batch_helpers_check<PMAMap<int,int>>();
+  batch_helpers_check<AdaptiveMap<int,int>>();
+  batch_helpers_check<WorkloadMap<int,int>>();
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for the SmallSeq implementation of Sequence
+//----------------------------------------------------------------------
+
+TEST(BasicSmallSeqTests, InlineAndSpillCheck)
+{
+  SmallSeq<int, 4> s;
+  for (int i = 0; i < 4; ++i)
+    s.insert(i, 0);
+  ASSERT_FALSE(s.spilled());
+  ASSERT_EQ(4, s.capacity());
+  s.push_back(10);
+  ASSERT_TRUE(s.spilled());
+  ASSERT_EQ(8, s.capacity());
+  // 3, 2, 1, 0, 10
+  ASSERT_EQ(3, s[0]);
+  ASSERT_EQ(10, s[4]);
+  s.erase(1);
+  s.sort();
+  ASSERT_EQ(4, s.size());
+  ASSERT_EQ(0, s[0]);
+  ASSERT_EQ(1, s[1]);
+  ASSERT_EQ(3, s[2]);
+  ASSERT_EQ(10, s[3]);
+  ASSERT_TRUE(s.contains(10));
+  ASSERT_FALSE(s.contains(2));
+  ASSERT_THROW(s[4], std::out_of_range);
+  s.clear();
+  ASSERT_FALSE(s.spilled());
+  ASSERT_TRUE(s.empty());
+}
+
+TEST(BasicSmallSeqTests, CopyAndMoveCheck)
+{
+  SmallSeq<string, 2> s1;
+  s1.push_back("b");
+  s1.push_back("a");
+  SmallSeq<string, 2> s2 = s1;
+  SmallSeq<string, 2> s3 = std::move(s1);
+  ASSERT_EQ(0, s1.size());
+  ASSERT_EQ("a", s2[1]);
+  ASSERT_EQ("a", s3[1]);
+  s3.push_back("c");
+  SmallSeq<string, 2> s4;
+  s4 = std::move(s3);
+  ASSERT_TRUE(s4.spilled());
+  ASSERT_EQ("c", s4[2]);
+  s2 = s4;
+  ASSERT_EQ(3, s2.size());
+  ASSERT_EQ("b", s2[0]);
+}
+
+TEST(BasicSmallSeqTests, EmplaceBackCheck)
+{
+  SmallSeq<string, 2> s;
+  s.emplace_back(3, 'a');
+  s.push_back(string("b"));
+  ASSERT_FALSE(s.spilled());
+  // the copy is made before the sequence spills
+  s.emplace_back(s[0]);
+  ASSERT_TRUE(s.spilled());
+  ASSERT_EQ(3, s.size());
+  ASSERT_EQ("aaa", s.data()[0]);
+  ASSERT_EQ("b", s.data()[1]);
+  ASSERT_EQ("aaa", s.data()[2]);
+}
+
+template<typename T>
+using SmallSeq8 = SmallSeq<T, 8>;
+
+TEST(BasicSmallSeqTests, ArrayMapCheck)
+{
+  // spills past 8 pairs
+  ArrayMap<int, string, SmallSeq8> m;
+  for (int i = 0; i < 20; ++i)
+    m.insert(19 - i, std::to_string(i));
+  ASSERT_EQ(20, m.size());
+  ASSERT_EQ("0", m[19]);
+  m.erase(19);
+  ASSERT_EQ(false, m.contains(19));
+  ArraySeq<int> k = m.sorted_keys();
+  ASSERT_EQ(19, k.size());
+  for (int i = 0; i < 19; ++i)
+    ASSERT_EQ(i, k[i]);
+}
+
+TEST(BasicSmallSeqTests, FindKeysCheck)
+{
+  AVLMap<int,int> m1;
+  BinSearchMap<int,int> m2;
+  PMAMap<int,int> m3;
+  for (int i = 0; i < 100; ++i) {
+    m1.insert(i, i);
+    m2.insert(i, i);
+    m3.insert(i, i);
+  }
+  SmallSeq<int> k1, k2, k3;
+  m1.find_keys(10, 19, k1);
+  m2.find_keys(10, 19, k2);
+  m3.find_keys(10, 19, k3);
+  ASSERT_FALSE(k1.spilled());
+  ASSERT_EQ(10, k1.size());
+  ASSERT_EQ(10, k2.size());
+  ASSERT_EQ(10, k3.size());
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(10 + i, k1[i]);
+    ASSERT_EQ(10 + i, k2[i]);
+    ASSERT_EQ(10 + i, k3[i]);
+  }
+  // appends to what is already in the sequence
+  m1.find_keys(50, 50, k1);
+  ASSERT_EQ(11, k1.size());
+  ASSERT_EQ(50, k1[10]);
+}
+
+//----------------------------------------------------------------------
+// Basic Tests for the GapSeq implementation of Sequence
+//----------------------------------------------------------------------
+
+TEST(BasicGapSeqTests, InsertEraseCheck)
+{
+  GapSeq<int> s;
+  for (int i = 0; i < 10; ++i)
+    s.push_back(i);
+  // edits on both sides of the gap
+  s.insert(100, 5);
+  s.insert(101, 2);
+  s.erase(8);
+  s.insert(102, 0);
+  // 102 0 1 101 2 3 4 100 5 7 8 9
+  ASSERT_EQ(12, s.size());
+  int expected[] = {102, 0, 1, 101, 2, 3, 4, 100, 5, 7, 8, 9};
+  for (int i = 0; i < 12; ++i)
+    ASSERT_EQ(expected[i], s[i]);
+  s.erase_range(3, 8);
+  ASSERT_EQ(7, s.size());
+  ASSERT_EQ(1, s[2]);
+  ASSERT_EQ(5, s[3]);
+  s.insert_range(1, expected, expected + 3);
+  ASSERT_EQ(10, s.size());
+  ASSERT_EQ(102, s[1]);
+  ASSERT_EQ(1, s[3]);
+  ASSERT_EQ(0, s[4]);
+  s.sort();
+  for (int i = 0; i < s.size() - 1; ++i)
+    ASSERT_LE(s[i], s[i + 1]);
+  ASSERT_THROW(s[10], std::out_of_range);
+  ASSERT_THROW(s.erase(10), std::out_of_range);
+}
+
+TEST(BasicGapSeqTests, NonTrivialCheck)
+{
+  GapSeq<string> s1;
+  for (int i = 0; i < 20; ++i)
+    s1.insert(string(1, 'a' + i), i / 2);
+  GapSeq<string> s2 = s1;
+  s1.erase(3);
+  s1.insert(s1[0], 10);
+  GapSeq<string> s3 = std::move(s1);
+  ASSERT_EQ(0, s1.size());
+  ASSERT_EQ(20, s3.size());
+  ASSERT_EQ(s3[0], s3[10]);
+  ASSERT_EQ(20, s2.size());
+  ASSERT_EQ(s2[4], s3[3]);
+  s2.sort();
+  ASSERT_EQ("a", s2[0]);
+  ASSERT_EQ("t", s2[19]);
+}
+
+TEST(BasicGapSeqTests, BinSearchMapCheck)
+{
+  BinSearchMap<int, int, GapSeq> m;
+  for (int i = 0; i < 500; ++i)
+    m.insert((i * 37) % 500, i);
+  for (int i = 0; i < 500; i += 3)
+    m.erase(i);
+  ASSERT_EQ(333, m.size());
+  ArraySeq<int> keys = m.sorted_keys();
+  ASSERT_EQ(333, keys.size());
+  for (int i = 0; i < keys.size() - 1; ++i)
+    ASSERT_LT(keys[i], keys[i + 1]);
+  ASSERT_TRUE(m.contains(1));
+  ASSERT_FALSE(m.contains(3));
+  ASSERT_EQ(1, m[37]);
+  m.merge();
+  ArraySeq<int> range = m.find_keys(10, 20);
+  ASSERT_EQ(8, range.size());
+  ASSERT_EQ(10, range[0]);
+}
+
+TEST(BasicGapSeqTests, FullStringBufferCheck)
+{
+  // 64 pushes from empty fill the array exactly, leaving no gap
+  GapSeq<string> s;
+  for (int i = 0; i < 64; ++i)
+    s.push_back("str" + to_string(i));
+  s.erase(0);
+  ASSERT_EQ(63, s.size());
+  for (int i = 0; i < 63; ++i)
+    ASSERT_EQ("str" + to_string(i + 1), s[i]);
+  s.push_back("str64");
+  string* none = nullptr;
+  s.insert_range(10, none, none);
+  ASSERT_EQ(64, s.size());
+  for (int i = 0; i < 64; ++i)
+    ASSERT_EQ("str" + to_string(i + 1), s[i]);
+  s.erase_range(0, 0);
+  s.data();
+  s.erase(63);
+  s.push_back("last");
+  s.erase(32);
+  ASSERT_EQ(63, s.size());
+  ASSERT_EQ("str32", s[31]);
+  ASSERT_EQ("str34", s[32]);
+  ASSERT_EQ("last", s[62]);
+}
+
+TEST(BasicGapSeqTests, BinSearchMapStringCheck)
+{
+  BinSearchMap<string, int, GapSeq> m;
+  std::map<string, int> expected;
+  srand(7);
+  for (int op = 0; op < 5000; ++op) {
+    string key = "k" + to_string(rand() % 300);
+    if (rand() % 3 == 0) {
+      ASSERT_EQ(expected.erase(key) == 1, m.try_erase(key));
+    } else if (!expected.count(key)) {
+      expected[key] = op;
+      m.insert(key, op);
+    }
+    if (op % 250 == 0) {
+      const BinSearchMap<string, int, GapSeq>& cm = m;
+      ArraySeq<string> keys = cm.sorted_keys();
+      ASSERT_EQ((int) expected.size(), keys.size());
+      int i = 0;
+      for (auto& kv : expected) {
+        ASSERT_EQ(kv.first, keys[i++]);
+        ASSERT_EQ(kv.second, cm[kv.first]);
+      }
+      ArraySeq<string> range = cm.find_keys("k1", "k2");
+      ASSERT_EQ((int) std::distance(expected.lower_bound("k1"), expected.upper_bound("k2")),
+                range.size());
+    }
+  }
+}
 
 //----------------------------------------------------------------------
 // Main
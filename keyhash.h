@@ -0,0 +1,43 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: keyhash.h
+// DATE: Spring 2022
+// DESC: Default key hash for HashMap. It is std::hash<K>, except for
+//       std::string keys, where it hashes a std::string_view and is
+//       transparent, so a lookup by string_view or const char* does
+//       not build a temporary std::string. std::hash gives a string
+//       and a string_view of the same characters the same hash, so
+//       lookups and stored keys land in the same chain.
+//---------------------------------------------------------------------------
+
+#ifndef KEYHASH_H
+#define KEYHASH_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+
+template<typename K>
+struct KeyHash
+{
+  std::size_t operator()(const K& key) const
+  {
+    return std::hash<K>()(key);
+  }
+};
+
+
+template<>
+struct KeyHash<std::string>
+{
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view key) const
+  {
+    return std::hash<std::string_view>()(key);
+  }
+};
+
+#endif
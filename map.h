@@ -45,6 +45,22 @@ public:
   // Expects key to not exist in map prior to insertion.
   virtual void insert(const K& key, const V& value) = 0;
 
+  // Extends the collection by moving the given key-value pair into
+  // it, so neither is copied. Expects key to not exist in map prior
+  // to insertion.
+  virtual void insert(K&& key, V&& value) = 0;
+
+  // Extends the collection with a key made from key and a value made
+  // from args. Expects key to not exist in map prior to insertion.
+  // Through the Map interface the pair is built and then moved in;
+  // each concrete map hides this with a version that builds the pair
+  // in place.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args)
+  {
+    insert(K(std::forward<KeyArg>(key)), V(std::forward<Args>(args)...));
+  }
+
   // Shrinks the collection by removing the key-value pair with the
   // given key. Does not modify the collection if the collection does
   // not contain the key. Throws out_of_range if the given key is not
@@ -54,9 +70,39 @@ public:
   // Returns true if the key is in the collection, and false otherwise.
   virtual bool contains(const K& key) const = 0;
 
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection. Unlike operator[], a missing
+  // key does not throw. The pointer is only valid until the
+  // collection is next modified.
+  virtual V* find(const K& key) = 0;
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection.
+  virtual const V* find(const K& key) const = 0;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added, and false if an existing value was replaced.
+  virtual bool insert_or_assign(const K& key, const V& value) = 0;
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added, and false if the
+  // key was already present (its value is left unchanged).
+  virtual bool try_emplace(const K& key, const V& value) = 0;
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed, and false (without
+  // throwing) if the key was not in the collection.
+  virtual bool try_erase(const K& key) = 0;
+
   // Returns the keys k in the collection such that k1 <= k <= k2
   virtual ArraySeq<K> find_keys(const K& k1, const K& k2) const = 0;
 
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence. Lets the caller choose the result
+  // type, e.g. a SmallSeq so small ranges do not allocate.
+  virtual void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const = 0;
+
   // Returns the keys in the collection in ascending sorted order
   virtual ArraySeq<K> sorted_keys() const = 0;  
 
@@ -0,0 +1,939 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: micro_perf.cpp
+// DATE: Spring 2022
+// DESC: Micro-benchmark driver for individual map and sequence
+//       operations that are too small or too specific for
+//       hw9_perf. Each benchmark is selected by name, e.g.:
+//          ./micro_perf search
+//       and prints its timing data in the same column format as
+//       hw9_perf so it can be plotted with gnuplot.
+//---------------------------------------------------------------------------
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#endif
+#include "util.h"
+#include "arrayseq.h"
+#include "arraymap.h"
+#include "binsearchmap.h"
+#include "adaptivemap.h"
+#include "smallseq.h"
+#include "gapseq.h"
+#include "topk.h"
+#include "hashmap.h"
+#include "avlmap.h"
+#include "bstmap.h"
+#include "poolalloc.h"
+#include "compactavlmap.h"
+#include "staticmap.h"
+
+using namespace std;
+using namespace std::chrono;
+
+void search_perf();
+void adaptive_perf();
+void growth_perf();
+void range_perf();
+void gap_perf();
+void sort_perf();
+void parallel_perf();
+void select_perf();
+void alloc_perf();
+void compact_perf();
+void move_perf();
+void dispatch_perf();
+
+// number of timed operations per data point
+const int reps = 200000;
+
+// allocation counters maintained by the global operator new/delete
+// below. Live bytes counts each block's usable size as malloc reports
+// it, so it includes malloc's rounding up but not its own headers.
+long long allocations = 0;
+long long live_bytes = 0;
+
+// usable size of a block from malloc
+size_t block_size(void* block)
+{
+#ifdef __APPLE__
+  return malloc_size(block);
+#else
+  return malloc_usable_size(block);
+#endif
+}
+
+void* operator new(size_t size)
+{
+  void* block = malloc(size);
+  if (!block)
+    throw bad_alloc();
+  allocations++;
+  live_bytes += block_size(block);
+  return block;
+}
+
+// GCC cannot tell this delete is the replacement for the operator new
+// above, so it flags the free as mismatched
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* ptr) noexcept
+{
+  if (!ptr)
+    return;
+  live_bytes -= block_size(ptr);
+  free(ptr);
+}
+#pragma GCC diagnostic pop
+
+void operator delete(void* ptr, size_t) noexcept
+{
+  operator delete(ptr);
+}
+
+
+int main(int argc, char* argv[])
+{
+  // configure output
+  cout << fixed << showpoint;
+  cout << setprecision(2);
+
+  if (argc == 2 && strcmp(argv[1], "search") == 0)
+    search_perf();
+  else if (argc == 2 && strcmp(argv[1], "adaptive") == 0)
+    adaptive_perf();
+  else if (argc == 2 && strcmp(argv[1], "growth") == 0)
+    growth_perf();
+  else if (argc == 2 && strcmp(argv[1], "range") == 0)
+    range_perf();
+  else if (argc == 2 && strcmp(argv[1], "gap") == 0)
+    gap_perf();
+  else if (argc == 2 && strcmp(argv[1], "sort") == 0)
+    sort_perf();
+  else if (argc == 2 && strcmp(argv[1], "parallel") == 0)
+    parallel_perf();
+  else if (argc == 2 && strcmp(argv[1], "select") == 0)
+    select_perf();
+  else if (argc == 2 && strcmp(argv[1], "alloc") == 0)
+    alloc_perf();
+  else if (argc == 2 && strcmp(argv[1], "compact") == 0)
+    compact_perf();
+  else if (argc == 2 && strcmp(argv[1], "move") == 0)
+    move_perf();
+  else if (argc == 2 && strcmp(argv[1], "dispatch") == 0)
+    dispatch_perf();
+  else {
+    cout << "usage: " << argv[0] << " <benchmark>" << endl;
+    cout << "  search   -- ArrayMap vs BinSearchMap contains on small maps" << endl;
+    cout << "  adaptive -- AdaptiveMap memory and latency per size band" << endl;
+    cout << "  growth   -- ArraySeq push_back growth time and peak memory" << endl;
+    cout << "  range    -- small find_keys into an ArraySeq vs a SmallSeq" << endl;
+    cout << "  gap      -- ArraySeq vs GapSeq insert/erase, random and clustered" << endl;
+    cout << "  sort     -- ArraySeq sorts on sorted, reversed and shuffled input" << endl;
+    cout << "  parallel -- ArraySeq parallel_sort and HashMap sorted_keys speedup by thread count" << endl;
+    cout << "  select   -- full sort vs nth_element, partial_sort and top-k" << endl;
+    cout << "  alloc    -- AVL, BST and hash maps with heap vs pool nodes" << endl;
+    cout << "  compact  -- AVLMap vs CompactAVLMap memory and contains" << endl;
+    cout << "  move     -- copy vs move vs emplace inserts, string keys and large values" << endl;
+    cout << "  dispatch -- contains through the concrete map type vs through Map&" << endl;
+    return 1;
+  }
+}
+
+
+// Finds the size where the (vectorized) linear search of an ArrayMap
+// stops beating the binary search of a BinSearchMap
+void search_perf()
+{
+  cout << "# All times in nanoseconds (nsec) per operation" << endl;
+  cout << "# Column 1 = map size" << endl;
+  cout << "# Column 2 = array map contains" << endl;
+  cout << "# Column 3 = binsearch map contains" << endl;
+
+  for (int n = 1; n <= 256; n *= 2) {
+    ArraySeq<int> keys;
+    load_shuffled(keys, n, 3);
+    ArrayMap<int,int> m1;
+    BinSearchMap<int,int> m2;
+    for (int i = 0; i < n; ++i) {
+      m1.insert(keys[i], i);
+      m2.insert(keys[i], i);
+    }
+    m2.merge();
+
+    int found = 0;
+    auto t0 = high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r)
+      found += m1.contains(keys[r % n]);
+    auto t1 = high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r)
+      found += m2.contains(keys[r % n]);
+    auto t2 = high_resolution_clock::now();
+
+    cout << n << " "
+         << duration_cast<nanoseconds>(t1 - t0).count() / (double) reps << " "
+         << duration_cast<nanoseconds>(t2 - t1).count() / (double) reps << " "
+         << endl;
+    if (found != 2 * reps)
+      cerr << "search_perf: missing keys" << endl;
+  }
+}
+
+
+// Reports the memory and latency of an AdaptiveMap in each size band
+// next to the AVLMap it would otherwise be
+void adaptive_perf()
+{
+  cout << "# All times in nanoseconds (nsec) per operation" << endl;
+  cout << "# Column 1 = map size" << endl;
+  cout << "# Column 2 = adaptive map representation (0=array 1=binsearch 2=tree)" << endl;
+  cout << "# Column 3 = adaptive map heap bytes per pair" << endl;
+  cout << "# Column 4 = adaptive map insert (amortized, with migrations)" << endl;
+  cout << "# Column 5 = adaptive map contains" << endl;
+  cout << "# Column 6 = avl map heap bytes per pair" << endl;
+  cout << "# Column 7 = avl map insert" << endl;
+  cout << "# Column 8 = avl map contains" << endl;
+
+  for (int n = 1; n <= 65536; n *= 4) {
+    ArraySeq<int> keys;
+    load_shuffled(keys, n, 3);
+
+    long long base = live_bytes;
+    auto t0 = high_resolution_clock::now();
+    AdaptiveMap<int,int>* m1 = new AdaptiveMap<int,int>;
+    for (int i = 0; i < n; ++i)
+      m1->insert(keys[i], i);
+    auto t1 = high_resolution_clock::now();
+    double bytes1 = (live_bytes - base) / (double) n;
+
+    base = live_bytes;
+    auto t2 = high_resolution_clock::now();
+    AVLMap<int,int>* m2 = new AVLMap<int,int>;
+    for (int i = 0; i < n; ++i)
+      m2->insert(keys[i], i);
+    auto t3 = high_resolution_clock::now();
+    double bytes2 = (live_bytes - base) / (double) n;
+
+    int found = 0;
+    auto t4 = high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r)
+      found += m1->contains(keys[r % n]);
+    auto t5 = high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r)
+      found += m2->contains(keys[r % n]);
+    auto t6 = high_resolution_clock::now();
+
+    cout << n << " " << m1->representation() << " " << bytes1 << " "
+         << duration_cast<nanoseconds>(t1 - t0).count() / (double) n << " "
+         << duration_cast<nanoseconds>(t5 - t4).count() / (double) reps << " "
+         << bytes2 << " "
+         << duration_cast<nanoseconds>(t3 - t2).count() / (double) n << " "
+         << duration_cast<nanoseconds>(t6 - t5).count() / (double) reps << " "
+         << endl;
+    if (found != 2 * reps)
+      cerr << "adaptive_perf: missing keys" << endl;
+    delete m1;
+    delete m2;
+  }
+}
+
+
+// Same size as an int, but not trivially copyable, so an ArraySeq of
+// these always grows on the heap by moving each element
+struct HeapInt
+{
+  int value;
+  HeapInt(int value = 0) : value(value) {}
+  HeapInt(const HeapInt& rhs) : value(rhs.value) {}
+  HeapInt& operator=(const HeapInt& rhs) { value = rhs.value; return *this; }
+  bool operator==(const HeapInt& rhs) const { return value == rhs.value; }
+  bool operator<(const HeapInt& rhs) const { return value < rhs.value; }
+};
+
+
+#ifdef __linux__
+// Fills an ArraySeq<T> with n elements in a child process, giving the
+// time per push_back and the child's peak resident set size in MB
+template<typename T>
+void growth_run(int n, double& nsec, double& peak)
+{
+  int fds[2];
+  if (pipe(fds) != 0) {
+    nsec = peak = -1;
+    return;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    auto t0 = high_resolution_clock::now();
+    ArraySeq<T> seq;
+    for (int i = 0; i < n; ++i)
+      seq.push_back(T(i));
+    auto t1 = high_resolution_clock::now();
+    double time = duration_cast<nanoseconds>(t1 - t0).count() / (double) n;
+    if (write(fds[1], &time, sizeof(time)) != sizeof(time))
+      _exit(1);
+    _exit(0);
+  }
+  close(fds[1]);
+  if (read(fds[0], &nsec, sizeof(nsec)) != sizeof(nsec))
+    nsec = -1;
+  close(fds[0]);
+  int status;
+  struct rusage usage;
+  wait4(pid, &status, 0, &usage);
+  peak = usage.ru_maxrss / 1024.0;
+}
+#endif
+
+
+// Compares growing a large ArraySeq<int> (mapped and grown with
+// mremap past the threshold) to a same-sized type that must grow by
+// copying into a new heap array
+void growth_perf()
+{
+#ifdef __linux__
+  cout << "# All times in nanoseconds (nsec) per push_back" << endl;
+  cout << "# Column 1 = number of elements" << endl;
+  cout << "# Column 2 = mapped growth (int)" << endl;
+  cout << "# Column 3 = mapped growth peak RSS (MB)" << endl;
+  cout << "# Column 4 = heap growth (non-trivial int)" << endl;
+  cout << "# Column 5 = heap growth peak RSS (MB)" << endl;
+
+  // one past a power of two, so the last push_back doubles the array
+  // while it is full
+  for (int n = (1 << 18) + 1; n <= (1 << 26) + 1; n = 4 * n - 3) {
+    double t1, rss1, t2, rss2;
+    growth_run<int>(n, t1, rss1);
+    growth_run<HeapInt>(n, t2, rss2);
+    cout << n << " " << t1 << " " << rss1 << " " << t2 << " " << rss2 << " " << endl;
+  }
+#else
+  cout << "growth benchmark requires Linux" << endl;
+#endif
+}
+
+
+// Small range queries on an AVLMap, returning an ArraySeq versus
+// filling a SmallSeq on the stack
+void range_perf()
+{
+  cout << "# All times in nanoseconds (nsec) per query" << endl;
+  cout << "# Column 1 = keys per range" << endl;
+  cout << "# Column 2 = find_keys into ArraySeq" << endl;
+  cout << "# Column 3 = ArraySeq allocations per query" << endl;
+  cout << "# Column 4 = find_keys into SmallSeq<K,16>" << endl;
+  cout << "# Column 5 = SmallSeq allocations per query" << endl;
+
+  int n = 100000;
+  ArraySeq<int> keys;
+  load_shuffled(keys, n, 3);
+  AVLMap<int,int> m;
+  for (int i = 0; i < n; ++i)
+    m.insert(keys[i], i);
+
+  for (int width = 1; width <= 64; width *= 2) {
+    int found = 0;
+    long long base = allocations;
+    auto t0 = high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      int k1 = 1 + keys[r % n] % (n - width);
+      found += m.find_keys(k1, k1 + width - 1).size();
+    }
+    auto t1 = high_resolution_clock::now();
+    double allocs1 = (allocations - base) / (double) reps;
+    base = allocations;
+    auto t2 = high_resolution_clock::now();
+    for (int r = 0; r < reps; ++r) {
+      int k1 = 1 + keys[r % n] % (n - width);
+      SmallSeq<int> result;
+      m.find_keys(k1, k1 + width - 1, result);
+      found += result.size();
+    }
+    auto t3 = high_resolution_clock::now();
+    double allocs2 = (allocations - base) / (double) reps;
+
+    cout << width << " "
+         << duration_cast<nanoseconds>(t1 - t0).count() / (double) reps << " "
+         << allocs1 << " "
+         << duration_cast<nanoseconds>(t3 - t2).count() / (double) reps << " "
+         << allocs2 << " " << endl;
+    if (found != 2 * width * reps)
+      cerr << "range_perf: missing keys" << endl;
+  }
+}
+
+
+// Returns the next index to edit in a sequence of the given size,
+// either anywhere or within 8 of the previous index
+int next_index(int index, int size, bool clustered)
+{
+  if (!clustered)
+    return rand() % size;
+  index += rand() % 17 - 8;
+  if (index < 0)
+    return 0;
+  if (index >= size)
+    return size - 1;
+  return index;
+}
+
+
+// Times edits inserts followed by edits erases on a sequence that
+// starts out with n elements. The erases start again from the middle
+// with their own random positions, so they are timed on the same
+// random or clustered pattern as the inserts rather than following
+// the last insert.
+template<typename S>
+void edit_run(int n, int edits, bool clustered, double& insert_time, double& erase_time)
+{
+  S seq;
+  for (int i = 0; i < n; ++i)
+    seq.insert(i, i);
+  srand(7);
+  int index = n / 2;
+  auto t0 = high_resolution_clock::now();
+  for (int r = 0; r < edits; ++r) {
+    index = next_index(index, seq.size(), clustered);
+    seq.insert(r, index);
+  }
+  auto t1 = high_resolution_clock::now();
+  srand(11);
+  index = seq.size() / 2;
+  for (int r = 0; r < edits; ++r) {
+    index = next_index(index, seq.size(), clustered);
+    seq.erase(index);
+  }
+  auto t2 = high_resolution_clock::now();
+  insert_time = duration_cast<nanoseconds>(t1 - t0).count() / (double) edits;
+  erase_time = duration_cast<nanoseconds>(t2 - t1).count() / (double) edits;
+}
+
+
+// Compares ArraySeq and GapSeq edits at random and at clustered
+// positions
+void gap_perf()
+{
+  cout << "# All times in nanoseconds (nsec) per operation" << endl;
+  cout << "# Column 1 = sequence size" << endl;
+  cout << "# Column 2 = array seq random insert" << endl;
+  cout << "# Column 3 = gap seq random insert" << endl;
+  cout << "# Column 4 = array seq clustered insert" << endl;
+  cout << "# Column 5 = gap seq clustered insert" << endl;
+  cout << "# Column 6 = array seq random erase" << endl;
+  cout << "# Column 7 = gap seq random erase" << endl;
+  cout << "# Column 8 = array seq clustered erase" << endl;
+  cout << "# Column 9 = gap seq clustered erase" << endl;
+
+  const int edits = 2000;
+  for (int n = 1000; n <= 1000000; n *= 10) {
+    double ins[4], ers[4];
+    edit_run<ArraySeq<int>>(n, edits, false, ins[0], ers[0]);
+    edit_run<GapSeq<int>>(n, edits, false, ins[1], ers[1]);
+    edit_run<ArraySeq<int>>(n, edits, true, ins[2], ers[2]);
+    edit_run<GapSeq<int>>(n, edits, true, ins[3], ers[3]);
+    cout << n << " ";
+    for (int i = 0; i < 4; ++i)
+      cout << ins[i] << " ";
+    for (int i = 0; i < 4; ++i)
+      cout << ers[i] << " ";
+    cout << endl;
+  }
+}
+
+
+// Resets the sequence to sorted (0), reversed (1) or faro shuffled
+// (2) input, then times one of intro sort (0), merge sort (1),
+// random pivot quick sort (2) or radix sort (3) on it in milliseconds
+double timed_sort(ArraySeq<int>& seq, int input, int sort)
+{
+  if (input == 0)
+    reset_ordered(seq);
+  else if (input == 1)
+    reset_reversed(seq);
+  else
+    reset_shuffled(seq, 3);
+  auto t0 = high_resolution_clock::now();
+  if (sort == 0)
+    seq.intro_sort();
+  else if (sort == 1)
+    seq.merge_sort();
+  else if (sort == 2)
+    seq.quick_sort_random();
+  else
+    seq.radix_sort();
+  auto t1 = high_resolution_clock::now();
+  for (int i = 0; i < seq.size() - 1; ++i)
+    if (seq[i + 1] < seq[i]) {
+      cerr << "sort_perf: not sorted" << endl;
+      break;
+    }
+  return duration_cast<microseconds>(t1 - t0).count() / 1000.0;
+}
+
+
+// Compares the ArraySeq sorts on the util.cpp input orders
+void sort_perf()
+{
+  cout << "# All times in milliseconds (msec) per sort" << endl;
+  cout << "# Column 1 = number of elements" << endl;
+  cout << "# Column 2 = sorted input, intro sort" << endl;
+  cout << "# Column 3 = sorted input, merge sort" << endl;
+  cout << "# Column 4 = sorted input, random quick sort" << endl;
+  cout << "# Column 5 = reversed input, intro sort" << endl;
+  cout << "# Column 6 = reversed input, merge sort" << endl;
+  cout << "# Column 7 = reversed input, random quick sort" << endl;
+  cout << "# Column 8 = shuffled input, intro sort" << endl;
+  cout << "# Column 9 = shuffled input, merge sort" << endl;
+  cout << "# Column 10 = shuffled input, random quick sort" << endl;
+  cout << "# Column 11 = sorted input, radix sort" << endl;
+  cout << "# Column 12 = reversed input, radix sort" << endl;
+  cout << "# Column 13 = shuffled input, radix sort" << endl;
+
+  for (int n = 10000; n <= 10000000; n *= 10) {
+    ArraySeq<int> seq;
+    load_in_order(seq, n);
+    cout << n << " ";
+    for (int input = 0; input < 3; ++input)
+      for (int sort = 0; sort < 3; ++sort)
+        cout << timed_sort(seq, input, sort) << " ";
+    for (int input = 0; input < 3; ++input)
+      cout << timed_sort(seq, input, 3) << " ";
+    cout << endl;
+  }
+}
+
+
+// Copies the input into the sequence and times parallel_sort on it in
+// milliseconds
+template<typename T>
+double timed_parallel_sort(ArraySeq<T>& seq, const ArraySeq<T>& input, int threads)
+{
+  seq = input;
+  auto t0 = high_resolution_clock::now();
+  seq.parallel_sort(threads);
+  auto t1 = high_resolution_clock::now();
+  for (int i = 0; i < seq.size() - 1; ++i)
+    if (seq[i + 1] < seq[i]) {
+      cerr << "parallel_perf: not sorted" << endl;
+      break;
+    }
+  return duration_cast<microseconds>(t1 - t0).count() / 1000.0;
+}
+
+
+// Times HashMap sorted_keys with the given thread count in
+// milliseconds
+double timed_sorted_keys(const HashMap<int,int>& map, int threads)
+{
+  auto t0 = high_resolution_clock::now();
+  ArraySeq<int> keys = map.sorted_keys(threads);
+  auto t1 = high_resolution_clock::now();
+  if (keys.size() != map.size())
+    cerr << "parallel_perf: wrong key count" << endl;
+  return duration_cast<microseconds>(t1 - t0).count() / 1000.0;
+}
+
+
+// Times parallel_sort on random ints (radix sorted chunks) and random
+// doubles (intro sorted chunks), and sorted_keys on a HashMap with
+// random int keys, at 1 to 16 threads
+void parallel_perf()
+{
+  const int n = 10000000;
+  const int map_n = 2000000;
+  cout << "# All times in milliseconds (msec) per sort of " << n << " elements" << endl;
+  cout << "# hardware threads = " << thread::hardware_concurrency() << endl;
+  cout << "# Column 1 = number of threads" << endl;
+  cout << "# Column 2 = random ints, parallel sort" << endl;
+  cout << "# Column 3 = random ints, speedup over 1 thread" << endl;
+  cout << "# Column 4 = random doubles, parallel sort" << endl;
+  cout << "# Column 5 = random doubles, speedup over 1 thread" << endl;
+  cout << "# Column 6 = HashMap sorted_keys, " << map_n << " random int keys" << endl;
+  cout << "# Column 7 = HashMap sorted_keys, speedup over 1 thread" << endl;
+
+  srand(1);
+  ArraySeq<int> ints;
+  ArraySeq<double> doubles;
+  ints.reserve(n);
+  doubles.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    ints.push_back(rand());
+    doubles.push_back(rand() / (double) RAND_MAX);
+  }
+  HashMap<int,int> map;
+  for (int i = 0; i < map_n; ++i)
+    map.try_emplace(rand(), i);
+  ArraySeq<int> int_seq;
+  ArraySeq<double> double_seq;
+  double int_base = 0;
+  double double_base = 0;
+  double map_base = 0;
+  for (int threads = 1; threads <= 16; threads *= 2) {
+    double int_time = timed_parallel_sort(int_seq, ints, threads);
+    double double_time = timed_parallel_sort(double_seq, doubles, threads);
+    double map_time = timed_sorted_keys(map, threads);
+    if (threads == 1) {
+      int_base = int_time;
+      double_base = double_time;
+      map_base = map_time;
+    }
+    cout << threads << " " << int_time << " " << int_base / int_time << " "
+         << double_time << " " << double_base / double_time << " "
+         << map_time << " " << map_base / map_time << endl;
+  }
+}
+
+
+// Compares a full sort against the selection operations for the k =
+// 100 smallest keys, on a shuffled ArraySeq and through a HashMap
+void select_perf()
+{
+  const int k = 100;
+  cout << "# All times in milliseconds (msec), k = " << k << endl;
+  cout << "# Column 1 = number of elements" << endl;
+  cout << "# Column 2 = ArraySeq sort" << endl;
+  cout << "# Column 3 = ArraySeq nth_element (median)" << endl;
+  cout << "# Column 4 = ArraySeq partial_sort(k)" << endl;
+  cout << "# Column 5 = TopK(k) over the ArraySeq" << endl;
+  cout << "# Column 6 = HashMap sorted_keys" << endl;
+  cout << "# Column 7 = HashMap first_keys(k)" << endl;
+
+  for (int n = 10000; n <= 10000000; n *= 10) {
+    ArraySeq<int> input;
+    load_shuffled(input, n, 3);
+    ArraySeq<int> seq;
+    double times[6];
+    for (int op = 0; op < 4; ++op) {
+      seq = input;
+      auto t0 = high_resolution_clock::now();
+      if (op == 0)
+        seq.sort();
+      else if (op == 1)
+        seq.nth_element(n / 2);
+      else if (op == 2)
+        seq.partial_sort(k);
+      else {
+        TopK<int> top(k);
+        for (int i = 0; i < n; ++i)
+          top.push(seq[i]);
+        seq = top.sorted();
+      }
+      auto t1 = high_resolution_clock::now();
+      times[op] = duration_cast<microseconds>(t1 - t0).count() / 1000.0;
+      if ((op == 1 && seq[n / 2] != n / 2 + 1) || (op != 1 && seq[k - 1] != k))
+        cerr << "select_perf: wrong result" << endl;
+    }
+    HashMap<int,int> m;
+    for (int i = 0; i < n; ++i)
+      m.insert(input[i], i);
+    auto t0 = high_resolution_clock::now();
+    ArraySeq<int> all = m.sorted_keys();
+    auto t1 = high_resolution_clock::now();
+    ArraySeq<int> first = m.first_keys(1, k);
+    auto t2 = high_resolution_clock::now();
+    times[4] = duration_cast<microseconds>(t1 - t0).count() / 1000.0;
+    times[5] = duration_cast<microseconds>(t2 - t1).count() / 1000.0;
+    if (first[k - 1] != all[k - 1])
+      cerr << "select_perf: wrong result" << endl;
+    cout << n << " ";
+    for (int i = 0; i < 6; ++i)
+      cout << times[i] << " ";
+    cout << endl;
+  }
+}
+
+
+// Inserts the keys, erases and reinserts every other one, then clears
+// the map (in a loop so clear is part of the timing). Gives the time
+// and heap allocations per operation.
+template<typename M>
+void alloc_run(const ArraySeq<int>& keys, double& nsec, double& allocs)
+{
+  int n = keys.size();
+  int rounds = 5;
+  M m;
+  long long before = allocations;
+  auto t0 = high_resolution_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < n; ++i)
+      m.insert(keys[i], i);
+    for (int i = 0; i < n; i += 2)
+      m.erase(keys[i]);
+    for (int i = 0; i < n; i += 2)
+      m.insert(keys[i], i);
+    m.clear();
+  }
+  auto t1 = high_resolution_clock::now();
+  double ops = rounds * (2.0 * n + 1);
+  nsec = duration_cast<nanoseconds>(t1 - t0).count() / ops;
+  allocs = (allocations - before) / ops;
+  if (!m.empty())
+    cerr << "alloc_perf: map not cleared" << endl;
+}
+
+
+// Compares the default heap allocated nodes against PoolAlloc nodes
+// in the linked maps, in time and in heap allocations per operation
+void alloc_perf()
+{
+  cout << "# Times in nanoseconds (nsec) per insert, erase or clear" << endl;
+  cout << "# Column 1 = number of keys" << endl;
+  cout << "# Column 2 = avl map, heap nodes" << endl;
+  cout << "# Column 3 = avl map, pool nodes" << endl;
+  cout << "# Column 4 = bst map, heap nodes" << endl;
+  cout << "# Column 5 = bst map, pool nodes" << endl;
+  cout << "# Column 6 = hash map, heap nodes" << endl;
+  cout << "# Column 7 = hash map, pool nodes" << endl;
+  cout << "# Columns 8-13 = heap allocations per operation, same order" << endl;
+
+  srand(1);
+  for (int n = 1000; n <= 1000000; n *= 10) {
+    // a random permutation, faro shuffled keys make the BST a list
+    ArraySeq<int> keys;
+    load_in_order(keys, n);
+    for (int i = n - 1; i > 0; --i)
+      swap(keys[i], keys[rand() % (i + 1)]);
+    double nsec[6];
+    double allocs[6];
+    alloc_run<AVLMap<int,int>>(keys, nsec[0], allocs[0]);
+    alloc_run<AVLMap<int,int,PoolAlloc>>(keys, nsec[1], allocs[1]);
+    alloc_run<BSTMap<int,int>>(keys, nsec[2], allocs[2]);
+    alloc_run<BSTMap<int,int,PoolAlloc>>(keys, nsec[3], allocs[3]);
+    alloc_run<HashMap<int,int>>(keys, nsec[4], allocs[4]);
+    alloc_run<HashMap<int,int,PoolAlloc>>(keys, nsec[5], allocs[5]);
+    cout << n << " ";
+    for (int i = 0; i < 6; ++i)
+      cout << nsec[i] << " ";
+    for (int i = 0; i < 6; ++i)
+      cout << setprecision(4) << allocs[i] << setprecision(2) << " ";
+    cout << endl;
+  }
+}
+
+
+// Builds a map of the keys, giving the heap bytes per pair, the time
+// per insert and the time per contains of a random key
+template<typename M>
+void compact_run(const ArraySeq<int>& keys, double& bytes, double& insert_nsec,
+                 double& contains_nsec)
+{
+  int n = keys.size();
+  long long base = live_bytes;
+  auto t0 = high_resolution_clock::now();
+  M* m = new M;
+  for (int i = 0; i < n; ++i)
+    m->insert(keys[i], i);
+  auto t1 = high_resolution_clock::now();
+  bytes = (live_bytes - base) / (double) n;
+  int found = 0;
+  auto t2 = high_resolution_clock::now();
+  for (int r = 0; r < reps; ++r)
+    found += m->contains(keys[(r * 7919LL) % n]);
+  auto t3 = high_resolution_clock::now();
+  insert_nsec = duration_cast<nanoseconds>(t1 - t0).count() / (double) n;
+  contains_nsec = duration_cast<nanoseconds>(t3 - t2).count() / (double) reps;
+  if (found != reps)
+    cerr << "compact_perf: missing keys" << endl;
+  delete m;
+}
+
+
+// Compares the pointer linked AVLMap (heap and pool nodes) against the
+// 32-bit index CompactAVLMap in memory and in lookup time as the tree
+// grows past the caches
+void compact_perf()
+{
+  cout << "# Times in nanoseconds (nsec) per operation" << endl;
+  cout << "# Column 1 = number of keys" << endl;
+  cout << "# Columns 2-4 = heap bytes per pair: avl heap nodes, avl pool nodes, compact" << endl;
+  cout << "# Columns 5-7 = insert, same order" << endl;
+  cout << "# Columns 8-10 = contains, same order" << endl;
+
+  srand(1);
+  for (int n = 10000; n <= 10000000; n *= 10) {
+    ArraySeq<int> keys;
+    load_in_order(keys, n);
+    for (int i = n - 1; i > 0; --i)
+      swap(keys[i], keys[rand() % (i + 1)]);
+    double bytes[3];
+    double insert_nsec[3];
+    double contains_nsec[3];
+    compact_run<AVLMap<int,int>>(keys, bytes[0], insert_nsec[0], contains_nsec[0]);
+    compact_run<AVLMap<int,int,PoolAlloc>>(keys, bytes[1], insert_nsec[1], contains_nsec[1]);
+    compact_run<CompactAVLMap<int,int>>(keys, bytes[2], insert_nsec[2], contains_nsec[2]);
+    cout << n << " ";
+    for (int i = 0; i < 3; ++i)
+      cout << bytes[i] << " ";
+    for (int i = 0; i < 3; ++i)
+      cout << insert_nsec[i] << " ";
+    for (int i = 0; i < 3; ++i)
+      cout << contains_nsec[i] << " ";
+    cout << endl;
+  }
+}
+
+
+// A large value: a name too long for the small string buffer and a
+// block of counters
+struct Record
+{
+  string name;
+  long long stats[24] = {};
+  Record() {}
+  Record(int id) : name(40, 'a' + id % 26) { stats[0] = id; }
+  bool operator==(const Record& rhs) const { return name == rhs.name && stats[0] == rhs.stats[0]; }
+  bool operator<(const Record& rhs) const { return stats[0] < rhs.stats[0]; }
+};
+
+
+// Inserts the keys with values V(i) by copying a key and value (how
+// 0), moving them (how 1) or emplacing the value from i (how 2). Each
+// way builds the key and value once. Gives the time and heap
+// allocations per insert.
+template<typename M, typename K, typename V>
+void move_run(const ArraySeq<K>& keys, int how, double& nsec, double& allocs)
+{
+  int n = keys.size();
+  int rounds = reps / n > 1 ? reps / n : 1;
+  M m;
+  long long before = allocations;
+  auto t0 = high_resolution_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    for (int i = 0; i < n; ++i) {
+      if (how == 0) {
+        K key = keys[i];
+        V value(i);
+        m.insert(key, value);
+      } else if (how == 1) {
+        K key = keys[i];
+        V value(i);
+        m.insert(std::move(key), std::move(value));
+      } else
+        m.emplace(keys[i], i);
+    }
+    m.clear();
+  }
+  auto t1 = high_resolution_clock::now();
+  double ops = (double) rounds * n;
+  nsec = duration_cast<nanoseconds>(t1 - t0).count() / ops;
+  allocs = (allocations - before) / ops;
+}
+
+
+// Compares copying, moving and emplacing pairs into the AVLMap and
+// HashMap, with string keys (and int values) and with int keys and a
+// large Record value
+void move_perf()
+{
+  cout << "# Times in nanoseconds (nsec) per insert" << endl;
+  cout << "# Column 1 = number of keys" << endl;
+  cout << "# Columns 2-4 = string keys, avl map: copy, move, emplace" << endl;
+  cout << "# Columns 5-7 = string keys, hash map: copy, move, emplace" << endl;
+  cout << "# Columns 8-10 = record values, avl map: copy, move, emplace" << endl;
+  cout << "# Columns 11-13 = record values, hash map: copy, move, emplace" << endl;
+  cout << "# Columns 14-16 = heap allocations per insert, string keys, avl map" << endl;
+
+  srand(1);
+  for (int n = 1000; n <= 1000000; n *= 10) {
+    ArraySeq<int> keys;
+    load_in_order(keys, n);
+    for (int i = n - 1; i > 0; --i)
+      swap(keys[i], keys[rand() % (i + 1)]);
+    ArraySeq<string> str_keys;
+    for (int i = 0; i < n; ++i)
+      str_keys.push_back("customer:" + string(20, '0') + to_string(keys[i]));
+    double nsec[12];
+    double allocs[12];
+    for (int how = 0; how < 3; ++how) {
+      move_run<AVLMap<string,int>,string,int>(str_keys, how, nsec[how], allocs[how]);
+      move_run<HashMap<string,int>,string,int>(str_keys, how, nsec[3 + how], allocs[3 + how]);
+      move_run<AVLMap<int,Record>,int,Record>(keys, how, nsec[6 + how], allocs[6 + how]);
+      move_run<HashMap<int,Record>,int,Record>(keys, how, nsec[9 + how], allocs[9 + how]);
+    }
+    cout << n << " ";
+    for (int i = 0; i < 12; ++i)
+      cout << nsec[i] << " ";
+    for (int i = 0; i < 3; ++i)
+      cout << allocs[i] << " ";
+    cout << endl;
+  }
+}
+
+
+// Times count_contained over the keys through the concrete map type
+// (static_nsec) and through a Map<int,int>& (virtual_nsec). The Map&
+// is picked through a volatile index, so the compiler cannot see the
+// map's type and devirtualize the calls, as when the map comes from
+// another translation unit.
+template<typename M>
+void dispatch_run(const ArraySeq<int>& keys, double& static_nsec, double& virtual_nsec)
+{
+  static_assert(is_static_map<M, int, int>::value, "dispatch_run needs a map type");
+  int n = keys.size();
+  int rounds = 10 * reps / n > 1 ? 10 * reps / n : 1;
+  M m;
+  M other;
+  insert_all(m, keys.data(), keys.data(), n);
+  Map<int,int>* maps[2] = {&m, &other};
+  volatile int pick = 0;
+  const Map<int,int>& dynamic = *maps[pick];
+  int found = 0;
+  auto t0 = high_resolution_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    found += count_contained(m, keys.data(), n);
+  auto t1 = high_resolution_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    found += count_contained(dynamic, keys.data(), n);
+  auto t2 = high_resolution_clock::now();
+  double ops = (double) rounds * n;
+  static_nsec = duration_cast<nanoseconds>(t1 - t0).count() / ops;
+  virtual_nsec = duration_cast<nanoseconds>(t2 - t1).count() / ops;
+  if (found != 2 * rounds * n)
+    cerr << "dispatch_perf: missing keys" << endl;
+}
+
+
+// Compares statically and virtually dispatched contains on the hash,
+// AVL, compact AVL and binary search maps, from cache resident sizes
+// up to sizes where the search itself is the cost
+void dispatch_perf()
+{
+  cout << "# Times in nanoseconds (nsec) per contains" << endl;
+  cout << "# Column 1 = number of keys" << endl;
+  cout << "# Columns 2-5 = static dispatch: hash, avl, compact, binsearch" << endl;
+  cout << "# Columns 6-9 = virtual dispatch, same order" << endl;
+
+  srand(1);
+  for (int n = 16; n <= 1048576; n *= 16) {
+    ArraySeq<int> keys;
+    load_in_order(keys, n);
+    for (int i = n - 1; i > 0; --i)
+      swap(keys[i], keys[rand() % (i + 1)]);
+    double static_nsec[4];
+    double virtual_nsec[4];
+    dispatch_run<HashMap<int,int>>(keys, static_nsec[0], virtual_nsec[0]);
+    dispatch_run<AVLMap<int,int>>(keys, static_nsec[1], virtual_nsec[1]);
+    dispatch_run<CompactAVLMap<int,int>>(keys, static_nsec[2], virtual_nsec[2]);
+    dispatch_run<BinSearchMap<int,int>>(keys, static_nsec[3], virtual_nsec[3]);
+    cout << n << " ";
+    for (int i = 0; i < 4; ++i)
+      cout << static_nsec[i] << " ";
+    for (int i = 0; i < 4; ++i)
+      cout << virtual_nsec[i] << " ";
+    cout << endl;
+  }
+}
@@ -0,0 +1,759 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: pmamap.h
+// DATE: Spring 2022
+// DESC: Packed-memory array implementation of the Map interface. Like
+//       the BinSearchMap, the key-value pairs are kept in sorted
+//       order, but the array is split into equal sized segments that
+//       leave empty slots for new pairs. When a segment fills up (or
+//       becomes too sparse), the smallest enclosing window of
+//       segments within its density bounds is evenly redistributed,
+//       giving O(log^2 n) amortized inserts and erases while range
+//       scans stay contiguous.
+//---------------------------------------------------------------------------
+
+#ifndef PMAMAP_H
+#define PMAMAP_H
+
+#include "map.h"
+#include "arrayseq.h"
+#include <tuple>
+
+
+template<typename K, typename V>
+class PMAMap final : public Map<K,V>
+{
+public:
+
+  // default constructor
+  PMAMap();
+
+  // copy constructor
+  PMAMap(const PMAMap& rhs);
+
+  // move constructor
+  PMAMap(PMAMap&& rhs);
+
+  // copy assignment
+  PMAMap& operator=(const PMAMap& rhs);
+
+  // move assignment
+  PMAMap& operator=(PMAMap&& rhs);
+
+  // destructor
+  ~PMAMap();
+
+  // Returns the number of key-value pairs in the map
+  int size() const;
+
+  // Tests if the map is empty
+  bool empty() const;
+
+  // Allows values associated with a key to be updated. Throws
+  // out_of_range if the given key is not in the collection.
+  V& operator[](const K& key);
+
+  // Returns the value for a given key. Throws out_of_range if the
+  // given key is not in the collection.
+  const V& operator[](const K& key) const;
+
+  // Extends the collection by adding the given key-value
+  // pair. Assumes the key being added is not present in the
+  // collection. Insert does not check if the key is present.
+  void insert(const K& key, const V& value);
+
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
+  // Shrinks the collection by removing the key-value pair with the
+  // given key. Does not modify the collection if the collection does
+  // not contain the key. Throws out_of_range if the given key is not
+  // in the collection.
+  void erase(const K& key);
+
+  // Returns true if the key is in the collection, and false
+  // otherwise.
+  bool contains(const K& key) const;
+
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
+  // Returns the keys k in the collection such that k1 <= k <= k2
+  ArraySeq<K> find_keys(const K& k1, const K& k2) const;
+
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
+  // Returns the keys in the collection in ascending sorted order.
+  ArraySeq<K> sorted_keys() const;
+
+  // Gives the key (as an ouptput parameter) immediately after the
+  // given key according to ascending sort order. Returns true if a
+  // successor key exists, and false otherwise.
+  bool next_key(const K& key, K& next_key) const;
+
+  // Gives the key (as an ouptput parameter) immediately before the
+  // given key according to ascending sort order. Returns true if a
+  // predecessor key exists, and false otherwise.
+  bool prev_key(const K& key, K& prev_key) const;
+
+  // Removes all key-value pairs from the map.
+  void clear();
+
+private:
+
+  // smallest segment size (and smallest capacity of the array)
+  static const int min_segment_size = 8;
+
+  // density bounds for a single segment (leaf) and the whole array
+  // (root). Windows in between interpolate linearly by level.
+  static constexpr double leaf_upper = 1.0;
+  static constexpr double root_upper = 0.75;
+  static constexpr double leaf_lower = 0.125;
+  static constexpr double root_lower = 0.25;
+
+  // the gapped array of (key-value) pairs. Each segment keeps its
+  // pairs packed at the front of the segment.
+  std::pair<K,V>* array = nullptr;
+
+  // number of pairs stored in each segment
+  int* seg_counts = nullptr;
+
+  // number of key-value pairs in map
+  int count = 0;
+
+  // number of slots in the array
+  int capacity = 0;
+
+  // number of slots per segment
+  int segment_size = min_segment_size;
+
+  // number of segments (always a power of two)
+  int segments = 0;
+
+  // returns the last segment whose first key is less than or equal
+  // to the given key (or 0 if there is no such segment)
+  int find_segment(const K& key) const;
+
+  // finds the segment and offset of the key, returns false if the
+  // key is not in the collection (seg is then the segment it belongs
+  // in)
+  bool locate(const K& key, int& seg, int& offset) const;
+
+  // moves the pair into the given segment, which must be the one its
+  // key belongs in
+  void insert_at(std::pair<K,V>& entry, int seg);
+
+  // removes the pair at the given segment and offset
+  void remove_at(int seg, int offset);
+
+  // number of levels above the leaf segments
+  int height() const;
+
+  // density bounds for a window at the given level
+  double upper_density(int level) const;
+  double lower_density(int level) const;
+
+  // number of pairs stored in the given window of segments
+  int window_count(int first, int width) const;
+
+  // moves the pairs of the window of segments into temp in sorted
+  // order, adding extra (if not null)
+  void gather(int first, int width, std::pair<K,V>* extra,
+              std::pair<K,V>* temp);
+
+  // evenly redistributes the window of segments, adding extra (if
+  // not null) in sorted order
+  void redistribute(int first, int width, std::pair<K,V>* extra);
+
+  // evenly spreads the n sorted pairs in temp across the window
+  void spread(int first, int width, std::pair<K,V>* temp, int n);
+
+  // reallocates the array with the new capacity, adding extra (if not
+  // null) in sorted order
+  void rebuild(int new_capacity, std::pair<K,V>* extra);
+
+};
+
+
+template<typename K, typename V>
+PMAMap<K,V>::PMAMap()
+{
+}
+
+//initalizes the copy constructor
+template<typename K, typename V>
+PMAMap<K,V>::PMAMap(const PMAMap& rhs)
+{
+  *this = rhs;
+}
+
+//initalizes the move constructor
+template<typename K, typename V>
+PMAMap<K,V>::PMAMap(PMAMap&& rhs)
+{
+  *this = std::move(rhs);
+}
+
+//initalizes the copy assignment
+template<typename K, typename V>
+PMAMap<K,V>& PMAMap<K,V>::operator=(const PMAMap& rhs)
+{
+  if(this != &rhs){
+    clear();
+    if(rhs.capacity > 0){
+      array = new std::pair<K,V>[rhs.capacity];
+      seg_counts = new int[rhs.segments];
+      for(int i = 0; i < rhs.segments; i++){
+        seg_counts[i] = rhs.seg_counts[i];
+        for(int j = 0; j < rhs.seg_counts[i]; j++){
+          array[i * rhs.segment_size + j] = rhs.array[i * rhs.segment_size + j];
+        }
+      }
+    }
+    count = rhs.count;
+    capacity = rhs.capacity;
+    segment_size = rhs.segment_size;
+    segments = rhs.segments;
+  }
+  return *this;
+}
+
+//initalizes the move assignment
+template<typename K, typename V>
+PMAMap<K,V>& PMAMap<K,V>::operator=(PMAMap&& rhs)
+{
+  if(this != &rhs){
+    clear();
+    array = rhs.array;
+    seg_counts = rhs.seg_counts;
+    count = rhs.count;
+    capacity = rhs.capacity;
+    segment_size = rhs.segment_size;
+    segments = rhs.segments;
+    rhs.array = nullptr;
+    rhs.seg_counts = nullptr;
+    rhs.count = 0;
+    rhs.capacity = 0;
+    rhs.segment_size = min_segment_size;
+    rhs.segments = 0;
+  }
+  return *this;
+}
+
+//initalizes the destructor
+template<typename K, typename V>
+PMAMap<K,V>::~PMAMap()
+{
+  clear();
+}
+
+//Returns the size of the current PMAMap
+template<typename K, typename V>
+int PMAMap<K,V>::size() const
+{
+  return count;
+}
+
+//Returns true if the current PMAMap is empty, false if not
+template<typename K, typename V>
+bool PMAMap<K,V>::empty() const
+{
+  return count == 0;
+}
+
+//Returns the assocated value pair of the input key,
+//throws an out_of_range exception if key is not contained
+//in the PMAMap
+template<typename K, typename V>
+V& PMAMap<K,V>::operator[](const K& key)
+{
+  V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator PMAMap");
+  }
+  return *value;
+}
+
+//Returns the assocated value pair of the input key,
+//throws an out_of_range exception if key is not contained
+//in the PMAMap
+template<typename K, typename V>
+const V& PMAMap<K,V>::operator[](const K& key) const
+{
+  const V* value = find(key);
+  if(!value){
+    throw std::out_of_range("Out of Range in Operator PMAMap");
+  }
+  return *value;
+}
+
+//Inserts the given key value pair into its segment
+template<typename K, typename V>
+void PMAMap<K,V>::insert(const K& key, const V& value)
+{
+  emplace(key, value);
+}
+
+//Moves the given key value pair into its segment
+template<typename K, typename V>
+void PMAMap<K,V>::insert(K&& key, V&& value)
+{
+  emplace(std::move(key), std::move(value));
+}
+
+//Builds the pair once and moves it into its segment. The slots of the
+//array always hold constructed pairs, so the pair is moved into a
+//slot rather than built in it.
+template<typename K, typename V>
+template<typename KeyArg, typename... Args>
+void PMAMap<K,V>::emplace(KeyArg&& key, Args&&... args)
+{
+  std::pair<K,V> entry(std::piecewise_construct,
+                       std::forward_as_tuple(std::forward<KeyArg>(key)),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+  insert_at(entry, find_segment(entry.first));
+}
+
+//Removes the key value pair of the given key in the PMAMap. Throws an
+//out_of_range exception if key is not in the map.
+template<typename K, typename V>
+void PMAMap<K,V>::erase(const K& key)
+{
+  if(!try_erase(key)){
+    throw std::out_of_range("Out of Range in Erase");
+  }
+}
+
+//Returns true if the given key is found in the PMAMap, false if not
+template<typename K, typename V>
+bool PMAMap<K,V>::contains(const K& key) const
+{
+  int seg, offset;
+  return locate(key, seg, offset);
+}
+
+//Returns a pointer to the value of the given key, or nullptr if the
+//key is not in the PMAMap
+template<typename K, typename V>
+V* PMAMap<K,V>::find(const K& key)
+{
+  int seg, offset;
+  if(!locate(key, seg, offset)){
+    return nullptr;
+  }
+  return &array[seg * segment_size + offset].second;
+}
+
+//Returns a constant pointer to the value of the given key, or nullptr
+//if the key is not in the PMAMap
+template<typename K, typename V>
+const V* PMAMap<K,V>::find(const K& key) const
+{
+  int seg, offset;
+  if(!locate(key, seg, offset)){
+    return nullptr;
+  }
+  return &array[seg * segment_size + offset].second;
+}
+
+//Replaces the value of the given key, or adds the pair to the segment
+//the search ended in. Returns true if the pair was added.
+template<typename K, typename V>
+bool PMAMap<K,V>::insert_or_assign(const K& key, const V& value)
+{
+  int seg, offset;
+  if(locate(key, seg, offset)){
+    array[seg * segment_size + offset].second = value;
+    return false;
+  }
+  std::pair<K,V> entry(key, value);
+  insert_at(entry, seg);
+  return true;
+}
+
+//Adds the pair to the segment the search ended in if the key was not
+//found. Returns true if the pair was added.
+template<typename K, typename V>
+bool PMAMap<K,V>::try_emplace(const K& key, const V& value)
+{
+  int seg, offset;
+  if(locate(key, seg, offset)){
+    return false;
+  }
+  std::pair<K,V> entry(key, value);
+  insert_at(entry, seg);
+  return true;
+}
+
+//Removes the key value pair of the given key if it is in the PMAMap.
+//Returns true if a pair was removed.
+template<typename K, typename V>
+bool PMAMap<K,V>::try_erase(const K& key)
+{
+  int seg, offset;
+  if(!locate(key, seg, offset)){
+    return false;
+  }
+  remove_at(seg, offset);
+  return true;
+}
+
+//Inserts the pair into the segment. If the segment is full, the
+//smallest window under its upper density bound is redistributed with
+//the new pair, and if there is no such window the array is doubled.
+template<typename K, typename V>
+void PMAMap<K,V>::insert_at(std::pair<K,V>& entry, int seg)
+{
+  if(capacity == 0){
+    rebuild(min_segment_size, nullptr);
+  }
+  if(seg_counts[seg] < segment_size){
+    int start = seg * segment_size;
+    int index = seg_counts[seg];
+    while(index > 0 && entry.first < array[start + index - 1].first){
+      array[start + index] = std::move(array[start + index - 1]);
+      index--;
+    }
+    array[start + index] = std::move(entry);
+    seg_counts[seg]++;
+    count++;
+    return;
+  }
+  for(int level = 1; level <= height(); level++){
+    int width = 1 << level;
+    int first = (seg / width) * width;
+    if(window_count(first, width) + 1 <= upper_density(level) * width * segment_size){
+      redistribute(first, width, &entry);
+      count++;
+      return;
+    }
+  }
+  rebuild(capacity * 2, &entry);
+  count++;
+}
+
+//Removes the pair from its segment. If the segment becomes too
+//sparse, the smallest window over its lower density bound is
+//redistributed, and if there is no such window the array is halved.
+template<typename K, typename V>
+void PMAMap<K,V>::remove_at(int seg, int offset)
+{
+  int start = seg * segment_size;
+  for(int i = offset; i < seg_counts[seg] - 1; i++){
+    array[start + i] = std::move(array[start + i + 1]);
+  }
+  seg_counts[seg]--;
+  count--;
+  if(segments == 1 || seg_counts[seg] >= leaf_lower * segment_size){
+    return;
+  }
+  for(int level = 1; level <= height(); level++){
+    int width = 1 << level;
+    int first = (seg / width) * width;
+    if(window_count(first, width) >= lower_density(level) * width * segment_size){
+      redistribute(first, width, nullptr);
+      return;
+    }
+  }
+  rebuild(capacity / 2, nullptr);
+}
+
+//Returns all of the keys between or equal to the values of k1 and k2
+template<typename K, typename V>
+ArraySeq<K> PMAMap<K,V>::find_keys(const K& k1, const K& k2) const
+{
+  ArraySeq<K> keys;
+  find_keys(k1, k2, keys);
+  return keys;
+}
+
+//Adds all of the keys between or equal to the values of k1 and k2 to
+//the given sequence
+template<typename K, typename V>
+void PMAMap<K,V>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
+  if(empty()){
+    return;
+  }
+  for(int i = find_segment(k1); i < segments; i++){
+    for(int j = 0; j < seg_counts[i]; j++){
+      const K& key = array[i * segment_size + j].first;
+      if(key > k2){
+        return;
+      }
+      if(key >= k1){
+        keys.insert(key, keys.size());
+      }
+    }
+  }
+}
+
+//Returns a sorted ArraySeq of all of the keys
+template<typename K, typename V>
+ArraySeq<K> PMAMap<K,V>::sorted_keys() const
+{
+  ArraySeq<K> keys;
+  keys.reserve(count);
+  for(int i = 0; i < segments; i++){
+    for(int j = 0; j < seg_counts[i]; j++){
+      keys.push_back(array[i * segment_size + j].first);
+    }
+  }
+  return keys;
+}
+
+//Returns true if there is a key larger than the input key and
+//updates the next_key parameter. Returns false if not
+template<typename K, typename V>
+bool PMAMap<K,V>::next_key(const K& key, K& next_key) const
+{
+  if(empty()){
+    return false;
+  }
+  for(int i = find_segment(key); i < segments; i++){
+    for(int j = 0; j < seg_counts[i]; j++){
+      if(key < array[i * segment_size + j].first){
+        next_key = array[i * segment_size + j].first;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+//Returns true if there is a key smaller than the input key and
+//updates the prev_key parameter. Returns false if not
+template<typename K, typename V>
+bool PMAMap<K,V>::prev_key(const K& key, K& prev_key) const
+{
+  if(empty()){
+    return false;
+  }
+  for(int i = find_segment(key); i >= 0; i--){
+    for(int j = seg_counts[i] - 1; j >= 0; j--){
+      if(array[i * segment_size + j].first < key){
+        prev_key = array[i * segment_size + j].first;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+//Clears the current PMAMap and releases the array
+template<typename K, typename V>
+void PMAMap<K,V>::clear()
+{
+  delete [] array;
+  delete [] seg_counts;
+  array = nullptr;
+  seg_counts = nullptr;
+  count = 0;
+  capacity = 0;
+  segment_size = min_segment_size;
+  segments = 0;
+}
+
+//Binary searches the first key of each segment. Every segment is
+//non-empty when there is more than one, so only an empty map needs a
+//special case.
+template<typename K, typename V>
+int PMAMap<K,V>::find_segment(const K& key) const
+{
+  if(empty()){
+    return 0;
+  }
+  int start = 0;
+  int end = segments - 1;
+  int seg = 0;
+  while(start <= end){
+    int mid = (start + end) / 2;
+    if(array[mid * segment_size].first <= key){
+      seg = mid;
+      start = mid + 1;
+    } else {
+      end = mid - 1;
+    }
+  }
+  return seg;
+}
+
+//Returns true if the given key is contained in the map and updates
+//seg and offset with its location. Returns false if not, with seg set
+//to the segment the key would be inserted into.
+template<typename K, typename V>
+bool PMAMap<K,V>::locate(const K& key, int& seg, int& offset) const
+{
+  seg = find_segment(key);
+  if(empty()){
+    return false;
+  }
+  int start = 0;
+  int end = seg_counts[seg] - 1;
+  while(start <= end){
+    int mid = (start + end) / 2;
+    const K& mid_key = array[seg * segment_size + mid].first;
+    if(key == mid_key){
+      offset = mid;
+      return true;
+    } else if(key < mid_key){
+      end = mid - 1;
+    } else {
+      start = mid + 1;
+    }
+  }
+  return false;
+}
+
+//Returns log base 2 of the number of segments
+template<typename K, typename V>
+int PMAMap<K,V>::height() const
+{
+  int h = 0;
+  while((1 << h) < segments){
+    h++;
+  }
+  return h;
+}
+
+//Returns the upper density bound of a window at the given level
+template<typename K, typename V>
+double PMAMap<K,V>::upper_density(int level) const
+{
+  int h = height();
+  if(h == 0){
+    return leaf_upper;
+  }
+  return leaf_upper - (leaf_upper - root_upper) * level / h;
+}
+
+//Returns the lower density bound of a window at the given level
+template<typename K, typename V>
+double PMAMap<K,V>::lower_density(int level) const
+{
+  int h = height();
+  if(h == 0){
+    return leaf_lower;
+  }
+  return leaf_lower + (root_lower - leaf_lower) * level / h;
+}
+
+//Returns the number of pairs in the segments [first, first + width)
+template<typename K, typename V>
+int PMAMap<K,V>::window_count(int first, int width) const
+{
+  int n = 0;
+  for(int i = first; i < first + width; i++){
+    n += seg_counts[i];
+  }
+  return n;
+}
+
+//Moves the pairs of the window (and extra) into temp in sorted order
+template<typename K, typename V>
+void PMAMap<K,V>::gather(int first, int width, std::pair<K,V>* extra, std::pair<K,V>* temp)
+{
+  int index = 0;
+  bool placed = extra == nullptr;
+  for(int i = first; i < first + width; i++){
+    for(int j = 0; j < seg_counts[i]; j++){
+      std::pair<K,V>& elem = array[i * segment_size + j];
+      if(!placed && extra -> first < elem.first){
+        temp[index++] = std::move(*extra);
+        placed = true;
+      }
+      temp[index++] = std::move(elem);
+    }
+  }
+  if(!placed){
+    temp[index++] = std::move(*extra);
+  }
+}
+
+//Gathers the pairs of the window (and extra) into a temporary array
+//and spreads them back out evenly
+template<typename K, typename V>
+void PMAMap<K,V>::redistribute(int first, int width, std::pair<K,V>* extra)
+{
+  int n = window_count(first, width) + (extra ? 1 : 0);
+  std::pair<K,V>* temp = new std::pair<K,V>[n];
+  gather(first, width, extra, temp);
+  spread(first, width, temp, n);
+  delete [] temp;
+}
+
+//Gives each segment of the window n / width pairs, with the first n %
+//width segments taking one more
+template<typename K, typename V>
+void PMAMap<K,V>::spread(int first, int width, std::pair<K,V>* temp, int n)
+{
+  int base = n / width;
+  int remainder = n % width;
+  int index = 0;
+  for(int i = 0; i < width; i++){
+    int amount = base + (i < remainder ? 1 : 0);
+    for(int j = 0; j < amount; j++){
+      array[(first + i) * segment_size + j] = std::move(temp[index++]);
+    }
+    seg_counts[first + i] = amount;
+  }
+}
+
+//Reallocates the array with the new capacity. The segment size grows
+//with log base 2 of the capacity so the number of segments and
+//window sizes stay balanced.
+template<typename K, typename V>
+void PMAMap<K,V>::rebuild(int new_capacity, std::pair<K,V>* extra)
+{
+  if(new_capacity < min_segment_size){
+    new_capacity = min_segment_size;
+  }
+  int n = count + (extra ? 1 : 0);
+  std::pair<K,V>* temp = new std::pair<K,V>[n];
+  gather(0, segments, extra, temp);
+  delete [] array;
+  delete [] seg_counts;
+  int log_capacity = 0;
+  while((1 << log_capacity) < new_capacity){
+    log_capacity++;
+  }
+  segment_size = min_segment_size;
+  while(segment_size < log_capacity){
+    segment_size *= 2;
+  }
+  capacity = new_capacity;
+  segments = capacity / segment_size;
+  array = new std::pair<K,V>[capacity];
+  seg_counts = new int[segments];
+  spread(0, segments, temp, n);
+  delete [] temp;
+}
+
+#endif
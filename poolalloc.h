@@ -0,0 +1,259 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: poolalloc.h
+// DATE: Spring 2022
+// DESC: Node allocators for the linked maps (AVLMap, BSTMap and
+//       HashMap), passed as their Alloc template parameter.
+//       HeapAlloc is the default and gives each node its own new and
+//       delete. PoolAlloc carves nodes out of large slabs and keeps
+//       freed nodes on a free list, so inserts and erases rarely reach
+//       the heap, nodes allocated together sit together in memory,
+//       and a map can drop all of its nodes by freeing the slabs.
+//---------------------------------------------------------------------------
+
+#ifndef POOLALLOC_H
+#define POOLALLOC_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+
+//----------------------------------------------------------------------
+// Allocates every node with new and frees it with delete
+//----------------------------------------------------------------------
+template<typename T>
+class HeapAlloc
+{
+public:
+
+  // true if release() frees every node at once
+  static const bool bulk = false;
+
+  // Returns a new node constructed from the given arguments
+  template<typename... Args>
+  T* create(Args&&... args) { return new T(std::forward<Args>(args)...); }
+
+  // Destroys and frees a node made by create()
+  void destroy(T* node) { delete node; }
+
+  // Nodes are freed one at a time, so there is nothing to release
+  void release() {}
+
+};
+
+
+//----------------------------------------------------------------------
+// Allocates nodes from slabs with a free list of destroyed nodes. Each
+// PoolAlloc<T> hands out one node size, so every map gets a free list
+// per node type. Copies start out empty, since each map owns its own
+// nodes.
+//----------------------------------------------------------------------
+template<typename T>
+class PoolAlloc
+{
+public:
+
+  // true if release() frees every node at once
+  static const bool bulk = true;
+
+  // Default constructor
+  PoolAlloc();
+
+  // Copy constructor (the copy gets its own, empty pool)
+  PoolAlloc(const PoolAlloc& rhs);
+
+  // Move constructor
+  PoolAlloc(PoolAlloc&& rhs);
+
+  // Copy assignment operator (keeps this pool)
+  PoolAlloc& operator=(const PoolAlloc& rhs);
+
+  // Move assignment operator
+  PoolAlloc& operator=(PoolAlloc&& rhs);
+
+  // Destructor
+  ~PoolAlloc();
+
+  // Returns a new node constructed in place from the given arguments
+  template<typename... Args>
+  T* create(Args&&... args);
+
+  // Destroys a node made by create() and puts it on the free list
+  void destroy(T* node);
+
+  // Frees every slab in O(slabs). Nodes still in use are not
+  // destroyed, so this is only for nodes that are already destroyed
+  // or trivially destructible.
+  void release();
+
+  // Returns the number of slabs held
+  int slab_count() const;
+
+private:
+
+  // slabs come from plain operator new, which only aligns to
+  // max_align_t
+  static_assert(alignof(T) <= alignof(std::max_align_t),
+                "PoolAlloc does not support over-aligned node types");
+
+  // a node's storage, or the link to the next free slot
+  union Slot {
+    Slot* next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  // slab sizing: the first slab holds first_slab slots and each slab
+  // doubles up to max_slab
+  static const int first_slab = 32;
+  static const int max_slab = 4096;
+
+  // slots destroyed since the last release
+  Slot* free_list = nullptr;
+
+  // most recent slab. The first slot of each slab links to the slab
+  // before it, the rest hold nodes.
+  Slot* slabs = nullptr;
+
+  // the never used slots of the current slab, [bump, bump_end)
+  Slot* bump = nullptr;
+  Slot* bump_end = nullptr;
+
+  // size of the next slab
+  int next_slab = first_slab;
+
+  // number of slabs
+  int slab_total = 0;
+
+  // allocates a new slab and makes it current
+  void grow();
+
+};
+
+
+//Post: Initializes an empty pool.
+template<typename T>
+PoolAlloc<T>::PoolAlloc()
+{
+}
+
+//Post: Initializes an empty pool, the nodes of rhs stay with rhs.
+template<typename T>
+PoolAlloc<T>::PoolAlloc(const PoolAlloc&)
+{
+}
+
+//Post: Initializes the move constructor.
+template<typename T>
+PoolAlloc<T>::PoolAlloc(PoolAlloc&& rhs)
+{
+  *this = std::move(rhs);
+}
+
+//Post: Keeps this pool, the nodes of rhs stay with rhs.
+template<typename T>
+PoolAlloc<T>& PoolAlloc<T>::operator=(const PoolAlloc&)
+{
+  return *this;
+}
+
+//Post: Frees this pool's slabs and takes the slabs of rhs, leaving
+//rhs empty.
+template<typename T>
+PoolAlloc<T>& PoolAlloc<T>::operator=(PoolAlloc&& rhs)
+{
+  if(this != &rhs){
+    release();
+    free_list = rhs.free_list;
+    slabs = rhs.slabs;
+    bump = rhs.bump;
+    bump_end = rhs.bump_end;
+    next_slab = rhs.next_slab;
+    slab_total = rhs.slab_total;
+    rhs.free_list = nullptr;
+    rhs.slabs = nullptr;
+    rhs.bump = nullptr;
+    rhs.bump_end = nullptr;
+    rhs.next_slab = first_slab;
+    rhs.slab_total = 0;
+  }
+  return *this;
+}
+
+//Post: Frees the slabs.
+template<typename T>
+PoolAlloc<T>::~PoolAlloc()
+{
+  release();
+}
+
+//Post: Reuses a free slot if there is one, otherwise takes the next
+//unused slot of the current slab (growing if it is full).
+template<typename T>
+template<typename... Args>
+T* PoolAlloc<T>::create(Args&&... args)
+{
+  Slot* slot;
+  if(free_list){
+    slot = free_list;
+    free_list = free_list -> next;
+  } else {
+    if(bump == bump_end){
+      grow();
+    }
+    slot = bump++;
+  }
+  return new (slot -> storage) T(std::forward<Args>(args)...);
+}
+
+//Post: Destroys the node and pushes its slot on the free list.
+template<typename T>
+void PoolAlloc<T>::destroy(T* node)
+{
+  node -> ~T();
+  Slot* slot = reinterpret_cast<Slot*>(node);
+  slot -> next = free_list;
+  free_list = slot;
+}
+
+//Post: Frees every slab and resets the pool to empty.
+template<typename T>
+void PoolAlloc<T>::release()
+{
+  while(slabs){
+    Slot* prev = slabs -> next;
+    ::operator delete(slabs);
+    slabs = prev;
+  }
+  free_list = nullptr;
+  bump = nullptr;
+  bump_end = nullptr;
+  next_slab = first_slab;
+  slab_total = 0;
+}
+
+//Post: Returns the number of slabs.
+template<typename T>
+int PoolAlloc<T>::slab_count() const
+{
+  return slab_total;
+}
+
+//Post: Allocates a slab of next_slab slots, links it in front of the
+//others and doubles next_slab (up to max_slab).
+template<typename T>
+void PoolAlloc<T>::grow()
+{
+  Slot* slab = static_cast<Slot*>(::operator new(sizeof(Slot) * next_slab));
+  slab -> next = slabs;
+  slabs = slab;
+  bump = slab + 1;
+  bump_end = slab + next_slab;
+  if(next_slab < max_slab){
+    next_slab *= 2;
+  }
+  slab_total++;
+}
+
+
+#endif
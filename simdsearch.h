@@ -0,0 +1,121 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: simdsearch.h
+// DATE: Spring 2022
+// DESC: Linear search kernel over a contiguous array of keys. For 32
+//       and 64 bit integral keys the compares are vectorized (AVX2
+//       when compiled with -mavx2, otherwise SSE2), and all other key
+//       types fall back to a scalar loop. Meant for small unsorted key
+//       arrays such as the ArrayMap keys or the keys of a multi-key
+//       tree node. The hw9_test_avx2 and micro_perf_avx2 targets build
+//       the AVX2 path.
+//---------------------------------------------------------------------------
+
+#ifndef SIMDSEARCH_H
+#define SIMDSEARCH_H
+
+#include <type_traits>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+//----------------------------------------------------------------------
+// Returns the index of the first key in keys[0..n) equal to the given
+// key, or -1 if there is no such key.
+//----------------------------------------------------------------------
+template<typename K>
+int linear_search(const K* keys, int n, const K& key);
+
+
+//Scalar version used for all key types
+template<typename K>
+int scalar_search(const K* keys, int n, const K& key)
+{
+  for(int i = 0; i < n; i++){
+    if(keys[i] == key){
+      return i;
+    }
+  }
+  return -1;
+}
+
+//Compares 8 (AVX2) or 4 (SSE2) 32-bit keys at a time, the tail is
+//checked with the scalar loop. K is the caller's own 32-bit integral
+//type: the vector loads may alias any type, and the tail reads the
+//keys as K, so nothing is read through a pointer of another type.
+template<typename K>
+int simd_search32(const K* keys, int n, K key)
+{
+  int i = 0;
+#if defined(__AVX2__)
+  __m256i target = _mm256_set1_epi32((int32_t) key);
+  for(; i + 8 <= n; i += 8){
+    __m256i block = _mm256_loadu_si256((const __m256i*) (keys + i));
+    int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi32(block, target));
+    if(mask != 0){
+      return i + __builtin_ctz(mask) / 4;
+    }
+  }
+#elif defined(__SSE2__)
+  __m128i target = _mm_set1_epi32((int32_t) key);
+  for(; i + 4 <= n; i += 4){
+    __m128i block = _mm_loadu_si128((const __m128i*) (keys + i));
+    int mask = _mm_movemask_epi8(_mm_cmpeq_epi32(block, target));
+    if(mask != 0){
+      return i + __builtin_ctz(mask) / 4;
+    }
+  }
+#endif
+  int index = scalar_search(keys + i, n - i, key);
+  return index == -1 ? -1 : i + index;
+}
+
+//Compares 4 (AVX2) or 2 (SSE2) 64-bit keys at a time. SSE2 has no
+//64-bit compare, so both 32-bit halves must match. K is the caller's
+//own 64-bit integral type, as for simd_search32.
+template<typename K>
+int simd_search64(const K* keys, int n, K key)
+{
+  int i = 0;
+#if defined(__AVX2__)
+  __m256i target = _mm256_set1_epi64x((int64_t) key);
+  for(; i + 4 <= n; i += 4){
+    __m256i block = _mm256_loadu_si256((const __m256i*) (keys + i));
+    int mask = _mm256_movemask_epi8(_mm256_cmpeq_epi64(block, target));
+    if(mask != 0){
+      return i + __builtin_ctz(mask) / 8;
+    }
+  }
+#elif defined(__SSE2__)
+  __m128i target = _mm_set1_epi64x((int64_t) key);
+  for(; i + 2 <= n; i += 2){
+    __m128i block = _mm_loadu_si128((const __m128i*) (keys + i));
+    __m128i halves = _mm_cmpeq_epi32(block, target);
+    halves = _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+    int mask = _mm_movemask_epi8(halves);
+    if(mask != 0){
+      return i + __builtin_ctz(mask) / 8;
+    }
+  }
+#endif
+  int index = scalar_search(keys + i, n - i, key);
+  return index == -1 ? -1 : i + index;
+}
+
+//Picks the vectorized kernel for 32 and 64 bit integral keys
+template<typename K>
+int linear_search(const K* keys, int n, const K& key)
+{
+  if constexpr (std::is_integral<K>::value && sizeof(K) == 4){
+    return simd_search32(keys, n, key);
+  } else if constexpr (std::is_integral<K>::value && sizeof(K) == 8){
+    return simd_search64(keys, n, key);
+  } else {
+    return scalar_search(keys, n, key);
+  }
+}
+
+#endif
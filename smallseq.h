@@ -0,0 +1,439 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: smallseq.h
+// DATE: Spring 2022
+// DESC: Small-buffer implementation of the sequence interface. The
+//       first N elements are stored inside the object itself, and the
+//       sequence only moves to a heap array once it grows past N. Meant
+//       for short-lived results such as small find_keys ranges, where
+//       an ArraySeq would allocate (and regrow) several times.
+//---------------------------------------------------------------------------
+
+#ifndef SMALLSEQ_H
+#define SMALLSEQ_H
+
+#include <stdexcept>
+#include <ostream>
+#include <new>
+#include <utility>
+#include "sequence.h"
+
+
+template<typename T, int N = 16>
+class SmallSeq : public Sequence<T>
+{
+public:
+
+  // Default constructor
+  SmallSeq();
+
+  // Copy constructor
+  SmallSeq(const SmallSeq& rhs);
+
+  // Move constructor
+  SmallSeq(SmallSeq&& rhs);
+
+  // Copy assignment operator
+  SmallSeq& operator=(const SmallSeq& rhs);
+
+  // Move assignment operator
+  SmallSeq& operator=(SmallSeq&& rhs);
+
+  // Destructor
+  ~SmallSeq();
+
+  // Returns the number of elements in the sequence
+  int size() const;
+
+  // Tests if the sequence is empty
+  bool empty() const;
+
+  // Removes all of the elements from the sequence and goes back to
+  // the inline storage
+  void clear();
+
+  // Returns a reference to the element at the index in the
+  // sequence. Throws out_of_range if index is invalid (less than 0 or
+  // greater than or equal to size()).
+  T& operator[](int index);
+
+  // Returns a constant address to the element at the index in the
+  // sequence. Throws out_of_range if index is invalid (less than 0 or
+  // greater than or equal to size()).
+  const T& operator[](int index) const;
+
+  // Extends the sequence by inserting the element at the given index.
+  // Throws out_of_range if the index is invalid (less than 0 or
+  // greater than size()).
+  void insert(const T& elem, int index);
+
+  // Adds the element to the end of the sequence
+  void push_back(const T& elem);
+
+  // Moves the element onto the end of the sequence
+  void push_back(T&& elem);
+
+  // Constructs an element in place at the end of the sequence from
+  // the given arguments
+  template<typename... Args>
+  void emplace_back(Args&&... args);
+
+  // Shrinks the sequence by removing the element at the index in the
+  // sequence. Throws out_of_range if index is invalid.
+  void erase(int index);
+
+  // Returns true if the element is in the sequence, and false
+  // otherwise.
+  bool contains(const T& elem) const;
+
+  // Sorts the elements in the sequence in place (heap sort, so no
+  // extra storage is needed)
+  void sort();
+
+  // Returns the number of elements the sequence can hold before
+  // growing again
+  int capacity() const;
+
+  // Returns true if the elements have been moved to the heap
+  bool spilled() const;
+
+  // Returns a pointer to the first element, the inline buffer or the
+  // heap array. Invalidated when the sequence grows past its capacity.
+  T* data();
+  const T* data() const;
+
+private:
+
+  // inline storage for the first N elements
+  alignas(T) unsigned char buffer[N * sizeof(T)];
+
+  // the elements, either the inline buffer or a heap array
+  T* array;
+
+  // number of elements
+  int count = 0;
+
+  // number of elements array can hold
+  int max_count = N;
+
+  // returns the inline buffer as an array of T
+  T* inline_array();
+
+  // moves the elements into a heap array of twice the capacity
+  void resize();
+
+  // moves the elements of rhs into this (empty) sequence
+  void take(SmallSeq& rhs);
+
+  // sift down helper for the heap sort
+  void sift_down(int index, int n);
+
+};
+
+
+template<typename T, int N>
+std::ostream& operator<<(std::ostream& stream, const SmallSeq<T,N>& seq)
+{
+  int n = seq.size();
+  for (int i = 0; i < n - 1; ++i)
+    stream << seq[i] << ", ";
+  if (n > 0)
+    stream << seq[n - 1];
+  return stream;
+}
+
+
+template<typename T, int N>
+SmallSeq<T,N>::SmallSeq()
+  : array(inline_array())
+{
+}
+
+//Post: Initializes the copy constructor.
+template<typename T, int N>
+SmallSeq<T,N>::SmallSeq(const SmallSeq& rhs)
+  : array(inline_array())
+{
+  *this = rhs;
+}
+
+//Post: Initializes the move constructor.
+template<typename T, int N>
+SmallSeq<T,N>::SmallSeq(SmallSeq&& rhs)
+  : array(inline_array())
+{
+  take(rhs);
+}
+
+//Post: Initializes the copy assignment.
+template<typename T, int N>
+SmallSeq<T,N>& SmallSeq<T,N>::operator=(const SmallSeq& rhs)
+{
+  if(this != &rhs){
+    clear();
+    for(int i = 0; i < rhs.count; i++){
+      push_back(rhs.array[i]);
+    }
+  }
+  return *this;
+}
+
+//Post: Initializes the move assignment.
+template<typename T, int N>
+SmallSeq<T,N>& SmallSeq<T,N>::operator=(SmallSeq&& rhs)
+{
+  if(this != &rhs){
+    clear();
+    take(rhs);
+  }
+  return *this;
+}
+
+//Post: Initalizes the deconstructor.
+template<typename T, int N>
+SmallSeq<T,N>::~SmallSeq()
+{
+  clear();
+}
+
+//Post: Returns the current size.
+template<typename T, int N>
+int SmallSeq<T,N>::size() const
+{
+  return count;
+}
+
+//Post: Returns true if the sequence is empty, false if not.
+template<typename T, int N>
+bool SmallSeq<T,N>::empty() const
+{
+  return count == 0;
+}
+
+//Post: Destroys the elements and frees the heap array, if any.
+template<typename T, int N>
+void SmallSeq<T,N>::clear()
+{
+  for(int i = 0; i < count; i++){
+    array[i].~T();
+  }
+  if(spilled()){
+    ::operator delete(array);
+  }
+  array = inline_array();
+  max_count = N;
+  count = 0;
+}
+
+//Post: Overrides the access operator.
+template<typename T, int N>
+T& SmallSeq<T,N>::operator[](int index)
+{
+  if(index < 0 || index >= count){
+    throw std::out_of_range("Out of Range in SmallSeq Operator");
+  }
+  return array[index];
+}
+
+//Post: Overrides the update operator.
+template<typename T, int N>
+const T& SmallSeq<T,N>::operator[](int index) const
+{
+  if(index < 0 || index >= count){
+    throw std::out_of_range("Out of Range in SmallSeq Operator");
+  }
+  return array[index];
+}
+
+//Pre: Index must be in range. Must be greater or equal to
+//0 and less than or equal to count.
+//Post: Inserts a copy of the given value at the given index. The copy
+//is made first since elem may be an element of this sequence.
+template<typename T, int N>
+void SmallSeq<T,N>::insert(const T& elem, int index)
+{
+  if(index < 0 || index > count){
+    throw std::out_of_range("Out of Range in Insert");
+  }
+  T value(elem);
+  if(count == max_count){
+    resize();
+  }
+  if(index == count){
+    new (array + count) T(std::move(value));
+  } else {
+    new (array + count) T(std::move(array[count - 1]));
+    for(int i = count - 1; i > index; i--){
+      array[i] = std::move(array[i - 1]);
+    }
+    array[index] = std::move(value);
+  }
+  count++;
+}
+
+//Post: Adds a copy of the given value to the end of the sequence.
+template<typename T, int N>
+void SmallSeq<T,N>::push_back(const T& elem)
+{
+  insert(elem, count);
+}
+
+//Post: Moves the given value onto the end of the sequence.
+template<typename T, int N>
+void SmallSeq<T,N>::push_back(T&& elem)
+{
+  emplace_back(std::move(elem));
+}
+
+//Post: Constructs a value from args at the end of the sequence. The
+//value is built before growing since args may refer to elements of
+//this sequence.
+template<typename T, int N>
+template<typename... Args>
+void SmallSeq<T,N>::emplace_back(Args&&... args)
+{
+  if(count == max_count){
+    T value(std::forward<Args>(args)...);
+    resize();
+    new (array + count) T(std::move(value));
+  } else {
+    new (array + count) T(std::forward<Args>(args)...);
+  }
+  count++;
+}
+
+//Pre: Index must be in range. Must be greater or equal to
+//0 and less than count.
+//Post: Removes the element at the given index.
+template<typename T, int N>
+void SmallSeq<T,N>::erase(int index)
+{
+  if(index < 0 || index >= count){
+    throw std::out_of_range("Out of Range in Erase");
+  }
+  for(int i = index; i < count - 1; i++){
+    array[i] = std::move(array[i + 1]);
+  }
+  array[count - 1].~T();
+  count--;
+}
+
+//Post: Returns true if the given element is in the sequence, false if
+//not.
+template<typename T, int N>
+bool SmallSeq<T,N>::contains(const T& elem) const
+{
+  for(int i = 0; i < count; i++){
+    if(array[i] == elem){
+      return true;
+    }
+  }
+  return false;
+}
+
+//Post: Sorts the sequence in place using heap sort.
+template<typename T, int N>
+void SmallSeq<T,N>::sort()
+{
+  for(int i = count / 2 - 1; i >= 0; i--){
+    sift_down(i, count);
+  }
+  for(int n = count - 1; n > 0; n--){
+    std::swap(array[0], array[n]);
+    sift_down(0, n);
+  }
+}
+
+//Post: Returns the current capacity.
+template<typename T, int N>
+int SmallSeq<T,N>::capacity() const
+{
+  return max_count;
+}
+
+//Post: Returns true if the elements are in a heap array.
+template<typename T, int N>
+bool SmallSeq<T,N>::spilled() const
+{
+  return array != reinterpret_cast<const T*>(buffer);
+}
+
+//Post: Returns the elements.
+template<typename T, int N>
+T* SmallSeq<T,N>::data()
+{
+  return array;
+}
+
+//Post: Returns the elements as constants.
+template<typename T, int N>
+const T* SmallSeq<T,N>::data() const
+{
+  return array;
+}
+
+//Post: Returns the inline buffer.
+template<typename T, int N>
+T* SmallSeq<T,N>::inline_array()
+{
+  return reinterpret_cast<T*>(buffer);
+}
+
+//Post: Moves the elements into a heap array of twice the capacity.
+template<typename T, int N>
+void SmallSeq<T,N>::resize()
+{
+  T* new_array = static_cast<T*>(::operator new(sizeof(T) * max_count * 2));
+  for(int i = 0; i < count; i++){
+    new (new_array + i) T(std::move(array[i]));
+    array[i].~T();
+  }
+  if(spilled()){
+    ::operator delete(array);
+  }
+  array = new_array;
+  max_count *= 2;
+}
+
+//Pre: This sequence is empty and inline.
+//Post: Takes the heap array of rhs, or moves its inline elements over
+//one at a time. Leaves rhs empty.
+template<typename T, int N>
+void SmallSeq<T,N>::take(SmallSeq& rhs)
+{
+  if(rhs.spilled()){
+    array = rhs.array;
+    max_count = rhs.max_count;
+    count = rhs.count;
+    rhs.array = rhs.inline_array();
+    rhs.max_count = N;
+    rhs.count = 0;
+  } else {
+    for(int i = 0; i < rhs.count; i++){
+      new (array + i) T(std::move(rhs.array[i]));
+    }
+    count = rhs.count;
+    rhs.clear();
+  }
+}
+
+//Post: Moves the element at index down the max heap of the first n
+//elements until it is no smaller than its children.
+template<typename T, int N>
+void SmallSeq<T,N>::sift_down(int index, int n)
+{
+  while(2 * index + 1 < n){
+    int child = 2 * index + 1;
+    if(child + 1 < n && array[child] < array[child + 1]){
+      child++;
+    }
+    if(!(array[index] < array[child])){
+      return;
+    }
+    std::swap(array[index], array[child]);
+    index = child;
+  }
+}
+
+
+#endif
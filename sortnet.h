@@ -0,0 +1,234 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: sortnet.h
+// DATE: Spring 2022
+// DESC: Sorting network kernels for small blocks of signed 32 and 64
+//       bit integers. Blocks of up to 64 keys are padded to 8, 16, 32
+//       or 64 keys and sorted with a bitonic network, vectorized with
+//       AVX2 when compiled with -mavx2 and a branchless scalar network
+//       otherwise. Meant for the small ranges at the leaves of the
+//       ArraySeq sorts, where the network has no data dependent
+//       branches to mispredict.
+//---------------------------------------------------------------------------
+
+#ifndef SORTNET_H
+#define SORTNET_H
+
+#include <type_traits>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+// largest block the networks sort
+const int network_max = 64;
+
+// largest range a sort should hand to network_sort instead of its own
+// small range code. The AVX2 network beats insertion sort up to the
+// full 64 keys, the scalar one only on the smallest blocks.
+#if defined(__AVX2__)
+const int network_leaf = network_max;
+#else
+const int network_leaf = 8;
+#endif
+
+// Says whether network_sort can sort keys of type T: signed 32 and 64
+// bit integral types
+template<typename T>
+struct SortNetwork
+{
+  static const bool value = std::is_integral<T>::value && std::is_signed<T>::value &&
+                            (sizeof(T) == 4 || sizeof(T) == 8);
+};
+
+
+//----------------------------------------------------------------------
+// Sorts keys[0..n) in ascending order.
+// Pre: n <= network_max and SortNetwork<T>::value is true.
+//----------------------------------------------------------------------
+template<typename T>
+void network_sort(T* keys, int n);
+
+
+//Returns the smallest network size (8, 16, 32 or 64) that holds n keys
+inline int network_size(int n)
+{
+  int size = 8;
+  while(size < n){
+    size *= 2;
+  }
+  return size;
+}
+
+//Scalar bitonic network over keys[0..size), size a power of 2. Each
+//compare-exchange is a min and a max, which compile to conditional
+//moves rather than branches.
+template<typename K>
+void scalar_network(K* keys, int size)
+{
+  for(int k = 2; k <= size; k *= 2){
+    for(int j = k / 2; j > 0; j /= 2){
+      for(int i = 0; i < size; i++){
+        int l = i ^ j;
+        if(l > i){
+          K a = keys[i];
+          K b = keys[l];
+          K lo = a < b ? a : b;
+          K hi = a < b ? b : a;
+          bool ascending = (i & k) == 0;
+          keys[i] = ascending ? lo : hi;
+          keys[l] = ascending ? hi : lo;
+        }
+      }
+    }
+  }
+}
+
+#if defined(__AVX2__)
+
+//Returns the lanes of a bitonic step (stride j, block k) that keep the
+//minimum of the pair: lanes in the lower half of a pair in an
+//ascending block, and lanes in the upper half in a descending one
+inline __m256i network_min_lanes32(__m256i index, int j, int k)
+{
+  __m256i zero = _mm256_setzero_si256();
+  __m256i lower = _mm256_cmpeq_epi32(_mm256_and_si256(index, _mm256_set1_epi32(j)), zero);
+  __m256i ascending = _mm256_cmpeq_epi32(_mm256_and_si256(index, _mm256_set1_epi32(k)), zero);
+  return _mm256_cmpeq_epi32(lower, ascending);
+}
+
+inline __m256i network_min_lanes64(__m256i index, int j, int k)
+{
+  __m256i zero = _mm256_setzero_si256();
+  __m256i lower = _mm256_cmpeq_epi64(_mm256_and_si256(index, _mm256_set1_epi64x(j)), zero);
+  __m256i ascending = _mm256_cmpeq_epi64(_mm256_and_si256(index, _mm256_set1_epi64x(k)), zero);
+  return _mm256_cmpeq_epi64(lower, ascending);
+}
+
+//Bitonic network over keys[0..size) with 8 keys per register. Strides
+//of 8 or more compare whole registers, smaller strides compare each
+//register against a shuffled copy of itself.
+inline void avx2_network32(int32_t* keys, int size)
+{
+  __m256i v[network_max / 8];
+  int regs = size / 8;
+  for(int r = 0; r < regs; r++){
+    v[r] = _mm256_loadu_si256((const __m256i*) (keys + 8 * r));
+  }
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for(int k = 2; k <= size; k *= 2){
+    for(int j = k / 2; j > 0; j /= 2){
+      if(j >= 8){
+        for(int r = 0; r < regs; r++){
+          int partner = r ^ (j / 8);
+          if(partner > r){
+            __m256i lo = _mm256_min_epi32(v[r], v[partner]);
+            __m256i hi = _mm256_max_epi32(v[r], v[partner]);
+            bool ascending = ((8 * r) & k) == 0;
+            v[r] = ascending ? lo : hi;
+            v[partner] = ascending ? hi : lo;
+          }
+        }
+      } else {
+        for(int r = 0; r < regs; r++){
+          __m256i swapped;
+          if(j == 4){
+            swapped = _mm256_permute2x128_si256(v[r], v[r], 0x01);
+          } else if(j == 2){
+            swapped = _mm256_shuffle_epi32(v[r], _MM_SHUFFLE(1, 0, 3, 2));
+          } else {
+            swapped = _mm256_shuffle_epi32(v[r], _MM_SHUFFLE(2, 3, 0, 1));
+          }
+          __m256i lo = _mm256_min_epi32(v[r], swapped);
+          __m256i hi = _mm256_max_epi32(v[r], swapped);
+          __m256i index = _mm256_add_epi32(lanes, _mm256_set1_epi32(8 * r));
+          v[r] = _mm256_blendv_epi8(hi, lo, network_min_lanes32(index, j, k));
+        }
+      }
+    }
+  }
+  for(int r = 0; r < regs; r++){
+    _mm256_storeu_si256((__m256i*) (keys + 8 * r), v[r]);
+  }
+}
+
+//Same network with 4 keys per register. AVX2 has no 64-bit min or
+//max, so both come from one compare and two blends.
+inline void avx2_network64(int64_t* keys, int size)
+{
+  __m256i v[network_max / 4];
+  int regs = size / 4;
+  for(int r = 0; r < regs; r++){
+    v[r] = _mm256_loadu_si256((const __m256i*) (keys + 4 * r));
+  }
+  const __m256i lanes = _mm256_setr_epi64x(0, 1, 2, 3);
+  for(int k = 2; k <= size; k *= 2){
+    for(int j = k / 2; j > 0; j /= 2){
+      if(j >= 4){
+        for(int r = 0; r < regs; r++){
+          int partner = r ^ (j / 4);
+          if(partner > r){
+            __m256i greater = _mm256_cmpgt_epi64(v[r], v[partner]);
+            __m256i lo = _mm256_blendv_epi8(v[r], v[partner], greater);
+            __m256i hi = _mm256_blendv_epi8(v[partner], v[r], greater);
+            bool ascending = ((4 * r) & k) == 0;
+            v[r] = ascending ? lo : hi;
+            v[partner] = ascending ? hi : lo;
+          }
+        }
+      } else {
+        for(int r = 0; r < regs; r++){
+          __m256i swapped;
+          if(j == 2){
+            swapped = _mm256_permute4x64_epi64(v[r], _MM_SHUFFLE(1, 0, 3, 2));
+          } else {
+            swapped = _mm256_permute4x64_epi64(v[r], _MM_SHUFFLE(2, 3, 0, 1));
+          }
+          __m256i greater = _mm256_cmpgt_epi64(v[r], swapped);
+          __m256i lo = _mm256_blendv_epi8(v[r], swapped, greater);
+          __m256i hi = _mm256_blendv_epi8(swapped, v[r], greater);
+          __m256i index = _mm256_add_epi64(lanes, _mm256_set1_epi64x(4 * r));
+          v[r] = _mm256_blendv_epi8(hi, lo, network_min_lanes64(index, j, k));
+        }
+      }
+    }
+  }
+  for(int r = 0; r < regs; r++){
+    _mm256_storeu_si256((__m256i*) (keys + 4 * r), v[r]);
+  }
+}
+
+#endif
+
+//Copies the keys into a block padded with the largest key, sorts the
+//block with the AVX2 or scalar network and copies the first n back
+template<typename T>
+void network_sort(T* keys, int n)
+{
+  typedef typename std::conditional<sizeof(T) == 4, int32_t, int64_t>::type K;
+  K block[network_max];
+  int size = network_size(n);
+  for(int i = 0; i < n; i++){
+    block[i] = (K) keys[i];
+  }
+  for(int i = n; i < size; i++){
+    block[i] = std::numeric_limits<K>::max();
+  }
+#if defined(__AVX2__)
+  if constexpr (sizeof(K) == 4){
+    avx2_network32(block, size);
+  } else {
+    avx2_network64(block, size);
+  }
+#else
+  scalar_network(block, size);
+#endif
+  for(int i = 0; i < n; i++){
+    keys[i] = (T) block[i];
+  }
+}
+
+#endif
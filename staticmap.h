@@ -0,0 +1,107 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: staticmap.h
+// DATE: Spring 2022
+// DESC: A statically dispatched view of the Map interface. Every
+//       concrete map is final, so a call through the concrete type
+//       (not a Map&) binds at compile time and can be inlined into a
+//       loop. is_static_map checks that a type has the Map operations
+//       as members, and the batch helpers below take any such type M.
+//       Given a concrete map they make no virtual calls; given
+//       Map<K,V> they make the same calls through the vtable.
+//---------------------------------------------------------------------------
+
+#ifndef STATICMAP_H
+#define STATICMAP_H
+
+#include <type_traits>
+#include <utility>
+
+
+//----------------------------------------------------------------------
+// True if M has the lookup and update operations of Map<K,V>: size,
+// contains, find, operator[], insert and try_erase
+//----------------------------------------------------------------------
+template<typename M, typename K, typename V, typename = void>
+struct is_static_map : std::false_type {};
+
+template<typename M, typename K, typename V>
+struct is_static_map<M, K, V, std::void_t<
+  decltype(std::declval<const M&>().size()),
+  decltype(std::declval<const M&>().contains(std::declval<const K&>())),
+  decltype(std::declval<M&>().find(std::declval<const K&>())),
+  decltype(std::declval<M&>()[std::declval<const K&>()]),
+  decltype(std::declval<M&>().insert(std::declval<const K&>(), std::declval<const V&>())),
+  decltype(std::declval<M&>().try_erase(std::declval<const K&>()))>>
+  : std::bool_constant<
+      std::is_convertible_v<decltype(std::declval<const M&>().contains(std::declval<const K&>())), bool> &&
+      std::is_same_v<decltype(std::declval<M&>().find(std::declval<const K&>())), V*>> {};
+
+#if defined(__cpp_concepts)
+template<typename M, typename K, typename V>
+concept StaticMap = is_static_map<M, K, V>::value;
+#endif
+
+
+//----------------------------------------------------------------------
+// Inserts the n pairs keys[i], vals[i]. Expects none of the keys to
+// be in the map.
+//----------------------------------------------------------------------
+template<typename M, typename K, typename V>
+void insert_all(M& m, const K* keys, const V* vals, int n)
+{
+  for(int i = 0; i < n; i++){
+    m.insert(keys[i], vals[i]);
+  }
+}
+
+
+//----------------------------------------------------------------------
+// Returns how many of the n keys are in the map
+//----------------------------------------------------------------------
+template<typename M, typename K>
+int count_contained(const M& m, const K* keys, int n)
+{
+  int found = 0;
+  for(int i = 0; i < n; i++){
+    found += m.contains(keys[i]);
+  }
+  return found;
+}
+
+
+//----------------------------------------------------------------------
+// Adds the values of the n keys that are in the map to total (which
+// can be a wider type than the values), and returns how many were
+// found
+//----------------------------------------------------------------------
+template<typename M, typename K, typename T>
+int sum_found(M& m, const K* keys, int n, T& total)
+{
+  int found = 0;
+  for(int i = 0; i < n; i++){
+    auto* value = m.find(keys[i]);
+    if(value){
+      total += *value;
+      found++;
+    }
+  }
+  return found;
+}
+
+
+//----------------------------------------------------------------------
+// Removes those of the n keys that are in the map and returns how
+// many were removed
+//----------------------------------------------------------------------
+template<typename M, typename K>
+int erase_all(M& m, const K* keys, int n)
+{
+  int erased = 0;
+  for(int i = 0; i < n; i++){
+    erased += m.try_erase(keys[i]);
+  }
+  return erased;
+}
+
+#endif
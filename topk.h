@@ -0,0 +1,199 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: topk.h
+// DATE: Spring 2022
+// DESC: Streaming top-k selection. Elements are pushed one at a time
+//       and only the k smallest (or largest) seen so far are kept, in
+//       a binary heap with the worst kept element on top. Each push is
+//       O(log k) and the memory is O(k), so it works on sources that
+//       cannot be sorted in place, such as the chains of a HashMap.
+//---------------------------------------------------------------------------
+
+#ifndef TOPK_H
+#define TOPK_H
+
+#include <stdexcept>
+#include <utility>
+#include "arrayseq.h"
+
+
+template<typename T>
+class TopK
+{
+public:
+
+  // Keeps the k smallest elements pushed, or the k largest if largest
+  // is true. Throws out_of_range if k is less than 0.
+  TopK(int k, bool largest = false);
+
+  // Offers the element, keeping it if it is one of the best k so far
+  void push(const T& elem);
+
+  // Returns the number of elements kept (at most k)
+  int size() const;
+
+  // Tests if no elements are kept
+  bool empty() const;
+
+  // Tests if k elements are kept, so a new element must beat worst()
+  bool full() const;
+
+  // Returns the worst of the kept elements, the one the next better
+  // element would replace. Throws out_of_range if empty.
+  const T& worst() const;
+
+  // Removes all of the kept elements
+  void clear();
+
+  // Returns the kept elements best first: ascending for the k
+  // smallest, descending for the k largest
+  ArraySeq<T> sorted() const;
+
+private:
+
+  // the kept elements as a heap with the worst on top
+  ArraySeq<T> heap;
+
+  // most elements kept
+  int limit;
+
+  // most elements reserved up front. k is only an upper bound on what
+  // a caller will keep, so beyond this the heap grows as it fills.
+  static const int max_reserve = 1024;
+
+  // true to keep the largest elements instead of the smallest
+  bool largest;
+
+  // returns true if a is worse than b (should be nearer the top)
+  bool worse(const T& a, const T& b) const;
+
+  // heap helpers
+  void sift_up(int index);
+  void sift_down(int index);
+
+};
+
+
+//Post: Initializes an empty top-k of the given size.
+template<typename T>
+TopK<T>::TopK(int k, bool largest)
+  : limit(k), largest(largest)
+{
+  if(k < 0){
+    throw std::out_of_range("Out of Range in TopK");
+  }
+  heap.reserve(k < max_reserve ? k : max_reserve);
+}
+
+//Post: Adds the element if fewer than k are kept, or replaces the
+//worst kept element if the new one is better.
+template<typename T>
+void TopK<T>::push(const T& elem)
+{
+  if(heap.size() < limit){
+    heap.push_back(elem);
+    sift_up(heap.size() - 1);
+  } else if(limit > 0 && worse(heap[0], elem)){
+    heap[0] = elem;
+    sift_down(0);
+  }
+}
+
+//Post: Returns the number of kept elements.
+template<typename T>
+int TopK<T>::size() const
+{
+  return heap.size();
+}
+
+//Post: Returns true if nothing is kept, false if not.
+template<typename T>
+bool TopK<T>::empty() const
+{
+  return heap.empty();
+}
+
+//Post: Returns true if k elements are kept.
+template<typename T>
+bool TopK<T>::full() const
+{
+  return heap.size() == limit;
+}
+
+//Post: Returns the top of the heap.
+template<typename T>
+const T& TopK<T>::worst() const
+{
+  if(heap.empty()){
+    throw std::out_of_range("Out of Range in TopK Worst");
+  }
+  return heap[0];
+}
+
+//Post: Removes the kept elements.
+template<typename T>
+void TopK<T>::clear()
+{
+  heap.clear();
+}
+
+//Post: Sorts a copy of the heap, reversing it for the largest.
+template<typename T>
+ArraySeq<T> TopK<T>::sorted() const
+{
+  ArraySeq<T> result = heap;
+  result.sort();
+  if(largest){
+    T* elems = result.data();
+    for(int lo = 0, hi = result.size() - 1; lo < hi; lo++, hi--){
+      std::swap(elems[lo], elems[hi]);
+    }
+  }
+  return result;
+}
+
+//Post: Returns true if a would be dropped before b.
+template<typename T>
+bool TopK<T>::worse(const T& a, const T& b) const
+{
+  return largest ? a < b : b < a;
+}
+
+//Post: Moves the element at index up while it is worse than its
+//parent.
+template<typename T>
+void TopK<T>::sift_up(int index)
+{
+  T* elems = heap.data();
+  while(index > 0){
+    int parent = (index - 1) / 2;
+    if(!worse(elems[index], elems[parent])){
+      return;
+    }
+    std::swap(elems[index], elems[parent]);
+    index = parent;
+  }
+}
+
+//Post: Moves the element at index down while one of its children is
+//worse.
+template<typename T>
+void TopK<T>::sift_down(int index)
+{
+  T* elems = heap.data();
+  int n = heap.size();
+  while(2 * index + 1 < n){
+    int child = 2 * index + 1;
+    if(child + 1 < n && worse(elems[child + 1], elems[child])){
+      child++;
+    }
+    if(!worse(elems[child], elems[index])){
+      return;
+    }
+    std::swap(elems[index], elems[child]);
+    index = child;
+  }
+}
+
+
+#endif
@@ -0,0 +1,777 @@
+//---------------------------------------------------------------------------
+// NAME: Connor Goldschmidt
+// FILE: workloadmap.h
+// DATE: Spring 2022
+// DESC: Workload-adaptive implementation of the Map interface. The map
+//       counts the point reads, range queries, and writes it sees.
+//       After each sampling window it picks the best representation
+//       for the observed mix: a sorted array (BinSearchMap) for
+//       read-only workloads with range queries, an AVLMap for
+//       range-heavy workloads with writes, and a HashMap for point
+//       workloads. A new representation is built on a background
+//       thread, which also takes the snapshot of the pairs, so the
+//       operation that starts a rebuild does not copy the map. Once
+//       it is ready the next operation, const or not, swaps it in.
+//       Several threads can read the map at once. The map a const
+//       operation swaps out is kept until the next non-const
+//       operation, so references returned by the const operator[]
+//       and find stay valid until then. References returned by the
+//       non-const operator[] and find are also valid until the next
+//       non-const operation: const operations do not swap while one
+//       may be in use, and the keys they were given for are replayed
+//       into the rebuilt map.
+//---------------------------------------------------------------------------
+
+#ifndef WORKLOADMAP_H
+#define WORKLOADMAP_H
+
+#include <future>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <utility>
+#include "map.h"
+#include "arrayseq.h"
+#include "hashmap.h"
+#include "avlmap.h"
+#include "binsearchmap.h"
+
+
+template<typename K, typename V>
+class WorkloadMap final : public Map<K,V>
+{
+public:
+
+  // the underlying representations
+  enum Representation { HASH, TREE, SORTED };
+
+  // Creates an empty map (stored as an AVLMap) that re-evaluates its
+  // representation every sample_window operations. A workload is
+  // range-heavy when at least range_threshold of its operations are
+  // range queries.
+  WorkloadMap(int sample_window = 4096, double range_threshold = 0.1);
+
+  // copy constructor
+  WorkloadMap(const WorkloadMap& rhs);
+
+  // move constructor
+  WorkloadMap(WorkloadMap&& rhs);
+
+  // copy assignment
+  WorkloadMap& operator=(const WorkloadMap& rhs);
+
+  // move assignment
+  WorkloadMap& operator=(WorkloadMap&& rhs);
+
+  // destructor
+  ~WorkloadMap();
+
+  // Returns the number of key-value pairs in the map
+  int size() const;
+
+  // Tests if the map is empty
+  bool empty() const;
+
+  // Allows values associated with a key to be updated. Throws
+  // out_of_range if the given key is not in the collection.
+  V& operator[](const K& key);
+
+  // Returns the value for a given key. Throws out_of_range if the
+  // given key is not in the collection.
+  const V& operator[](const K& key) const;
+
+  // Extends the collection by adding the given key-value pair.
+  // Expects key to not exist in map prior to insertion.
+  void insert(const K& key, const V& value);
+
+  // Extends the collection by moving the given key-value pair into
+  // it. Expects key to not exist in map prior to insertion.
+  void insert(K&& key, V&& value);
+
+  // Extends the collection with a key made from key and a value
+  // constructed in place from args. Expects key to not exist in map
+  // prior to insertion.
+  template<typename KeyArg, typename... Args>
+  void emplace(KeyArg&& key, Args&&... args);
+
+  // Shrinks the collection by removing the key-value pair with the
+  // given key. Does not modify the collection if the collection does
+  // not contain the key. Throws out_of_range if the given key is not
+  // in the collection.
+  void erase(const K& key);
+
+  // Returns true if the key is in the collection, and false otherwise.
+  bool contains(const K& key) const;
+
+  // Returns a pointer to the value for the given key, or nullptr if
+  // the key is not in the collection
+  V* find(const K& key);
+
+  // Returns a pointer to the value for the given key as a constant,
+  // or nullptr if the key is not in the collection
+  const V* find(const K& key) const;
+
+  // Sets the value for the given key, adding the key-value pair if
+  // the key is not in the collection. Returns true if the pair was
+  // added.
+  bool insert_or_assign(const K& key, const V& value);
+
+  // Adds the key-value pair only if the key is not in the
+  // collection. Returns true if the pair was added.
+  bool try_emplace(const K& key, const V& value);
+
+  // Removes the key-value pair with the given key if there is
+  // one. Returns true if a pair was removed.
+  bool try_erase(const K& key);
+
+  // Returns the keys k in the collection such that k1 <= k <= k2
+  ArraySeq<K> find_keys(const K& k1, const K& k2) const;
+
+  // Adds the keys k in the collection such that k1 <= k <= k2 to the
+  // end of the given sequence
+  void find_keys(const K& k1, const K& k2, Sequence<K>& keys) const;
+
+  // Returns the keys in the collection in ascending sorted order
+  ArraySeq<K> sorted_keys() const;
+
+  // Gives the key (as an ouptput parameter) immediately after the
+  // given key according to ascending sort order. Returns true if a
+  // successor key exists, and false otherwise.
+  bool next_key(const K& key, K& next_key) const;
+
+  // Gives the key (as an ouptput parameter) immediately before the
+  // given key according to ascending sort order. Returns true if a
+  // predecessor key exists, and false otherwise.
+  bool prev_key(const K& key, K& prev_key) const;
+
+  // Removes all key-value pairs from the map. Any rebuild in progress
+  // is discarded.
+  void clear();
+
+  // Returns the representation currently in use
+  Representation representation() const;
+
+  // Blocks until a rebuild in progress (if any) has finished and the
+  // map has swapped over to it. Like a non-const operation, it ends
+  // the use of references from the non-const operator[] and find.
+  void wait_for_rebuild() const;
+
+private:
+
+  // kinds of operations that are sampled
+  enum OpKind { POINT, RANGE, WRITE };
+
+  // number of operations per sampling window
+  int sample_window;
+
+  // fraction of range queries that makes a workload range-heavy
+  double range_threshold;
+
+  // The representation, counters, and rebuild state are not part of
+  // the logical contents of the map, so const operations may update
+  // them. The map pointer and counters are atomic since concurrent
+  // readers use them, and the rebuild state is guarded by
+  // rebuild_lock for the reader that closes a sampling window or
+  // swaps in a rebuild.
+
+  // the map currently holding the pairs and its representation
+  mutable std::atomic<Map<K,V>*> current{nullptr};
+  mutable std::atomic<Representation> rep{TREE};
+
+  // operation counts for the current sampling window
+  mutable std::atomic<int> point_ops{0};
+  mutable std::atomic<int> range_ops{0};
+  mutable std::atomic<int> write_ops{0};
+  mutable std::atomic<int> window_ops{0};
+
+  // held while a sampling window is closed or a rebuild swapped in
+  mutable std::mutex rebuild_lock;
+
+  // choice made at the end of the previous window, a rebuild only
+  // starts when two windows in a row agree
+  mutable Representation last_choice = TREE;
+
+  // rebuild running in the background and its representation
+  mutable std::future<Map<K,V>*> pending;
+  mutable Representation pending_rep = TREE;
+
+  // ready once the rebuild thread has copied the pairs, writers wait
+  // for it before changing the map
+  mutable std::future<void> snapshot;
+
+  // set by the rebuild thread once the new map is built
+  mutable std::atomic<bool> rebuild_ready{false};
+
+  // keys that may have changed since the rebuild's snapshot: keys
+  // written while a rebuild is in progress, and keys handed out by
+  // the non-const operator[] and find
+  mutable ArraySeq<K> dirty;
+
+  // true while a reference from the non-const operator[] or find may
+  // be in use, that is until the next non-const operation
+  bool refs_out = false;
+
+  // maps swapped out by const operations, kept until the next
+  // non-const operation since readers may still be using them
+  mutable ArraySeq<Map<K,V>*> retired;
+
+  // returns the map currently holding the pairs
+  Map<K,V>* live() const;
+
+  // ends the use of earlier references, counts a write, and waits for
+  // a rebuild's snapshot. Called first by every non-const operation.
+  void begin_write();
+
+  // swaps in a finished rebuild, counts the operation, and closes the
+  // sampling window when it is the window's last operation
+  void sample(OpKind kind) const;
+
+  // swaps in the rebuilt map if it is ready and no reference from the
+  // non-const operator[] or find may be in use
+  void install_if_ready() const;
+
+  // picks the representation for the window just ended and starts a
+  // rebuild when two windows in a row agree on a new one
+  void end_window() const;
+
+  // remembers a written key while a rebuild is in progress
+  void record(const K& key);
+
+  // remembers a key handed out by the non-const operator[] or find,
+  // whose value may be written after the next snapshot
+  void hand_out(const K& key);
+
+  // representation that suits the counts of the last window
+  Representation choose() const;
+
+  // starts a background thread that snapshots the pairs and builds
+  // the new representation
+  void start_rebuild(Representation new_rep) const;
+
+  // replays the dirty keys into the rebuilt map and swaps it in,
+  // retiring the old map. Needs rebuild_lock or no other users.
+  void finish_rebuild() const;
+
+  // waits for and throws away a rebuild in progress
+  void cancel_rebuild();
+
+  // deletes the retired maps
+  void release_retired();
+
+  // creates an empty map of the given representation
+  static Map<K,V>* make_map(Representation new_rep);
+
+  // creates a copy of the given map of the given representation
+  static Map<K,V>* copy_map(const Map<K,V>* src, Representation src_rep);
+
+};
+
+
+template<typename K, typename V>
+WorkloadMap<K,V>::WorkloadMap(int sample_window, double range_threshold)
+  : sample_window(sample_window), range_threshold(range_threshold)
+{
+  current = make_map(rep);
+}
+
+//initalizes the copy constructor
+template<typename K, typename V>
+WorkloadMap<K,V>::WorkloadMap(const WorkloadMap& rhs)
+{
+  *this = rhs;
+}
+
+//initalizes the move constructor
+template<typename K, typename V>
+WorkloadMap<K,V>::WorkloadMap(WorkloadMap&& rhs)
+{
+  *this = std::move(rhs);
+}
+
+//initalizes the copy assignment by copying the map in use (a rebuild
+//in progress on rhs is not copied)
+template<typename K, typename V>
+WorkloadMap<K,V>& WorkloadMap<K,V>::operator=(const WorkloadMap& rhs)
+{
+  if(this != &rhs){
+    cancel_rebuild();
+    release_retired();
+    delete live();
+    sample_window = rhs.sample_window;
+    range_threshold = rhs.range_threshold;
+    rep = rhs.rep.load();
+    last_choice = rhs.rep;
+    current = copy_map(rhs.live(), rhs.rep);
+    point_ops = range_ops = write_ops = window_ops = 0;
+    refs_out = false;
+  }
+  return *this;
+}
+
+//initalizes the move assignment
+template<typename K, typename V>
+WorkloadMap<K,V>& WorkloadMap<K,V>::operator=(WorkloadMap&& rhs)
+{
+  if(this != &rhs){
+    cancel_rebuild();
+    release_retired();
+    rhs.wait_for_rebuild();
+    rhs.release_retired();
+    delete live();
+    sample_window = rhs.sample_window;
+    range_threshold = rhs.range_threshold;
+    rep = rhs.rep.load();
+    last_choice = rhs.last_choice;
+    current = rhs.live();
+    point_ops = rhs.point_ops.load();
+    range_ops = rhs.range_ops.load();
+    write_ops = rhs.write_ops.load();
+    window_ops = rhs.window_ops.load();
+    rhs.rep = TREE;
+    rhs.last_choice = TREE;
+    rhs.current = make_map(TREE);
+    rhs.point_ops = rhs.range_ops = rhs.write_ops = rhs.window_ops = 0;
+    refs_out = false;
+    rhs.refs_out = false;
+  }
+  return *this;
+}
+
+//initalizes the destructor
+template<typename K, typename V>
+WorkloadMap<K,V>::~WorkloadMap()
+{
+  cancel_rebuild();
+  release_retired();
+  delete live();
+}
+
+//returns the number of pairs in the map
+template<typename K, typename V>
+int WorkloadMap<K,V>::size() const
+{
+  return live() -> size();
+}
+
+//returns true if the map is empty, false if not
+template<typename K, typename V>
+bool WorkloadMap<K,V>::empty() const
+{
+  return live() -> empty();
+}
+
+//given a valid key, returns the corrisponding key value. Counted as
+//a write since the value may be updated through the reference, and
+//the key is kept dirty while the reference may be in use.
+template<typename K, typename V>
+V& WorkloadMap<K,V>::operator[](const K& key)
+{
+  begin_write();
+  hand_out(key);
+  return (*live())[key];
+}
+
+//given a valid key, returns the corrisponding key value as a constant
+template<typename K, typename V>
+const V& WorkloadMap<K,V>::operator[](const K& key) const
+{
+  sample(POINT);
+  return (*live())[key];
+}
+
+//inserts the given key, value pair
+template<typename K, typename V>
+void WorkloadMap<K,V>::insert(const K& key, const V& value)
+{
+  begin_write();
+  live() -> insert(key, value);
+  record(key);
+}
+
+//moves the given key, value pair in. The key is recorded first since
+//it is moved from.
+template<typename K, typename V>
+void WorkloadMap<K,V>::insert(K&& key, V&& value)
+{
+  begin_write();
+  record(key);
+  live() -> insert(std::move(key), std::move(value));
+}
+
+//constructs the value in place in the concrete map for the current
+//representation. The key is built first so it can be recorded.
+template<typename K, typename V>
+template<typename KeyArg, typename... Args>
+void WorkloadMap<K,V>::emplace(KeyArg&& key, Args&&... args)
+{
+  begin_write();
+  K new_key(std::forward<KeyArg>(key));
+  record(new_key);
+  if(rep == HASH){
+    static_cast<HashMap<K,V>*>(live()) -> emplace(std::move(new_key), std::forward<Args>(args)...);
+  } else if(rep == SORTED){
+    static_cast<BinSearchMap<K,V>*>(live()) -> emplace(std::move(new_key), std::forward<Args>(args)...);
+  } else {
+    static_cast<AVLMap<K,V>*>(live()) -> emplace(std::move(new_key), std::forward<Args>(args)...);
+  }
+}
+
+//removes the given key and corrisponding value pair
+template<typename K, typename V>
+void WorkloadMap<K,V>::erase(const K& key)
+{
+  begin_write();
+  live() -> erase(key);
+  record(key);
+}
+
+//returns true if given key is in the map, false if not
+template<typename K, typename V>
+bool WorkloadMap<K,V>::contains(const K& key) const
+{
+  sample(POINT);
+  return live() -> contains(key);
+}
+
+//returns a pointer to the value of the key, or nullptr if not in the
+//map. Counted as a write since the value may be updated through it,
+//and the key is kept dirty while the pointer may be in use.
+template<typename K, typename V>
+V* WorkloadMap<K,V>::find(const K& key)
+{
+  begin_write();
+  hand_out(key);
+  return live() -> find(key);
+}
+
+//returns a constant pointer to the value of the key, or nullptr if
+//not in the map
+template<typename K, typename V>
+const V* WorkloadMap<K,V>::find(const K& key) const
+{
+  sample(POINT);
+  return live() -> find(key);
+}
+
+//sets the value of the key, adding the pair if the key is new
+template<typename K, typename V>
+bool WorkloadMap<K,V>::insert_or_assign(const K& key, const V& value)
+{
+  begin_write();
+  bool added = live() -> insert_or_assign(key, value);
+  record(key);
+  return added;
+}
+
+//adds the pair if the key is new
+template<typename K, typename V>
+bool WorkloadMap<K,V>::try_emplace(const K& key, const V& value)
+{
+  begin_write();
+  bool added = live() -> try_emplace(key, value);
+  record(key);
+  return added;
+}
+
+//removes the pair of the given key if there is one
+template<typename K, typename V>
+bool WorkloadMap<K,V>::try_erase(const K& key)
+{
+  begin_write();
+  bool removed = live() -> try_erase(key);
+  record(key);
+  return removed;
+}
+
+//returns an ArraySeq of key values that are between k1 and k2
+template<typename K, typename V>
+ArraySeq<K> WorkloadMap<K,V>::find_keys(const K& k1, const K& k2) const
+{
+  sample(RANGE);
+  return live() -> find_keys(k1, k2);
+}
+
+//adds the key values that are between k1 and k2 to the given sequence
+template<typename K, typename V>
+void WorkloadMap<K,V>::find_keys(const K& k1, const K& k2, Sequence<K>& keys) const
+{
+  sample(RANGE);
+  live() -> find_keys(k1, k2, keys);
+}
+
+//returns an array seq of all of the keys in sorted order
+template<typename K, typename V>
+ArraySeq<K> WorkloadMap<K,V>::sorted_keys() const
+{
+  sample(RANGE);
+  return live() -> sorted_keys();
+}
+
+//returns the next key value in the map
+template<typename K, typename V>
+bool WorkloadMap<K,V>::next_key(const K& key, K& next_key) const
+{
+  sample(RANGE);
+  return live() -> next_key(key, next_key);
+}
+
+//returns the previous key value in the map
+template<typename K, typename V>
+bool WorkloadMap<K,V>::prev_key(const K& key, K& prev_key) const
+{
+  sample(RANGE);
+  return live() -> prev_key(key, prev_key);
+}
+
+//deletes all of the pairs in the map
+template<typename K, typename V>
+void WorkloadMap<K,V>::clear()
+{
+  cancel_rebuild();
+  release_retired();
+  refs_out = false;
+  live() -> clear();
+}
+
+//returns the representation currently in use
+template<typename K, typename V>
+typename WorkloadMap<K,V>::Representation WorkloadMap<K,V>::representation() const
+{
+  return rep;
+}
+
+//waits for the background rebuild and swaps it in
+template<typename K, typename V>
+void WorkloadMap<K,V>::wait_for_rebuild() const
+{
+  std::lock_guard<std::mutex> lock(rebuild_lock);
+  if(pending.valid()){
+    pending.wait();
+    finish_rebuild();
+  }
+}
+
+//returns the map currently holding the pairs
+template<typename K, typename V>
+Map<K,V>* WorkloadMap<K,V>::live() const
+{
+  return current.load(std::memory_order_acquire);
+}
+
+//references from earlier operations are no longer in use, so maps
+//swapped out since can be freed. A write must not start before the
+//rebuild thread has copied the pairs. With no rebuild in progress,
+//the next snapshot will see every earlier write, so no key is dirty.
+template<typename K, typename V>
+void WorkloadMap<K,V>::begin_write()
+{
+  refs_out = false;
+  sample(WRITE);
+  release_retired();
+  if(pending.valid()){
+    snapshot.wait();
+  } else {
+    dirty.clear();
+  }
+}
+
+//swaps in a finished rebuild, then counts the operation. Exactly one
+//caller sees the window count reach sample_window, and it
+//re-evaluates the representation.
+template<typename K, typename V>
+void WorkloadMap<K,V>::sample(OpKind kind) const
+{
+  install_if_ready();
+  if(kind == POINT){
+    point_ops.fetch_add(1, std::memory_order_relaxed);
+  } else if(kind == RANGE){
+    range_ops.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    write_ops.fetch_add(1, std::memory_order_relaxed);
+  }
+  if(window_ops.fetch_add(1, std::memory_order_relaxed) + 1 == sample_window){
+    end_window();
+  }
+}
+
+//the flag is checked without the lock so an operation with nothing
+//to swap in only pays for one atomic load
+template<typename K, typename V>
+void WorkloadMap<K,V>::install_if_ready() const
+{
+  if(refs_out || !rebuild_ready.load(std::memory_order_acquire)){
+    return;
+  }
+  std::lock_guard<std::mutex> lock(rebuild_lock);
+  if(rebuild_ready.load(std::memory_order_acquire)){
+    finish_rebuild();
+  }
+}
+
+//chooses a representation for the window and resets the counts.
+//Starting a rebuild only launches its thread.
+template<typename K, typename V>
+void WorkloadMap<K,V>::end_window() const
+{
+  std::lock_guard<std::mutex> lock(rebuild_lock);
+  Representation choice = choose();
+  if(choice != rep && choice == last_choice && !pending.valid()){
+    start_rebuild(choice);
+  }
+  last_choice = choice;
+  point_ops = range_ops = write_ops = 0;
+  window_ops = 0;
+}
+
+//remembers the key if a rebuild has been snapshotted without it
+template<typename K, typename V>
+void WorkloadMap<K,V>::record(const K& key)
+{
+  if(pending.valid()){
+    dirty.push_back(key);
+  }
+}
+
+//remembers the key whatever the rebuild state, since a rebuild may
+//start and take its snapshot before the value is written
+template<typename K, typename V>
+void WorkloadMap<K,V>::hand_out(const K& key)
+{
+  dirty.push_back(key);
+  refs_out = true;
+}
+
+//read-only with range queries -> sorted array, range-heavy -> tree,
+//everything else -> hash table
+template<typename K, typename V>
+typename WorkloadMap<K,V>::Representation WorkloadMap<K,V>::choose() const
+{
+  int total = point_ops + range_ops + write_ops;
+  if(write_ops == 0 && range_ops > 0){
+    return SORTED;
+  }
+  if(range_ops >= range_threshold * total){
+    return TREE;
+  }
+  return HASH;
+}
+
+//launches the rebuild thread. It copies the pairs in one walk over
+//the current map (O(n), in key order unless it is a hash table),
+//signals the snapshot, then sorts a hash table's pairs so a sorted
+//array is built by appends, and builds the new map from its copies.
+template<typename K, typename V>
+void WorkloadMap<K,V>::start_rebuild(Representation new_rep) const
+{
+  std::promise<void> copied;
+  snapshot = copied.get_future();
+  rebuild_ready = false;
+  pending_rep = new_rep;
+  pending = std::async(std::launch::async,
+    [src = live(), src_rep = rep.load(), new_rep, copied = std::move(copied),
+     ready = &rebuild_ready]() mutable {
+      ArraySeq<K> keys;
+      ArraySeq<V> values;
+      keys.reserve(src -> size());
+      values.reserve(src -> size());
+      auto copy_pair = [&keys, &values](const K& key, const V& value) {
+        keys.push_back(key);
+        values.push_back(value);
+      };
+      if(src_rep == HASH){
+        static_cast<const HashMap<K,V>*>(src) -> for_each(copy_pair);
+      } else if(src_rep == SORTED){
+        static_cast<const BinSearchMap<K,V>*>(src) -> for_each(copy_pair);
+      } else {
+        static_cast<const AVLMap<K,V>*>(src) -> for_each(copy_pair);
+      }
+      copied.set_value();
+      ArraySeq<int> order;
+      order.reserve(keys.size());
+      for(int i = 0; i < keys.size(); i++){
+        order.push_back(i);
+      }
+      if(src_rep == HASH){
+        std::sort(order.data(), order.data() + order.size(),
+                  [&keys](int a, int b) { return keys[a] < keys[b]; });
+      }
+      Map<K,V>* next = make_map(new_rep);
+      for(int i = 0; i < order.size(); i++){
+        next -> insert(std::move(keys[order[i]]), std::move(values[order[i]]));
+      }
+      ready -> store(true, std::memory_order_release);
+      return next;
+    });
+}
+
+//brings each dirty key up to date in the rebuilt map and replaces
+//the current map with it. The old map is retired rather than deleted
+//since other readers may still be in it.
+template<typename K, typename V>
+void WorkloadMap<K,V>::finish_rebuild() const
+{
+  Map<K,V>* next = pending.get();
+  Map<K,V>* old = live();
+  for(int i = 0; i < dirty.size(); i++){
+    const K& key = dirty[i];
+    const V* value = old -> find(key);
+    if(value){
+      next -> insert_or_assign(key, *value);
+    } else {
+      next -> try_erase(key);
+    }
+  }
+  dirty.clear();
+  rebuild_ready = false;
+  retired.push_back(old);
+  rep = pending_rep;
+  current.store(next, std::memory_order_release);
+}
+
+//waits for a rebuild in progress and deletes its result
+template<typename K, typename V>
+void WorkloadMap<K,V>::cancel_rebuild()
+{
+  if(pending.valid()){
+    delete pending.get();
+  }
+  rebuild_ready = false;
+  dirty.clear();
+}
+
+//deletes the maps swapped out by const operations
+template<typename K, typename V>
+void WorkloadMap<K,V>::release_retired()
+{
+  for(int i = 0; i < retired.size(); i++){
+    delete retired[i];
+  }
+  retired.clear();
+}
+
+//returns a new empty map for the representation
+template<typename K, typename V>
+Map<K,V>* WorkloadMap<K,V>::make_map(Representation new_rep)
+{
+  if(new_rep == HASH){
+    return new HashMap<K,V>;
+  } else if(new_rep == SORTED){
+    return new BinSearchMap<K,V>;
+  }
+  return new AVLMap<K,V>;
+}
+
+//returns a copy of src using its concrete type
+template<typename K, typename V>
+Map<K,V>* WorkloadMap<K,V>::copy_map(const Map<K,V>* src, Representation src_rep)
+{
+  if(src_rep == HASH){
+    return new HashMap<K,V>(*static_cast<const HashMap<K,V>*>(src));
+  } else if(src_rep == SORTED){
+    return new BinSearchMap<K,V>(*static_cast<const BinSearchMap<K,V>*>(src));
+  }
+  return new AVLMap<K,V>(*static_cast<const AVLMap<K,V>*>(src));
+}
+
+#endif